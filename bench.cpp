@@ -0,0 +1,375 @@
+//
+// Created by alberto on 14/10/26.
+//
+
+// Microbenchmarks of the hot paths of the library.
+//
+// Usage: as_bench [--min-time sec] [--sizes n,n,...] [--subset-sizes k,k,...] [--filter text]
+//                 [--baseline results.json] [--tolerance fraction]
+//
+// Each benchmark runs on random instances and graphs with the given numbers of
+// vertices (default: 100, 500, 2000), generated with a fixed seed; subset
+// enumeration runs on sets of the given subset sizes (default: 10, 16, 20).
+// Only benchmarks whose name contains the filter text are run. Each benchmark
+// is repeated in batches until a batch takes at least a fifth of the minimum
+// time; the median of five such batches is reported. Results are printed to
+// stdout as json. Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+//
+// With a baseline, i.e. the json output of a previous run, each benchmark is
+// compared with the baseline one with the same name and size: if it is slower
+// by more than the tolerance (default: 0.25, i.e. 25%), the program reports it
+// on stderr and exits with status 1. Benchmarks missing from the baseline are
+// not compared. Invalid options make it exit with status 2.
+
+#include "src/tsplib.h"
+#include "src/tsp.h"
+#include "src/discorde.h"
+#include "src/random.h"
+#include "src/graph.h"
+#include "src/combinatorial.h"
+
+#include "bench_instance.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+namespace {
+    using namespace as;
+    using boost::property_tree::ptree;
+    using Graph = boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS>;
+
+    constexpr std::mt19937::result_type seed = 20261014u;
+
+    struct Options {
+        double min_time_sec = 1.0;
+        std::vector<std::size_t> sizes = {100u, 500u, 2000u};
+        std::vector<std::size_t> subset_sizes = {10u, 16u, 20u};
+        std::string filter;
+        std::string baseline;
+        double tolerance = 0.25;
+    };
+
+    // Keeps the compiler from optimising away a value which is never used.
+    template<class T>
+    inline void keep(const T& value) {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    // Times op, which performs one operation on items_per_op items, and adds
+    // the result to results as a json object.
+    template<class Operation>
+    void measure(ptree& results, const Options& options, const std::string& name, std::size_t size, double items_per_op, Operation&& op) {
+        if(name.find(options.filter) == std::string::npos) { return; }
+
+        using Clock = std::chrono::steady_clock;
+
+        auto time_batch = [&] (std::uint64_t n_ops) {
+            const auto start = Clock::now();
+            for(std::uint64_t i = 0u; i < n_ops; ++i) { op(); }
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+
+        // Warm up, and find a batch size which takes long enough to time reliably.
+        std::uint64_t batch = 1u;
+
+        while(time_batch(batch) < options.min_time_sec / 5.0 && batch < (std::uint64_t{1u} << 40u)) {
+            batch *= 2u;
+        }
+
+        std::vector<double> ns_per_op(5u);
+
+        for(auto& sample : ns_per_op) {
+            sample = 1e9 * time_batch(batch) / static_cast<double>(batch);
+        }
+
+        std::sort(ns_per_op.begin(), ns_per_op.end());
+        const auto median = ns_per_op[ns_per_op.size() / 2u];
+
+        ptree pt;
+        pt.put("name", name);
+        pt.put("size", size);
+        pt.put("ops_per_batch", batch);
+        pt.put("ns_per_op", median);
+        pt.put("ns_per_op_min", ns_per_op.front());
+        pt.put("ns_per_op_max", ns_per_op.back());
+        pt.put("ops_per_sec", 1e9 / median);
+        pt.put("ns_per_item", median / items_per_op);
+        results.push_back(std::make_pair("", pt));
+
+        std::cerr << name << " (" << size << "): " << median << " ns/op\n";
+    }
+
+    // A G(n, p) random graph, with average degree about 10.
+    Graph random_graph(std::size_t n_vertices) {
+        std::mt19937 mt{seed};
+        std::bernoulli_distribution has_edge{std::min(1.0, 10.0 / static_cast<double>(n_vertices))};
+        Graph graph{n_vertices};
+
+        for(auto i = 0u; i < n_vertices; ++i) {
+            for(auto j = i + 1u; j < n_vertices; ++j) {
+                if(has_edge(mt)) { boost::add_edge(i, j, graph); }
+            }
+        }
+
+        return graph;
+    }
+
+    std::vector<std::uint32_t> random_subset(std::size_t n_vertices, std::size_t how_many, std::mt19937& mt) {
+        std::vector<std::uint32_t> nodes(n_vertices);
+        std::iota(nodes.begin(), nodes.end(), 0u);
+        std::shuffle(nodes.begin(), nodes.end(), mt);
+        nodes.resize(how_many);
+        return nodes;
+    }
+
+    void bench_tsplib(ptree& results, const Options& options, std::size_t n) {
+        const bench::RandomInstanceFile random_file{"as_bench", n, seed};
+        const auto file = random_file.file.string();
+
+        measure(results, options, "tsplib/construct", n, static_cast<double>(n * n), [&] () {
+            const tsplib::TSPInstance instance{file};
+            keep(instance);
+        });
+
+        const tsplib::TSPInstance instance{file};
+        std::mt19937 mt{seed};
+        std::uniform_int_distribution<std::size_t> vertex{0u, n - 1u};
+        std::vector<std::pair<std::size_t, std::size_t>> pairs(4096u);
+
+        for(auto& pair : pairs) { pair = {vertex(mt), vertex(mt)}; }
+
+        measure(results, options, "tsplib/get_distance", n, static_cast<double>(pairs.size()), [&] () {
+            float total = 0.0f;
+            for(const auto& [v, w] : pairs) { total += instance.get_distance(v, w); }
+            keep(total);
+        });
+
+        measure(results, options, "tsplib/get_distance_unchecked", n, static_cast<double>(pairs.size()), [&] () {
+            float total = 0.0f;
+            for(const auto& [v, w] : pairs) { total += instance.get_distance_unchecked(v, w); }
+            keep(total);
+        });
+
+        const auto tour = random_subset(n, n, mt);
+
+        measure(results, options, "tsp/tour_cost", n, static_cast<double>(n), [&] () {
+            keep(tsp::tour_cost(instance, tour));
+        });
+
+        // What discorde_solve_tsp does before calling Concorde, on all nodes (which reads
+        // whole rows of distances) and on a random half of them.
+        std::vector<std::uint32_t> all_nodes(n);
+        std::iota(all_nodes.begin(), all_nodes.end(), 0u);
+        const auto half = random_subset(n, n / 2u, mt);
+        tsp::detail::DiscordeScratch scratch;
+
+        measure(results, options, "discorde/fill_costs_all", n, static_cast<double>(n * n), [&] () {
+            tsp::detail::fill_discorde_costs(instance, all_nodes, scratch);
+            keep(scratch.costs);
+        });
+
+        measure(results, options, "discorde/fill_costs_half", n, static_cast<double>(half.size() * half.size()), [&] () {
+            tsp::detail::fill_discorde_costs(instance, half, scratch);
+            keep(scratch.costs);
+        });
+    }
+
+    void bench_random(ptree& results, const Options& options, std::size_t n) {
+        std::mt19937 mt{seed};
+        std::uniform_real_distribution<float> weight{0.0f, 1.0f};
+        std::vector<float> weights(n);
+
+        for(auto& w : weights) { w = weight(mt); }
+
+        measure(results, options, "rnd/roulette_wheel", n, static_cast<double>(n), [&] () {
+            keep(rnd::roulette_wheel(weights, mt));
+        });
+
+        std::vector<std::size_t> population(n);
+        std::iota(population.begin(), population.end(), 0u);
+
+        const auto how_many = std::max<std::size_t>(1u, n / 10u);
+
+        measure(results, options, "rnd/sample", n, static_cast<double>(how_many), [&] () {
+            keep(rnd::sample(population, how_many, mt));
+        });
+    }
+
+    void bench_graph(ptree& results, const Options& options, std::size_t n) {
+        const auto graph = random_graph(n);
+        const auto n_edges = static_cast<double>(boost::num_edges(graph));
+
+        measure(results, options, "graph/complementary", n, static_cast<double>(n * (n - 1u) / 2u), [&] () {
+            keep(graph::complementary(graph));
+        });
+
+        measure(results, options, "graph/acyclic_orientation", n, n_edges, [&] () {
+            keep(graph::acyclic_orientation(graph));
+        });
+
+        std::mt19937 mt{seed};
+        const auto subset = random_subset(n, n / 2u, mt);
+        const std::vector<Graph::vertex_descriptor> vertices(subset.begin(), subset.end());
+
+        measure(results, options, "graph/vertex_complement", n, static_cast<double>(n), [&] () {
+            keep(graph::vertex_complement(vertices, graph));
+        });
+    }
+
+    void bench_subsets(ptree& results, const Options& options, std::size_t k) {
+        const auto n_subsets = static_cast<double>(std::uint64_t{1u} << k);
+
+        measure(results, options, "combi/visit_subsets", k, n_subsets, [&] () {
+            std::size_t count = 0u;
+            auto visitor = [&] (const std::vector<bool>& indicator) { count += indicator[0u]; };
+            combi::visit_subsets(k, &visitor);
+            keep(count);
+        });
+
+        measure(results, options, "combi/visit_subsets_gray", k, n_subsets, [&] () {
+            std::uint64_t count = 0u;
+            auto visitor = [&] (std::uint64_t mask, std::size_t) { count += mask & 1u; };
+            combi::visit_subsets_gray(k, &visitor);
+            keep(count);
+        });
+    }
+
+    std::vector<std::size_t> parse_sizes(const std::string& list) {
+        std::vector<std::size_t> sizes;
+        std::stringstream ss{list};
+        std::string item;
+
+        while(std::getline(ss, item, ',')) {
+            sizes.push_back(std::stoul(item));
+        }
+
+        return sizes;
+    }
+
+    Options parse_options(int argc, char** argv) {
+        Options options;
+
+        for(auto i = 1; i < argc; i += 2) {
+            const std::string flag = argv[i];
+
+            if(i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for option: " + flag);
+            }
+
+            const std::string value = argv[i + 1];
+
+            if(flag == "--min-time") {
+                options.min_time_sec = std::stod(value);
+            } else if(flag == "--sizes") {
+                options.sizes = parse_sizes(value);
+            } else if(flag == "--subset-sizes") {
+                options.subset_sizes = parse_sizes(value);
+            } else if(flag == "--filter") {
+                options.filter = value;
+            } else if(flag == "--baseline") {
+                options.baseline = value;
+            } else if(flag == "--tolerance") {
+                options.tolerance = std::stod(value);
+            } else {
+                throw std::invalid_argument("Unknown option: " + flag);
+            }
+        }
+
+        if(std::any_of(options.sizes.begin(), options.sizes.end(), [] (std::size_t n) { return n < 2u; })) {
+            throw std::invalid_argument("Sizes must be at least 2");
+        }
+
+        if(std::any_of(options.subset_sizes.begin(), options.subset_sizes.end(), [] (std::size_t k) { return k < 1u || k > 30u; })) {
+            throw std::invalid_argument("Subset sizes must be between 1 and 30");
+        }
+
+        if(options.tolerance < 0.0) {
+            throw std::invalid_argument("The tolerance must be non-negative");
+        }
+
+        return options;
+    }
+
+    // Compares the benchmarks with those of the baseline file, and gives
+    // the number of benchmarks slower than the baseline beyond the tolerance.
+    std::size_t count_regressions(const ptree& benchmarks, const Options& options) {
+        ptree baseline;
+        boost::property_tree::read_json(options.baseline, baseline);
+
+        std::map<std::pair<std::string, std::size_t>, double> baseline_ns;
+
+        for(const auto& [key, pt] : baseline.get_child("benchmarks")) {
+            baseline_ns[{pt.get<std::string>("name"), pt.get<std::size_t>("size")}] = pt.get<double>("ns_per_op");
+        }
+
+        std::size_t n_regressions = 0u;
+
+        for(const auto& [key, pt] : benchmarks) {
+            const auto name = pt.get<std::string>("name");
+            const auto size = pt.get<std::size_t>("size");
+            const auto it = baseline_ns.find({name, size});
+
+            if(it == baseline_ns.end()) {
+                std::cerr << name << " (" << size << "): not in the baseline\n";
+                continue;
+            }
+
+            const auto ns = pt.get<double>("ns_per_op");
+
+            if(ns > it->second * (1.0 + options.tolerance)) {
+                std::cerr << "Regression: " << name << " (" << size << "): " << ns << " ns/op, baseline " << it->second << " ns/op\n";
+                ++n_regressions;
+            }
+        }
+
+        return n_regressions;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+
+    try {
+        options = parse_options(argc, argv);
+    } catch(const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 2;
+    }
+
+    ptree benchmarks;
+
+    for(const auto n : options.sizes) {
+        bench_tsplib(benchmarks, options, n);
+        bench_random(benchmarks, options, n);
+        bench_graph(benchmarks, options, n);
+    }
+
+    for(const auto k : options.subset_sizes) {
+        bench_subsets(benchmarks, options, k);
+    }
+
+    ptree results;
+    results.put("min_time_sec", options.min_time_sec);
+    results.put("seed", seed);
+    results.add_child("benchmarks", benchmarks);
+    boost::property_tree::write_json(std::cout, results);
+
+    if(!options.baseline.empty() && count_regressions(benchmarks, options) > 0u) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,461 @@
+//
+// Created by alberto on 14/10/26.
+//
+
+// Throughput benchmark for the ALNS solver, on TSP instances.
+//
+// Usage: as_bench_alns [iterations [instance.tsp[=reference_cost] ...]]
+//
+// Without instance files, it runs on ../test/tsplib/pr10.tsp and on two random
+// EUC_2D instances, generated with a fixed seed in the temporary directory. All
+// runs use fixed seeds too. Results are printed to stdout as json. Build with
+// -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+//
+// Gaps, and the times to reach them, are relative to a reference cost per
+// instance, which does not depend on the ALNS runs: the one given after the
+// file name if any, otherwise the optimum (Held-Karp) for small instances, and
+// the cost of the deterministic 2-opt/Or-opt local search tour for larger ones.
+
+#include "src/alns.h"
+#include "src/alns_acceptance.h"
+#include "src/alns_parallel.h"
+#include "src/tsplib.h"
+#include "src/tsp_heuristic.h"
+
+#include "bench_instance.h"
+
+#include <new>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+namespace {
+    std::atomic<std::uint64_t> n_allocations{0u};
+}
+
+// Count all heap allocations, to measure allocations per iteration. All forms of
+// operator new and delete are replaced, so that every pointer is released by the
+// same allocator which returned it. The deallocation functions are not inlined:
+// GCC would otherwise see, at the call sites, std::free called on pointers from
+// operator new, and wrongly warn about mismatched allocation functions.
+namespace {
+    void* counted_malloc(std::size_t size) {
+        ++n_allocations;
+        return std::malloc(size == 0u ? 1u : size);
+    }
+
+    void* counted_aligned_alloc(std::size_t size, std::align_val_t alignment) {
+        ++n_allocations;
+        const auto align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+        void* ptr = nullptr;
+        return posix_memalign(&ptr, align, size == 0u ? 1u : size) == 0 ? ptr : nullptr;
+    }
+
+    [[gnu::noinline]] void counted_free(void* ptr) noexcept { std::free(ptr); }
+}
+
+void* operator new(std::size_t size) {
+    if(void* ptr = counted_malloc(size)) { return ptr; }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) {
+    if(void* ptr = counted_malloc(size)) { return ptr; }
+    throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if(void* ptr = counted_aligned_alloc(size, alignment)) { return ptr; }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    if(void* ptr = counted_aligned_alloc(size, alignment)) { return ptr; }
+    throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+
+void operator delete(void* ptr) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { counted_free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr); }
+
+namespace {
+    using namespace as;
+    using boost::property_tree::ptree;
+
+    constexpr std::mt19937::result_type seed = 20261014u;
+
+    // A TSP tour, whose length is kept up to date by the destroy and repair methods.
+    struct Tour {
+        const tsplib::TSPInstance* instance;
+        std::vector<std::size_t> vertices;
+        std::vector<std::size_t> removed;
+        float length;
+
+        Tour(const tsplib::TSPInstance& instance) : instance{&instance}, length{0.0f} {
+            vertices.resize(instance.number_of_vertices());
+            std::iota(vertices.begin(), vertices.end(), 0u);
+
+            for(auto i = 0u; i < vertices.size(); ++i) {
+                length += distance(vertices[i], vertices[(i + 1u) % vertices.size()]);
+            }
+        }
+
+        float cost() const { return length; }
+
+        float distance(std::size_t v1, std::size_t v2) const {
+            return instance->get_distance_unchecked(v1, v2);
+        }
+
+        void remove(std::size_t position) {
+            const auto n = vertices.size();
+            const auto prev = vertices[(position + n - 1u) % n];
+            const auto vertex = vertices[position];
+            const auto next = vertices[(position + 1u) % n];
+
+            length += distance(prev, next) - distance(prev, vertex) - distance(vertex, next);
+            vertices.erase(vertices.begin() + position);
+            removed.push_back(vertex);
+        }
+
+        void insert(std::size_t position, std::size_t vertex) {
+            const auto n = vertices.size();
+            const auto prev = vertices[(position + n - 1u) % n];
+            const auto next = vertices[position % n];
+
+            length += distance(prev, vertex) + distance(vertex, next) - distance(prev, next);
+            vertices.insert(vertices.begin() + position, vertex);
+        }
+    };
+
+    struct RandomRemoval : alns::DestroyMethod<Tour> {
+        void operator()(Tour& tour) override {
+            std::mt19937 mt{seed};
+            (*this)(tour, mt);
+        }
+
+        void operator()(Tour& tour, std::mt19937& mt) override {
+            const auto n_remove = std::max<std::size_t>(1u, tour.vertices.size() / 10u);
+
+            for(auto i = 0u; i < n_remove && tour.vertices.size() > 3u; ++i) {
+                tour.remove(std::uniform_int_distribution<std::size_t>{0u, tour.vertices.size() - 1u}(mt));
+            }
+        }
+
+        bool is_thread_safe() const override { return true; }
+    };
+
+    struct SegmentRemoval : alns::DestroyMethod<Tour> {
+        void operator()(Tour& tour) override {
+            std::mt19937 mt{seed};
+            (*this)(tour, mt);
+        }
+
+        void operator()(Tour& tour, std::mt19937& mt) override {
+            const auto n_remove = std::max<std::size_t>(1u, tour.vertices.size() / 10u);
+            auto position = std::uniform_int_distribution<std::size_t>{0u, tour.vertices.size() - 1u}(mt);
+
+            for(auto i = 0u; i < n_remove && tour.vertices.size() > 3u; ++i) {
+                position %= tour.vertices.size();
+                tour.remove(position);
+            }
+        }
+
+        bool is_thread_safe() const override { return true; }
+    };
+
+    // Inserts the removed vertices, in random order, where they increase the length
+    // the least. As insertions never decrease the length of a tour on instances
+    // satisfying the triangle inequality, it gives up as soon as the length exceeds
+    // the bound given by the acceptance criterion.
+    struct CheapestInsertion : alns::RepairMethod<Tour> {
+        void operator()(Tour& tour) override {
+            std::mt19937 mt{seed};
+            (*this)(tour, mt);
+        }
+
+        void operator()(Tour& tour, std::mt19937& mt) override {
+            (*this)(tour, mt, std::numeric_limits<float>::infinity());
+        }
+
+        bool operator()(Tour& tour, std::mt19937& mt, float cost_bound) override {
+            std::shuffle(tour.removed.begin(), tour.removed.end(), mt);
+
+            while(!tour.removed.empty()) {
+                const auto vertex = tour.removed.back();
+                const auto n = tour.vertices.size();
+                auto best_position = 0u;
+                auto best_delta = std::numeric_limits<float>::max();
+
+                for(auto i = 0u; i < n; ++i) {
+                    const auto prev = tour.vertices[(i + n - 1u) % n];
+                    const auto next = tour.vertices[i];
+                    const auto delta = tour.distance(prev, vertex) + tour.distance(vertex, next) - tour.distance(prev, next);
+
+                    if(delta < best_delta) {
+                        best_delta = delta;
+                        best_position = i;
+                    }
+                }
+
+                tour.removed.pop_back();
+                tour.insert(best_position, vertex);
+
+                if(tour.length > cost_bound) {
+                    // The tour will be rejected: leave it in a consistent state and give up.
+                    tour.removed.clear();
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool is_thread_safe() const override { return true; }
+    };
+
+    // Records when the best solution improves, to compute the time to reach a given gap.
+    struct TrajectoryVisitor {
+        std::vector<std::pair<float, float>> trajectory; // (elapsed time, best cost)
+
+        bool on_iteration_end(alns::AlgorithmStatus<Tour>& status) {
+            if(trajectory.empty() || status.get_best_cost() < trajectory.back().second) {
+                trajectory.emplace_back(status.get_elapsed_time_sec(), status.get_best_cost());
+            }
+
+            return true;
+        }
+
+        float time_to_gap(float reference_cost, float gap) const {
+            for(const auto& point : trajectory) {
+                if(point.second <= reference_cost * (1.0f + gap)) {
+                    return point.first;
+                }
+            }
+
+            return -1.0f;
+        }
+    };
+
+    using Acceptance = alns::LinearRecordToRecordTravel<Tour>;
+    using Solver = alns::ALNSSolver<Tour, Acceptance, TrajectoryVisitor>;
+    using ParallelSolver = alns::ParallelALNSSolver<Tour, Acceptance, TrajectoryVisitor>;
+
+    Acceptance make_acceptance(std::uint32_t iterations) {
+        Acceptance acceptance;
+        acceptance.main_termination_criterion = alns::MainTerminationCriterion::ITERATIONS;
+        acceptance.iterations_limit = iterations;
+        acceptance.start_threshold = 0.05f;
+        acceptance.end_threshold = 0.0f;
+        return acceptance;
+    }
+
+    template<class AnySolver>
+    void add_methods(AnySolver& solver) {
+        solver.add_destroy_method(std::make_unique<RandomRemoval>());
+        solver.add_destroy_method(std::make_unique<SegmentRemoval>());
+        solver.add_repair_method(std::make_unique<CheapestInsertion>());
+    }
+
+    // A cost to measure gaps against, and how it was obtained.
+    struct Reference {
+        float cost;
+        std::string source;
+    };
+
+    float tour_length(const tsplib::TSPInstance& instance, const std::vector<std::uint32_t>& tour) {
+        float length = 0.0f;
+
+        for(auto i = 0u; i < tour.size(); ++i) {
+            length += instance.get_distance(tour[i], tour[(i + 1u) % tour.size()]);
+        }
+
+        return length;
+    }
+
+    Reference reference_for(const tsplib::TSPInstance& instance, std::optional<float> given_cost) {
+        if(given_cost) {
+            return {*given_cost, "given"};
+        }
+
+        std::vector<std::uint32_t> nodes(instance.number_of_vertices());
+        std::iota(nodes.begin(), nodes.end(), 0u);
+
+        if(nodes.size() <= tsp::held_karp_max_nodes) {
+            return {tour_length(instance, tsp::held_karp_solve_tsp(instance, nodes)), "optimal"};
+        }
+
+        return {tour_length(instance, tsp::local_search_solve_tsp(instance, nodes)), "local_search"};
+    }
+
+    float gap(float cost, const Reference& reference) {
+        return (cost - reference.cost) / reference.cost;
+    }
+
+    ptree run_serial(const tsplib::TSPInstance& instance, const alns::AlgorithmParams& params, std::uint32_t iterations, const Reference& reference) {
+        const Tour initial{instance};
+        Solver solver{params, initial};
+        solver.set_acceptance_criterion(make_acceptance(iterations));
+        solver.set_seed(seed);
+        add_methods(solver);
+
+        const auto allocations_before = n_allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+        solver.solve();
+        const auto wall_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const auto allocations = n_allocations.load() - allocations_before;
+
+        auto& status = solver.get_status();
+        const auto n_iterations = status.get_iteration_number();
+        const auto& visitor = solver.get_visitor();
+
+        ptree pt;
+        pt.put("iterations", n_iterations);
+        pt.put("wall_sec", wall_sec);
+        pt.put("iterations_per_sec", n_iterations / wall_sec);
+        pt.put("allocations_per_iteration", static_cast<double>(allocations) / n_iterations);
+        pt.put("initial_cost", initial.cost());
+        pt.put("best_cost", status.get_best_cost());
+        pt.put("gap", gap(status.get_best_cost(), reference));
+        pt.put("time_to_5pct_gap_sec", visitor.time_to_gap(reference.cost, 0.05f));
+        pt.put("time_to_1pct_gap_sec", visitor.time_to_gap(reference.cost, 0.01f));
+        return pt;
+    }
+
+    ptree run_islands(const tsplib::TSPInstance& instance, const alns::AlgorithmParams& params, std::uint32_t n_islands, std::uint32_t iterations, const Reference& reference) {
+        alns::ParallelAlgorithmParams parallel_params;
+        parallel_params.n_islands = n_islands;
+        parallel_params.migration_interval = std::max(1u, iterations / 20u);
+
+        ParallelSolver solver{params, parallel_params, Tour{instance}};
+        solver.set_acceptance_criterion(make_acceptance(iterations));
+        solver.add_destroy_method([] () { return std::make_unique<RandomRemoval>(); });
+        solver.add_destroy_method([] () { return std::make_unique<SegmentRemoval>(); });
+        solver.add_repair_method([] () { return std::make_unique<CheapestInsertion>(); });
+
+        solver.set_seed(seed);
+
+        const auto start = std::chrono::steady_clock::now();
+        solver.solve();
+        const auto wall_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::uint64_t n_iterations = 0u;
+
+        for(auto i = 0u; i < n_islands; ++i) {
+            n_iterations += solver.get_island_status(i).get_iteration_number();
+        }
+
+        ptree pt;
+        pt.put("threads", n_islands);
+        pt.put("iterations", n_iterations);
+        pt.put("wall_sec", wall_sec);
+        pt.put("iterations_per_sec", n_iterations / wall_sec);
+        pt.put("best_cost", solver.get_best_solution().cost());
+        pt.put("gap", gap(solver.get_best_solution().cost(), reference));
+        return pt;
+    }
+
+    std::vector<std::uint32_t> thread_counts() {
+        const auto max_threads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::uint32_t> counts;
+
+        for(auto threads = 1u; threads < max_threads; threads *= 2u) {
+            counts.push_back(threads);
+        }
+
+        counts.push_back(max_threads);
+        return counts;
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::uint32_t iterations = (argc > 1) ? static_cast<std::uint32_t>(std::stoul(argv[1])) : 5'000u;
+    std::vector<std::pair<std::string, std::optional<float>>> instance_files;
+
+    for(auto i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto equals = arg.rfind('=');
+
+        if(equals == std::string::npos) {
+            instance_files.emplace_back(arg, std::nullopt);
+        } else {
+            instance_files.emplace_back(arg.substr(0u, equals), std::stof(arg.substr(equals + 1u)));
+        }
+    }
+
+    std::list<bench::RandomInstanceFile> random_files;
+
+    if(instance_files.empty()) {
+        instance_files.emplace_back("../test/tsplib/pr10.tsp", std::nullopt);
+
+        for(const auto n_vertices : {200u, 500u}) {
+            random_files.emplace_back("as_bench_alns", n_vertices, seed);
+            instance_files.emplace_back(random_files.back().file.string(), std::nullopt);
+        }
+    }
+
+    ptree results;
+    results.put("iterations", iterations);
+    results.put("seed", seed);
+
+    ptree instances_pt;
+
+    for(const auto& [file, given_cost] : instance_files) {
+        const tsplib::TSPInstance instance{file};
+        const auto reference = reference_for(instance, given_cost);
+
+        alns::AlgorithmParams params;
+        params.max_iterations = iterations;
+
+        ptree instance_pt;
+        instance_pt.put("file", file);
+        instance_pt.put("vertices", instance.number_of_vertices());
+        instance_pt.put("reference_cost", reference.cost);
+        instance_pt.put("reference", reference.source);
+        instance_pt.add_child("serial", run_serial(instance, params, iterations, reference));
+
+        ptree batch_pt, islands_pt;
+
+        for(auto threads : thread_counts()) {
+            alns::AlgorithmParams batch_params = params;
+            batch_params.batch_size = 8u;
+            batch_params.batch_threads = threads;
+
+            auto run_pt = run_serial(instance, batch_params, iterations, reference);
+            run_pt.put("threads", threads);
+            run_pt.put("batch_size", batch_params.batch_size);
+            batch_pt.push_back(std::make_pair("", run_pt));
+            islands_pt.push_back(std::make_pair("", run_islands(instance, params, threads, iterations, reference)));
+        }
+
+        instance_pt.add_child("batched", batch_pt);
+        instance_pt.add_child("islands", islands_pt);
+        instances_pt.push_back(std::make_pair("", instance_pt));
+    }
+
+    results.add_child("instances", instances_pt);
+    boost::property_tree::write_json(std::cout, results);
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+//
+// Created by alberto on 14/10/26.
+//
+
+#ifndef AS_BENCH_INSTANCE_H
+#define AS_BENCH_INSTANCE_H
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+
+namespace bench {
+    /** @brief  A random EUC_2D TSP instance, written to a file in the temporary
+     *          directory, which is removed on destruction.
+     */
+    struct RandomInstanceFile {
+        /** @brief The path of the instance file.
+         */
+        std::filesystem::path file;
+
+        /** @brief              Writes the instance.
+         *
+         *  @param prefix       Prefix of the file name, e.g. the name of the benchmark.
+         *  @param n_vertices   Number of vertices, with coordinates between 0 and 10'000.
+         *  @param seed         Seed of the coordinates.
+         */
+        RandomInstanceFile(const std::string& prefix, std::size_t n_vertices, std::mt19937::result_type seed) :
+            file{std::filesystem::temp_directory_path() / (prefix + "_rand" + std::to_string(n_vertices) + ".tsp")}
+        {
+            std::ofstream ofs{file};
+            std::mt19937 mt{seed};
+            std::uniform_int_distribution<int> coordinate{0, 10'000};
+
+            ofs << "NAME : rand" << n_vertices << "\n";
+            ofs << "TYPE : TSP\n";
+            ofs << "DIMENSION : " << n_vertices << "\n";
+            ofs << "EDGE_WEIGHT_TYPE : EUC_2D\n";
+            ofs << "NODE_COORD_SECTION\n";
+
+            for(auto i = 0u; i < n_vertices; ++i) {
+                ofs << i + 1u << " " << coordinate(mt) << " " << coordinate(mt) << "\n";
+            }
+
+            ofs << "EOF\n";
+        }
+
+        RandomInstanceFile(const RandomInstanceFile&) = delete;
+        RandomInstanceFile& operator=(const RandomInstanceFile&) = delete;
+
+        ~RandomInstanceFile() {
+            std::error_code error;
+            std::filesystem::remove(file, error);
+        }
+    };
+}
+
+#endif //AS_BENCH_INSTANCE_H
@@ -10,11 +10,21 @@
 #include <string>
 #include <chrono>
 #include <memory>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <iterator>
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
 
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 
 #include "random.h"
+#include "thread_pool.h"
+#include "tmp.h"
 
 namespace as {
     /** @namespace  alns
@@ -22,6 +32,24 @@ namespace as {
      *              framework and related utilities.
      */
     namespace alns {
+        /** @brief  Tells which candidate solution is kept, at each iteration
+         *          of the batched mode (see \ref AlgorithmParams::batch_size).
+         */
+        enum class BatchSelection {
+            /**
+             * Only the candidate with the lowest cost is passed to the acceptance
+             * criterion.
+             */
+            BEST,
+
+            /**
+             * Candidates are passed to the acceptance criterion in the order in which
+             * their destroy and repair methods were drawn, and the first accepted
+             * candidate is kept.
+             */
+            FIRST_ACCEPTED
+        };
+
         /** @brief  General ALNS parameters.
          */
         struct AlgorithmParams {
@@ -50,20 +78,99 @@ namespace as {
              */
             float new_accepted_multiplier;
 
+            /**
+             * Number of (destroy, repair) pairs applied to the current solution at
+             * each iteration. If larger than 1, the resulting candidate solutions
+             * are produced concurrently on a thread pool.
+             */
+            std::uint32_t batch_size;
+
+            /**
+             * Which candidate is kept, in batched mode.
+             */
+            BatchSelection batch_selection;
+
+            /**
+             * Number of threads producing the candidates, in batched mode, including
+             * the thread running the solver. If 0, it uses the number of concurrent
+             * threads supported by the hardware.
+             */
+            std::uint32_t batch_threads;
+
+            /**
+             * If true, the solver collects per-method call counts, outcomes, and
+             * timings (see \ref AlgorithmStatistics).
+             */
+            bool collect_statistics;
+
+            /**
+             * When collecting statistics, the timings are only measured once every
+             * this many iterations, to keep the clock reads off the hot path. The
+             * other counters are updated at every iteration.
+             */
+            std::uint32_t statistics_timing_interval;
+
+            /**
+             * The solver stops after this many iterations. If 0, there is no limit.
+             */
+            std::uint32_t max_iterations;
+
+            /**
+             * The solver stops after this many seconds. If not positive, there is no limit.
+             * For the parallel solver, this is wall-clock time (see \ref ParallelALNSSolver::solve).
+             */
+            float time_limit_sec;
+
+            /**
+             * The solver stops after this many consecutive iterations without finding
+             * a new best solution. If 0, there is no limit.
+             */
+            std::uint32_t stagnation_iterations;
+
+            /**
+             * The solver stops as soon as it finds a solution whose cost is not larger
+             * than this one. By default, it is minus infinity (no target).
+             */
+            float target_cost;
+
+            /**
+             * The elapsed time is only measured once every this many iterations, so
+             * that the clock is not read at every iteration. This is also the
+             * granularity at which the time limit is checked. The elapsed time seen
+             * by the visitor and the acceptance criterion is updated at the same rate.
+             */
+            std::uint32_t clock_interval;
+
             /** @brief Default constructor.
              */
             AlgorithmParams() :
                 score_decay{0.9f},
                 new_best_multiplier{10.0f},
                 new_improving_multiplier{4.0f},
-                new_accepted_multiplier{1.5f} {}
+                new_accepted_multiplier{1.5f},
+                batch_size{1u},
+                batch_selection{BatchSelection::BEST},
+                batch_threads{0u},
+                collect_statistics{false},
+                statistics_timing_interval{1u},
+                max_iterations{0u},
+                time_limit_sec{0.0f},
+                stagnation_iterations{0u},
+                target_cost{-std::numeric_limits<float>::infinity()},
+                clock_interval{1u} {}
 
             /** @brief  Builds the params object from a json file.
              *
              *          Relevant parameters will be inside a "score" object at the root
              *          level of the json file, and will be named: score_decay,
              *          new_best_multiplier, new_improving_multiplier, and
-             *          new_accepted_multiplier.
+             *          new_accepted_multiplier. Batched mode parameters will be inside
+             *          a "batch" object, and will be named: size, selection (either
+             *          "best" or "first_accepted"), and threads. Statistics parameters
+             *          will be inside a "statistics" object, and will be named: enabled,
+             *          and timing_interval. Termination parameters will be inside a
+             *          "termination" object, and will be named: max_iterations,
+             *          time_limit, stagnation_iterations, target_cost, and clock_interval.
              *
              *  @param  params_file The json file with the parameter values.
              */
@@ -96,6 +203,67 @@ namespace as {
                 } catch(...) {
                     new_accepted_multiplier = 1.5f;
                 }
+
+                try {
+                    batch_size = pt.get<std::uint32_t>("batch.size");
+                } catch(...) {
+                    batch_size = 1u;
+                }
+
+                try {
+                    const auto selection = pt.get<std::string>("batch.selection");
+                    batch_selection = (selection == "first_accepted") ? BatchSelection::FIRST_ACCEPTED : BatchSelection::BEST;
+                } catch(...) {
+                    batch_selection = BatchSelection::BEST;
+                }
+
+                try {
+                    batch_threads = pt.get<std::uint32_t>("batch.threads");
+                } catch(...) {
+                    batch_threads = 0u;
+                }
+
+                try {
+                    collect_statistics = pt.get<bool>("statistics.enabled");
+                } catch(...) {
+                    collect_statistics = false;
+                }
+
+                try {
+                    statistics_timing_interval = pt.get<std::uint32_t>("statistics.timing_interval");
+                } catch(...) {
+                    statistics_timing_interval = 1u;
+                }
+
+                try {
+                    max_iterations = pt.get<std::uint32_t>("termination.max_iterations");
+                } catch(...) {
+                    max_iterations = 0u;
+                }
+
+                try {
+                    time_limit_sec = pt.get<float>("termination.time_limit");
+                } catch(...) {
+                    time_limit_sec = 0.0f;
+                }
+
+                try {
+                    stagnation_iterations = pt.get<std::uint32_t>("termination.stagnation_iterations");
+                } catch(...) {
+                    stagnation_iterations = 0u;
+                }
+
+                try {
+                    target_cost = pt.get<float>("termination.target_cost");
+                } catch(...) {
+                    target_cost = -std::numeric_limits<float>::infinity();
+                }
+
+                try {
+                    clock_interval = pt.get<std::uint32_t>("termination.clock_interval");
+                } catch(...) {
+                    clock_interval = 1u;
+                }
             }
         };
 
@@ -103,30 +271,340 @@ namespace as {
          *
          *          A destroy method needs to derive from this class and implement
          *          the operator(Solution&), which will destroy the solution in place.
+         *          Methods which make random choices should also override the
+         *          operator(Solution&, std::mt19937&), and draw from the generator
+         *          they receive: this is what makes batched mode (see
+         *          \ref AlgorithmParams::batch_size) safe and reproducible.
          *
          *  @tparam Solution    The problem-specific solution type.
          */
         template<class Solution>
         struct DestroyMethod {
+            virtual ~DestroyMethod() = default;
+
             /** @brief  Destroys a solution in place.
              */
             virtual void operator()(Solution&) = 0;
+
+            /** @brief  Destroys a solution in place, using the given pseudo-random
+             *          number generator. By default, it ignores the generator.
+             */
+            virtual void operator()(Solution& solution, std::mt19937&) { (*this)(solution); }
+
+            /** @brief  Tells whether the method can be called concurrently on different
+             *          solutions. If not, in batched mode, calls are serialised.
+             */
+            virtual bool is_thread_safe() const { return false; }
         };
 
         /** @brief  Virtual base class for repair methods.
          *
          *          A repair method needs to derive from this class and implement
          *          the operator(Solution&), which will repair the solution in place.
+         *          As for \ref DestroyMethod, methods which make random choices should
+         *          also override the operator(Solution&, std::mt19937&).
          *
          *  @tparam Solution    The problem-specific solution type.
          */
         template<class Solution>
         struct RepairMethod {
+            virtual ~RepairMethod() = default;
+
             /** @brief  Repairs a solution in place.
              */
             virtual void operator()(Solution&) = 0;
+
+            /** @brief  Repairs a solution in place, using the given pseudo-random
+             *          number generator. By default, it ignores the generator.
+             */
+            virtual void operator()(Solution& solution, std::mt19937&) { (*this)(solution); }
+
+            /** @brief  Repairs a solution in place, giving up as soon as its cost is
+             *          bound to exceed \p cost_bound.
+             *
+             *          The solver calls this overload when the acceptance criterion
+             *          provides a rejection bound, i.e. a cost above which it rejects
+             *          new solutions. Repair methods which build the solution
+             *          incrementally can override it, to avoid completing a repair
+             *          whose partial cost already exceeds the bound. By default, it
+             *          repairs the whole solution.
+             *
+             *  @return False iff the repair was abandoned, in which case the solution
+             *          is rejected without computing its cost.
+             */
+            virtual bool operator()(Solution& solution, std::mt19937& mt, float /* cost_bound */) {
+                (*this)(solution, mt);
+                return true;
+            }
+
+            /** @brief  Tells whether the method can be called concurrently on different
+             *          solutions. If not, in batched mode, calls are serialised.
+             */
+            virtual bool is_thread_safe() const { return false; }
+        };
+
+        /** @brief  Tells why the solver stopped.
+         */
+        enum class TerminationReason {
+            /**
+             * The solver did not stop (yet).
+             */
+            NONE,
+
+            /**
+             * The visitor asked to stop.
+             */
+            VISITOR,
+
+            /**
+             * The limit on the number of iterations was reached.
+             */
+            ITERATIONS,
+
+            /**
+             * The time limit was reached.
+             */
+            TIME,
+
+            /**
+             * Too many iterations passed without finding a new best solution.
+             */
+            STAGNATION,
+
+            /**
+             * A solution with the target cost was found.
+             */
+            TARGET_COST
+        };
+
+        /** @brief  Outcome of applying a (destroy, repair) pair to the current solution.
+         */
+        enum class MethodOutcome {
+            NEW_BEST,
+            IMPROVING,
+            ACCEPTED,
+            REJECTED
+        };
+
+        /** @brief  Statistics about a destroy or repair method.
+         */
+        struct MethodStatistics {
+            /**
+             * Number of times the method was called.
+             */
+            std::uint64_t calls = 0u;
+
+            /**
+             * Number of calls whose wall time was measured.
+             */
+            std::uint64_t timed_calls = 0u;
+
+            /**
+             * Cumulative wall time, in seconds, of the calls which were measured.
+             */
+            double timed_sec = 0.0;
+
+            /**
+             * Number of calls which produced a new best solution.
+             */
+            std::uint64_t new_best = 0u;
+
+            /**
+             * Number of calls which produced a solution improving on the current one.
+             */
+            std::uint64_t improving = 0u;
+
+            /**
+             * Number of calls which produced a non-improving, accepted solution.
+             */
+            std::uint64_t accepted = 0u;
+
+            /**
+             * Number of calls which produced a rejected solution.
+             */
+            std::uint64_t rejected = 0u;
+
+            /** @brief  Estimates the cumulative wall time of all calls, extrapolating
+             *          from the calls which were measured.
+             *
+             *  @return The estimated wall time, in seconds.
+             */
+            double estimated_time_sec() const {
+                return (timed_calls == 0u) ? 0.0 : timed_sec * calls / timed_calls;
+            }
+
+            /** @brief  Records a call.
+             *
+             *  @param outcome  The outcome of the call.
+             *  @param timed    Whether the call's wall time was measured.
+             *  @param sec      The call's wall time, if measured.
+             */
+            void record(MethodOutcome outcome, bool timed, double sec) {
+                ++calls;
+
+                if(timed) {
+                    ++timed_calls;
+                    timed_sec += sec;
+                }
+
+                switch(outcome) {
+                    case MethodOutcome::NEW_BEST: ++new_best; break;
+                    case MethodOutcome::IMPROVING: ++improving; break;
+                    case MethodOutcome::ACCEPTED: ++accepted; break;
+                    case MethodOutcome::REJECTED: ++rejected; break;
+                }
+            }
+
+            /** @brief  Converts the statistics to a property tree.
+             *
+             *  @return The property tree.
+             */
+            boost::property_tree::ptree to_ptree() const {
+                boost::property_tree::ptree pt;
+                pt.put("calls", calls);
+                pt.put("timed_calls", timed_calls);
+                pt.put("timed_sec", timed_sec);
+                pt.put("estimated_time_sec", estimated_time_sec());
+                pt.put("new_best", new_best);
+                pt.put("improving", improving);
+                pt.put("accepted", accepted);
+                pt.put("rejected", rejected);
+                return pt;
+            }
+        };
+
+        /** @brief  Statistics collected by the solver when \ref AlgorithmParams::collect_statistics
+         *          is true.
+         *
+         *          Counters are updated at every iteration; timings are only measured
+         *          once every \ref AlgorithmParams::statistics_timing_interval iterations,
+         *          and totals are extrapolated from them. In batched mode each candidate
+         *          counts as a call of its methods, and candidates which are not kept
+         *          are classified by their cost alone.
+         */
+        struct AlgorithmStatistics {
+            /**
+             * Statistics of the destroy methods. Indices match those of the methods.
+             */
+            std::vector<MethodStatistics> destroy_methods;
+
+            /**
+             * Statistics of the repair methods. Indices match those of the methods.
+             */
+            std::vector<MethodStatistics> repair_methods;
+
+            /**
+             * Number of iterations whose timings were measured.
+             */
+            std::uint64_t timed_iterations = 0u;
+
+            /**
+             * Cumulative wall time, in seconds, spent in the acceptance criterion
+             * during the timed iterations.
+             */
+            double acceptance_timed_sec = 0.0;
+
+            /**
+             * Cumulative wall time, in seconds, spent copying solutions during the
+             * timed iterations.
+             */
+            double copy_timed_sec = 0.0;
+
+            /** @brief  Converts the statistics to a property tree.
+             *
+             *  @return The property tree.
+             */
+            boost::property_tree::ptree to_ptree() const {
+                using namespace boost::property_tree;
+
+                ptree pt;
+                pt.put("timed_iterations", timed_iterations);
+                pt.put("acceptance_timed_sec", acceptance_timed_sec);
+                pt.put("copy_timed_sec", copy_timed_sec);
+
+                ptree destroy_pt, repair_pt;
+
+                for(const auto& method : destroy_methods) {
+                    destroy_pt.push_back(std::make_pair("", method.to_ptree()));
+                }
+
+                for(const auto& method : repair_methods) {
+                    repair_pt.push_back(std::make_pair("", method.to_ptree()));
+                }
+
+                pt.add_child("destroy_methods", destroy_pt);
+                pt.add_child("repair_methods", repair_pt);
+
+                return pt;
+            }
+
+            /** @brief  Writes the statistics to a json file.
+             *
+             *  @param  file    The output json file.
+             */
+            void write_json(std::string file) const {
+                boost::property_tree::write_json(file, to_ptree());
+            }
         };
 
+        namespace detail {
+            template<class Function>
+            inline double time_if(bool timed, Function&& function) {
+                if(!timed) {
+                    function();
+                    return 0.0;
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                function();
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+
+            template<class Solution>
+            using undo_method_type = decltype(std::declval<Solution&>().undo());
+
+            template<class Solution>
+            using commit_method_type = decltype(std::declval<Solution&>().commit());
+
+            template<class Solution>
+            using replay_on_method_type = decltype(std::declval<const Solution&>().replay_on(std::declval<Solution&>()));
+        }
+
+
+        /** @brief  Tells whether a solution type is reversible.
+         *
+         *          By default, at each iteration, the solver copies the current solution
+         *          into the new solution, before destroying and repairing it; if the new
+         *          solution is accepted, it is then copied back into the current solution.
+         *          When solutions are large, these copies can cost more than the destroy
+         *          and repair methods themselves. A solution type can opt out of these
+         *          copies by recording the moves which are applied to it (typically, the
+         *          destroy and repair methods modify the solution via member functions,
+         *          which also record the changes) and exposing three member functions:
+         *
+         *          * void undo(), which reverts all moves recorded since the last call
+         *            to commit(), and forgets them.
+         *          * void replay_on(Solution& other) const, which applies to \p other
+         *            the moves recorded since the last call to commit(). It is only ever
+         *            called on a solution \p other which is in the same state as this
+         *            solution was, at the last call to commit().
+         *          * void commit(), which forgets all recorded moves.
+         *
+         *          Rejected new solutions are then rolled back with undo(), and accepted
+         *          ones are committed by replaying their moves on the current solution.
+         *          The work per iteration is thus proportional to the size of the
+         *          neighbourhood, rather than to the size of the solution. Copies still
+         *          take place when a new best solution is found.
+         *
+         *  @tparam Solution    The problem-specific solution type.
+         */
+        template<class Solution>
+        using is_reversible_solution = std::integral_constant<bool,
+            tmp::can_apply<detail::undo_method_type, Solution>::value &&
+            tmp::can_apply<detail::commit_method_type, Solution>::value &&
+            tmp::can_apply<detail::replay_on_method_type, Solution>::value
+        >;
+
         // Forward-declaration.
         template<
                 class Solution,
@@ -134,6 +612,13 @@ namespace as {
                 class AlgorithmVisitor
         > class ALNSSolver;
 
+        // Forward-declaration.
+        template<
+                class Solution,
+                class AcceptanceCriterion,
+                class AlgorithmVisitor
+        > class ParallelALNSSolver;
+
         /** @brief  A class containing current informations on the algorithm's
          *          status during the solution process.
          *
@@ -171,6 +656,16 @@ namespace as {
              */
             float elapsed_time_sec;
 
+            /**
+             * Last iteration at which a new best solution was found.
+             */
+            std::uint32_t last_improvement_iteration;
+
+            /**
+             * Why the solver stopped, if it did.
+             */
+            TerminationReason termination_reason;
+
             /**
              * Pointers to the destroy methods.
              */
@@ -183,13 +678,15 @@ namespace as {
 
             /**
              * Destroy methods scores. Indices match those of \ref destroy_methods.
+             * They are kept in a weighted sampler, so that the roulette-wheel
+             * selection of a method takes logarithmic time in the number of methods.
              */
-            std::vector<float> destroy_scores;
+            rnd::WeightedSampler<float> destroy_scores;
 
             /**
              * Repair methods scores. Indices match those of \ref repair_methods.
              */
-            std::vector<float> repair_scores;
+            rnd::WeightedSampler<float> repair_scores;
 
             /**
              * Best solution encountered so far.
@@ -207,6 +704,23 @@ namespace as {
              */
             Solution new_solution;
 
+            /**
+             * Cost of the best solution. The costs of the solutions are cached
+             * so that Solution::cost() is called only once per iteration, on
+             * the new solution produced by the destroy and repair methods.
+             */
+            float best_cost;
+
+            /**
+             * Cost of the current solution.
+             */
+            float current_cost;
+
+            /**
+             * Cost of the new solution.
+             */
+            float new_cost;
+
             /**
              * Vector index of the last destroy method used.
              */
@@ -217,9 +731,63 @@ namespace as {
              */
             std::size_t latest_repair_id;
 
+            /**
+             * Only used with reversible solutions (see \ref is_reversible_solution).
+             * True iff the new solution might not be in the same state as the current
+             * solution, and must be re-synchronised with a full copy.
+             */
+            bool new_solution_out_of_sync;
+
+            /**
+             * Only used in batched mode: the candidate solutions produced at the
+             * current iteration. After the acceptance criterion is evaluated, the
+             * kept candidate is moved into \ref new_solution.
+             */
+            std::vector<Solution> candidate_solutions;
+
+            /**
+             * Only used in batched mode: costs of the candidate solutions.
+             */
+            std::vector<float> candidate_costs;
+
+            /**
+             * Only used in batched mode: indices of the destroy methods used to
+             * produce each candidate.
+             */
+            std::vector<std::size_t> candidate_destroy_ids;
+
+            /**
+             * Only used in batched mode: indices of the repair methods used to
+             * produce each candidate.
+             */
+            std::vector<std::size_t> candidate_repair_ids;
+
+            /**
+             * Only used in batched mode: one pseudo-random number generator per
+             * candidate, seeded from \ref mt. Generators are tied to candidates
+             * rather than to threads, so that runs are reproducible independently
+             * of how the candidates are scheduled on the threads.
+             */
+            std::vector<std::mt19937> candidate_mts;
+
+            /**
+             * Only used in batched mode, with reversible solutions: whether each
+             * candidate is the current solution plus the changes it recorded since,
+             * so that undoing them is enough to re-synchronise it, without a copy.
+             */
+            std::vector<char> candidate_in_sync;
+
+            /**
+             * Statistics, only collected if \ref AlgorithmParams::collect_statistics is true.
+             */
+            AlgorithmStatistics statistics;
+
             template<class FSolution, class AcceptanceCriterion, class AlgorithmVisitor>
             friend class ALNSSolver;
 
+            template<class FSolution, class AcceptanceCriterion, class AlgorithmVisitor>
+            friend class ParallelALNSSolver;
+
         public:
             /** @brief Builds the status used to start the algorithm.
              *
@@ -231,11 +799,17 @@ namespace as {
                     mt{as::rnd::get_seeded_mt()},
                     iteration_number{0u},
                     elapsed_time_sec{0.0f},
+                    last_improvement_iteration{0u},
+                    termination_reason{TerminationReason::NONE},
                     destroy_scores{std::vector<float>(destroy_methods.size(), 1.0f)},
                     repair_scores{std::vector<float>(repair_methods.size(), 1.0f)},
                     best_solution{initial_solution},
                     current_solution{initial_solution},
-                    new_solution{initial_solution} {}
+                    new_solution{initial_solution},
+                    best_cost{initial_solution.cost()},
+                    current_cost{best_cost},
+                    new_cost{best_cost},
+                    new_solution_out_of_sync{true} {}
 
             /** @brief  Get the current iteration number.
              *
@@ -253,6 +827,23 @@ namespace as {
                 return this->elapsed_time_sec;
             }
 
+            /** @brief  Get the last iteration at which a new best solution was found.
+             *
+             *  @return The last improving iteration.
+             */
+            std::size_t get_last_improvement_iteration() const {
+                return this->last_improvement_iteration;
+            }
+
+            /** @brief  Tells why the solver stopped, or \ref TerminationReason::NONE
+             *          if it did not.
+             *
+             *  @return The termination reason.
+             */
+            TerminationReason get_termination_reason() const {
+                return this->termination_reason;
+            }
+
             /** @brief  Get an editable (non-const) reference to the vector of
              *          destroy methods.
              *
@@ -276,7 +867,7 @@ namespace as {
              *  @return The vector of scores of destroy methods.
              */
             const std::vector<float>& get_destroy_scores() const {
-                return this->destroy_scores;
+                return this->destroy_scores.get_weights();
             }
 
             /** @brief  Get a const reference to the vector of scores of repair methods.
@@ -284,7 +875,7 @@ namespace as {
              *  @return The vector of scores of repair methods.
              */
             const std::vector<float>& get_repair_scores() const {
-                return this->repair_scores;
+                return this->repair_scores.get_weights();
             }
 
             /** @brief  Get an editable (non-const) reference to the best solution
@@ -314,39 +905,312 @@ namespace as {
                 return this->new_solution;
             }
 
+            /** @brief  Get a const reference to the candidate solutions produced during
+             *          the current iteration, in batched mode. The candidate which was
+             *          kept is not among them, as it was moved into the new solution.
+             *
+             *  @return The candidate solutions.
+             */
+            const std::vector<Solution>& get_candidate_solutions() const {
+                return this->candidate_solutions;
+            }
+
+            /** @brief  Get a const reference to the costs of the candidate solutions
+             *          produced during the current iteration, in batched mode,
+             *          including the cost of the candidate which was kept.
+             *
+             *  @return The costs of the candidate solutions.
+             */
+            const std::vector<float>& get_candidate_costs() const {
+                return this->candidate_costs;
+            }
+
+            /** @brief  Get a const reference to the statistics collected so far.
+             *
+             *  @return The statistics.
+             */
+            const AlgorithmStatistics& get_statistics() const {
+                return this->statistics;
+            }
+
+            /** @brief  Get the cached cost of the best solution encountered so far.
+             *
+             *  @return The cost of the best solution.
+             */
+            float get_best_cost() const {
+                return this->best_cost;
+            }
+
+            /** @brief  Get the cached cost of the current solution.
+             *
+             *  @return The cost of the current solution.
+             */
+            float get_current_cost() const {
+                return this->current_cost;
+            }
+
+            /** @brief  Get the cached cost of the new solution, produced during
+             *          the current iteration.
+             *
+             *  @return The cost of the new solution.
+             */
+            float get_new_cost() const {
+                return this->new_cost;
+            }
+
+            /** @brief  Notifies the algorithm that the current solution was modified
+             *          outside of the destroy and repair methods, e.g. by a visitor
+             *          applying a local search to it.
+             *
+             *          This updates the cached cost of the current solution. With
+             *          reversible solutions (see \ref is_reversible_solution), it
+             *          also forces the algorithm to re-synchronise the new solution
+             *          with the current one via a full copy, at the next iteration.
+             */
+            void mark_current_solution_modified() {
+                current_cost = current_solution.cost();
+                new_solution_out_of_sync = true;
+                candidate_in_sync.clear();
+            }
+
+            /** @brief  Notifies the algorithm that the best solution was modified
+             *          by the user, e.g. by a visitor applying a local search to it.
+             *
+             *          This updates the cached cost of the best solution.
+             */
+            void mark_best_solution_modified() {
+                best_cost = best_solution.cost();
+                last_improvement_iteration = iteration_number;
+            }
+
+            /** @brief  Seeds the pseudo-random number generator, to make runs
+             *          reproducible. The generators of the batched mode candidates
+             *          are re-seeded from it, too.
+             *
+             *  @param  seed    The seed.
+             */
+            void set_seed(std::mt19937::result_type seed) {
+                mt.seed(seed);
+                candidate_mts.clear();
+                candidate_solutions.clear();
+            }
+
+            /** @brief  Replaces the scores of the destroy methods, e.g. with those
+             *          learned during a previous run (warm start).
+             *
+             *  @param  scores  The new scores. Indices match those of the destroy methods.
+             */
+            void set_destroy_scores(const std::vector<float>& scores) {
+                if(scores.size() != destroy_methods.size()) {
+                    throw std::invalid_argument("Number of scores does not match the number of destroy methods");
+                }
+
+                destroy_scores = rnd::WeightedSampler<float>{scores};
+            }
+
+            /** @brief  Replaces the scores of the repair methods, e.g. with those
+             *          learned during a previous run (warm start).
+             *
+             *  @param  scores  The new scores. Indices match those of the repair methods.
+             */
+            void set_repair_scores(const std::vector<float>& scores) {
+                if(scores.size() != repair_methods.size()) {
+                    throw std::invalid_argument("Number of scores does not match the number of repair methods");
+                }
+
+                repair_scores = rnd::WeightedSampler<float>{scores};
+            }
+
+            /** @brief  Takes a snapshot of the status, which can be used to resume the
+             *          solution process later (see \ref from_ptree).
+             *
+             *          The snapshot contains the best and current solutions, the methods
+             *          scores, the iteration number, the elapsed time, and the state of
+             *          the pseudo-random number generator. The methods themselves, the
+             *          statistics and the batched mode buffers are not part of it.
+             *
+             *  @tparam SolutionWriter  Callable type with signature ptree(const Solution&).
+             *  @param  write_solution  Converts a solution into a property tree.
+             *  @return                 The snapshot.
+             */
+            template<class SolutionWriter>
+            boost::property_tree::ptree to_ptree(SolutionWriter write_solution) const {
+                using namespace boost::property_tree;
+
+                ptree pt;
+                pt.put("iteration_number", iteration_number);
+                pt.put("elapsed_time_sec", elapsed_time_sec);
+                pt.put("last_improvement_iteration", last_improvement_iteration);
+
+                std::ostringstream mt_state;
+                mt_state << mt;
+                pt.put("prng", mt_state.str());
+
+                pt.add_child("destroy_scores", scores_to_ptree(destroy_scores.get_weights()));
+                pt.add_child("repair_scores", scores_to_ptree(repair_scores.get_weights()));
+                pt.add_child("best_solution", write_solution(best_solution));
+                pt.add_child("current_solution", write_solution(current_solution));
+
+                return pt;
+            }
+
+            /** @brief  Restores the status from a snapshot taken with \ref to_ptree.
+             *
+             *          The solver must have the same destroy and repair methods, in
+             *          the same order, as the one the snapshot was taken from.
+             *
+             *  @tparam SolutionReader  Callable type with signature Solution(const ptree&).
+             *  @param  pt              The snapshot.
+             *  @param  read_solution   Converts a property tree into a solution.
+             */
+            template<class SolutionReader>
+            void from_ptree(const boost::property_tree::ptree& pt, SolutionReader read_solution) {
+                set_destroy_scores(scores_from_ptree(pt.get_child("destroy_scores")));
+                set_repair_scores(scores_from_ptree(pt.get_child("repair_scores")));
+
+                std::istringstream mt_state{pt.get<std::string>("prng")};
+                mt_state >> mt;
+
+                if(mt_state.fail()) {
+                    throw std::runtime_error("Invalid pseudo-random number generator state");
+                }
+
+                iteration_number = pt.get<std::uint32_t>("iteration_number");
+                elapsed_time_sec = pt.get<float>("elapsed_time_sec");
+                last_improvement_iteration = pt.get<std::uint32_t>("last_improvement_iteration");
+                best_solution = read_solution(pt.get_child("best_solution"));
+                current_solution = read_solution(pt.get_child("current_solution"));
+                best_cost = best_solution.cost();
+                current_cost = current_solution.cost();
+                invalidate_working_solutions();
+            }
+
         private:
 
+            void reset(Solution initial_solution, bool keep_scores) {
+                iteration_number = 0u;
+                elapsed_time_sec = 0.0f;
+                last_improvement_iteration = 0u;
+                termination_reason = TerminationReason::NONE;
+                best_solution = initial_solution;
+                current_solution = initial_solution;
+                best_cost = best_solution.cost();
+                current_cost = best_cost;
+                statistics = AlgorithmStatistics{};
+                statistics.destroy_methods.resize(destroy_methods.size());
+                statistics.repair_methods.resize(repair_methods.size());
+                invalidate_working_solutions();
+
+                if(!keep_scores) {
+                    destroy_scores = rnd::WeightedSampler<float>{std::vector<float>(destroy_methods.size(), 1.0f)};
+                    repair_scores = rnd::WeightedSampler<float>{std::vector<float>(repair_methods.size(), 1.0f)};
+                }
+            }
+
+            // Forces a full re-synchronisation of the new solution and of the batched
+            // mode candidates with the current solution, and re-seeds the candidates
+            // generators from mt.
+            void invalidate_working_solutions() {
+                new_cost = current_cost;
+                new_solution_out_of_sync = true;
+                candidate_solutions.clear();
+                candidate_costs.clear();
+                candidate_mts.clear();
+                candidate_in_sync.clear();
+            }
+
+            static boost::property_tree::ptree scores_to_ptree(const std::vector<float>& scores) {
+                boost::property_tree::ptree pt;
+
+                for(auto score : scores) {
+                    boost::property_tree::ptree score_pt;
+                    score_pt.put_value(score);
+                    pt.push_back(std::make_pair("", score_pt));
+                }
+
+                return pt;
+            }
+
+            static std::vector<float> scores_from_ptree(const boost::property_tree::ptree& pt) {
+                std::vector<float> scores;
+
+                for(const auto& score_pt : pt) {
+                    scores.push_back(score_pt.second.get_value<float>());
+                }
+
+                return scores;
+            }
+
             const std::unique_ptr<DestroyMethod<Solution>>& get_roulette_destroy() {
-                latest_destroy_id = rnd::roulette_wheel(destroy_scores, mt);
+                latest_destroy_id = destroy_scores.sample(mt);
                 return destroy_methods[latest_destroy_id];
             }
 
             const std::unique_ptr<RepairMethod<Solution>>& get_roulette_repair() {
-                latest_repair_id = rnd::roulette_wheel(repair_scores, mt);
+                latest_repair_id = repair_scores.sample(mt);
                 return repair_methods[latest_repair_id];
             }
 
             void update_score_best() {
-                update_score(latest_destroy_id, params.new_best_multiplier, destroy_scores);
-                update_score(latest_repair_id, params.new_best_multiplier, repair_scores);
+                update_scores(latest_destroy_id, latest_repair_id, params.new_best_multiplier);
             }
 
             void update_score_improving() {
-                update_score(latest_destroy_id, params.new_improving_multiplier, destroy_scores);
-                update_score(latest_repair_id, params.new_improving_multiplier, repair_scores);
+                update_scores(latest_destroy_id, latest_repair_id, params.new_improving_multiplier);
             }
 
             void update_score_accepted() {
-                update_score(latest_destroy_id, params.new_accepted_multiplier, destroy_scores);
-                update_score(latest_repair_id, params.new_accepted_multiplier, repair_scores);
+                update_scores(latest_destroy_id, latest_repair_id, params.new_accepted_multiplier);
+            }
+
+            void update_scores(std::size_t destroy_id, std::size_t repair_id, float multiplier) {
+                update_score(destroy_id, multiplier, destroy_scores);
+                update_score(repair_id, multiplier, repair_scores);
             }
 
-            void update_score(std::size_t method_id, float multiplier, std::vector<float>& scores) {
-                scores[method_id] *= params.score_decay;
-                scores[method_id] += (1 - params.score_decay) * multiplier;
+            void update_score(std::size_t method_id, float multiplier, rnd::WeightedSampler<float>& scores) {
+                const auto score = scores.get_weight(method_id) * params.score_decay +
+                                   (1 - params.score_decay) * multiplier;
+                scores.set_weight(method_id, score);
             }
         };
 
+        namespace detail {
+            template<class AcceptanceCriterion, class Solution>
+            using rejection_bound_method_type = decltype(
+                std::declval<AcceptanceCriterion&>().rejection_bound(std::declval<const AlgorithmStatus<Solution>&>())
+            );
+        }
+
+        /** @brief  Tells whether an acceptance criterion provides a rejection bound,
+         *          i.e. a member function float rejection_bound(const AlgorithmStatus<Solution>&)
+         *          returning a cost above which it is guaranteed to reject the new
+         *          solution at the current iteration. The bound is then passed to the
+         *          repair methods, see \ref RepairMethod.
+         *
+         *  @tparam AcceptanceCriterion The acceptance criterion type.
+         *  @tparam Solution            The problem-specific solution type.
+         */
+        template<class AcceptanceCriterion, class Solution>
+        using has_rejection_bound = tmp::can_apply<detail::rejection_bound_method_type, AcceptanceCriterion, Solution>;
+
+        namespace detail {
+            template<class AcceptanceCriterion>
+            using set_seed_method_type = decltype(
+                std::declval<AcceptanceCriterion&>().set_seed(std::declval<std::mt19937::result_type>())
+            );
+        }
+
+        /** @brief  Tells whether an acceptance criterion draws random numbers from its
+         *          own generator, which can be seeded via a member function
+         *          void set_seed(std::mt19937::result_type). The solver then seeds it
+         *          from the algorithm status generator, to make runs reproducible.
+         *
+         *  @tparam AcceptanceCriterion The acceptance criterion type.
+         */
+        template<class AcceptanceCriterion>
+        using has_seed = tmp::can_apply<detail::set_seed_method_type, AcceptanceCriterion>;
+
         /** @brief      An acceptance criterion used by default, if the user does not
          *              provide one. It just accepts all solutions.
          *
@@ -381,6 +1245,21 @@ namespace as {
         };
 
         /** @brief  The ALNS solver.
+         *
+         *          The costs of the best, current, and new solutions are cached in
+         *          the \ref AlgorithmStatus, so that Solution::cost() is only called
+         *          once per iteration, on the new solution. Solutions whose cost is
+         *          expensive to compute can further memoise it, and have the repair
+         *          methods update it incrementally.
+         *
+         *          When \ref AlgorithmParams::batch_size is larger than 1, each
+         *          iteration applies that many (destroy, repair) pairs to copies of
+         *          the current solution, on a thread pool, and keeps one of the
+         *          resulting candidates, according to \ref AlgorithmParams::batch_selection.
+         *          The acceptance criterion and the visitor are called once per
+         *          candidate examined and once per iteration, respectively; the
+         *          new solution they see is the candidate being examined or kept,
+         *          and the whole batch is available via the algorithm status.
          *
          *  @tparam Solution                The problem-specific solution type.
          *  @tparam AcceptanceCriterion     The acceptance criterion type.
@@ -412,6 +1291,54 @@ namespace as {
              */
             AlgorithmStatus<Solution> status;
 
+            /**
+             * Only used in batched mode: the threads producing the candidate solutions.
+             * It is created when first needed.
+             */
+            std::unique_ptr<concurrency::ThreadPool> pool;
+
+            /**
+             * Only used in batched mode: serialise the calls to destroy methods
+             * which are not thread-safe. Indices match those of the destroy methods.
+             */
+            std::vector<std::mutex> destroy_locks;
+
+            /**
+             * Only used in batched mode: serialise the calls to repair methods
+             * which are not thread-safe. Indices match those of the repair methods.
+             */
+            std::vector<std::mutex> repair_locks;
+
+            /**
+             * Only used in batched mode: outcome of each candidate, for the statistics.
+             */
+            std::vector<MethodOutcome> candidate_outcomes;
+
+            /**
+             * Only used in batched mode: indices of the candidates, in the order
+             * they are passed to the acceptance criterion. Kept across iterations
+             * to avoid allocating it at each one.
+             */
+            std::vector<std::size_t> candidate_order;
+
+            /**
+             * Only used in batched mode: wall time of the destroy method of each
+             * candidate, for the statistics.
+             */
+            std::vector<double> candidate_destroy_sec;
+
+            /**
+             * Only used in batched mode: wall time of the repair method of each
+             * candidate, for the statistics.
+             */
+            std::vector<double> candidate_repair_sec;
+
+            /**
+             * Only used in batched mode: wall time of re-synchronising each candidate
+             * with the current solution, for the statistics.
+             */
+            std::vector<double> candidate_copy_sec;
+
         public:
             /** @brief  Creates a new solver, given the parameters and an initial solution.
              *
@@ -429,14 +1356,57 @@ namespace as {
              *          If, instead, the user wants to start a new solution process
              *          altogether, it needs to reset the algorithm status,
              *          invoking this solution.
-             *          This will clear the iterations and elapsed time indicators,
-             *          reset best and current solution to the initial one, and
-             *          reset the destroy/repair methods scores.
+             *          This will clear the iterations and elapsed time indicators
+             *          and the statistics, reset best and current solution to the
+             *          initial one, and, unless \p keep_scores is true, reset the
+             *          destroy/repair methods scores. The destroy and repair methods
+             *          are kept.
              *
              * @param   initial_solution    The initial solution.
+             * @param   keep_scores         If true, the new run is warm-started with
+             *                              the scores learned so far.
              */
-            void reset_status(Solution initial_solution) {
-                status = AlgorithmStatus<Solution>{params, initial_solution};
+            void reset_status(Solution initial_solution, bool keep_scores = false) {
+                status.reset(initial_solution, keep_scores);
+            }
+
+            /** @brief  Saves a snapshot of the algorithm status to a json file, see
+             *          \ref AlgorithmStatus::to_ptree.
+             *
+             *  @tparam SolutionWriter  Callable type with signature ptree(const Solution&).
+             *  @param  checkpoint_file The output json file.
+             *  @param  write_solution  Converts a solution into a property tree.
+             */
+            template<class SolutionWriter>
+            void save_checkpoint(std::string checkpoint_file, SolutionWriter write_solution) const {
+                boost::property_tree::write_json(checkpoint_file, status.to_ptree(write_solution));
+            }
+
+            /** @brief  Resumes from a snapshot saved with \ref save_checkpoint. The
+             *          solver must have the same destroy and repair methods, in the
+             *          same order, as the one which saved the snapshot.
+             *
+             *  @tparam SolutionReader  Callable type with signature Solution(const ptree&).
+             *  @param  checkpoint_file The input json file.
+             *  @param  read_solution   Converts a property tree into a solution.
+             */
+            template<class SolutionReader>
+            void load_checkpoint(std::string checkpoint_file, SolutionReader read_solution) {
+                boost::property_tree::ptree pt;
+                boost::property_tree::read_json(checkpoint_file, pt);
+                status.from_ptree(pt, read_solution);
+            }
+
+            /** @brief  Warm-starts the methods scores from a snapshot saved with
+             *          \ref save_checkpoint, leaving the rest of the status untouched.
+             *
+             *  @param  checkpoint_file The input json file.
+             */
+            void load_scores(std::string checkpoint_file) {
+                boost::property_tree::ptree pt;
+                boost::property_tree::read_json(checkpoint_file, pt);
+                status.set_destroy_scores(AlgorithmStatus<Solution>::scores_from_ptree(pt.get_child("destroy_scores")));
+                status.set_repair_scores(AlgorithmStatus<Solution>::scores_from_ptree(pt.get_child("repair_scores")));
             }
 
             /** @brief  Gets an editable (non-const) reference to the
@@ -454,6 +1424,7 @@ namespace as {
              */
             void set_params(AlgorithmParams params) {
                 this->params = params;
+                pool.reset();
             }
 
             /** @brief  Gets the current algorithm parameters.
@@ -472,12 +1443,36 @@ namespace as {
                 this->visitor = visitor;
             }
 
-            /** @brief  Sets a new acceptance criterion.
+            /** @brief  Gets an editable (non-const) reference to the current
+             *          algorithm visitor.
+             *
+             *  @return The current algorithm visitor.
+             */
+            AlgorithmVisitor& get_visitor() {
+                return visitor;
+            }
+
+            /** @brief  Seeds the pseudo-random number generator of the algorithm status
+             *          and, if it has one, that of the acceptance criterion, to make
+             *          runs reproducible.
+             *
+             *  @param  seed    The seed.
+             */
+            void set_seed(std::mt19937::result_type seed) {
+                status.set_seed(seed);
+                seed_acceptance_criterion();
+            }
+
+            /** @brief  Sets a new acceptance criterion. If it has its own
+             *          pseudo-random number generator, this is re-seeded from
+             *          the algorithm status one, so that copies of the same
+             *          criterion given to different solvers draw different numbers.
              *
              *  @param  acceptance  The acceptance criterion.
              */
             void set_acceptance_criterion(AcceptanceCriterion acceptance) {
                 this->acceptance = acceptance;
+                seed_acceptance_criterion();
             }
 
             /** @brief  Gets an editable (non-const) reference to the current
@@ -498,6 +1493,7 @@ namespace as {
                 assert(status.destroy_methods.size() == status.destroy_scores.size());
                 status.destroy_methods.push_back(std::move(method));
                 status.destroy_scores.push_back(1.0f);
+                status.statistics.destroy_methods.emplace_back();
                 return status.destroy_methods.size() - 1u;
             }
 
@@ -510,49 +1506,403 @@ namespace as {
                 assert(status.repair_methods.size() == status.repair_scores.size());
                 status.repair_methods.push_back(std::move(method));
                 status.repair_scores.push_back(1.0f);
+                status.statistics.repair_methods.emplace_back();
                 return status.repair_methods.size() - 1u;
             }
 
             /** @brief  Launches the algorithm.
              *
-             *          The algorithm can be stopped via the visitor.
+             *          The algorithm stops when any of the termination criteria in
+             *          the \ref AlgorithmParams is met, or when the visitor asks to stop.
+             *          The reason is then available via \ref AlgorithmStatus::get_termination_reason.
              *          The overall best solution can be accessed via the
              *          algorithm status.
              */
             void solve() {
+                while(solve_iterations(std::numeric_limits<std::uint32_t>::max()));
+            }
+
+            /** @brief  Runs the algorithm for at most a given number of iterations.
+             *
+             *          The status is preserved between calls, so that calling this
+             *          method repeatedly is equivalent to a single call to \ref solve,
+             *          interrupted at regular intervals. The elapsed time keeps
+             *          counting from where the previous call left it.
+             *
+             *  @param  n_iterations    Maximum number of iterations to run.
+             *  @return                 False iff the algorithm stopped, because a
+             *                          termination criterion was met or the visitor
+             *                          asked to stop.
+             */
+            bool solve_iterations(std::uint32_t n_iterations) {
                 using namespace std::chrono;
-                const auto start_time = high_resolution_clock::now();
+                const auto start_time = steady_clock::now() -
+                    duration_cast<steady_clock::duration>(duration<float>(status.elapsed_time_sec));
+                const auto clock_interval = std::max(1u, params.clock_interval);
 
-                while(true) {
-                    const auto& destroy = status.get_roulette_destroy();
-                    const auto& repair = status.get_roulette_repair();
+                auto update_elapsed_time = [&] () -> void {
+                    status.elapsed_time_sec = duration_cast<duration<float>>(steady_clock::now() - start_time).count();
+                };
 
-                    status.new_solution = status.current_solution;
-                    (*destroy)(status.new_solution);
-                    (*repair)(status.new_solution);
-
-                    if(acceptance(status)) {
-                        if(status.new_solution.cost() < status.current_solution.cost()) {
-                            if(status.new_solution.cost() < status.best_solution.cost()) {
-                                status.best_solution = status.new_solution;
-                                status.update_score_best();
+                status.termination_reason = termination_reason();
+
+                for(std::uint32_t iteration = 0u; iteration < n_iterations; ++iteration) {
+                    if(status.termination_reason != TerminationReason::NONE) {
+                        return false;
+                    }
+
+                    if(params.batch_size > 1u) {
+                        run_batch_iteration();
+                    } else {
+                        run_iteration();
+                    }
+
+                    if(!visitor.on_iteration_end(status)) {
+                        update_elapsed_time();
+                        status.termination_reason = TerminationReason::VISITOR;
+                        return false;
+                    }
+
+                    if(status.iteration_number % clock_interval == 0u) {
+                        update_elapsed_time();
+                    }
+
+                    ++status.iteration_number;
+                    status.termination_reason = termination_reason();
+                }
+
+                update_elapsed_time();
+                return status.termination_reason == TerminationReason::NONE;
+            }
+
+        private:
+
+            void seed_acceptance_criterion() {
+                if constexpr(has_seed<AcceptanceCriterion>::value) {
+                    acceptance.set_seed(status.mt());
+                }
+            }
+
+            void run_iteration() {
+                const bool timed = timing_iteration();
+                double destroy_sec = 0.0, repair_sec = 0.0, acceptance_sec = 0.0, copy_sec = 0.0;
+                auto outcome = MethodOutcome::REJECTED;
+
+                const auto& destroy = status.get_roulette_destroy();
+                const auto& repair = status.get_roulette_repair();
+
+                copy_sec += detail::time_if(timed, [this] () { prepare_new_solution(); });
+                destroy_sec = detail::time_if(timed, [&] () { (*destroy)(status.new_solution, status.mt); });
+                bool repaired = true;
+                repair_sec = detail::time_if(timed, [&] () {
+                    if constexpr(has_rejection_bound<AcceptanceCriterion, Solution>::value) {
+                        repaired = (*repair)(status.new_solution, status.mt, acceptance.rejection_bound(status));
+                    } else {
+                        (*repair)(status.new_solution, status.mt);
+                    }
+                });
+
+                // An abandoned repair is bound to be rejected; the acceptance criterion
+                // is still called, for those which keep track of past decisions.
+                status.new_cost = repaired ? status.new_solution.cost() : std::numeric_limits<float>::infinity();
+
+                bool accepted = false;
+                acceptance_sec = detail::time_if(timed, [&] () { accepted = acceptance(status); });
+
+                if(accepted) {
+                    if(status.new_cost < status.current_cost) {
+                        if(status.new_cost < status.best_cost) {
+                            copy_sec += detail::time_if(timed, [this] () { status.best_solution = status.new_solution; });
+                            status.best_cost = status.new_cost;
+                            status.last_improvement_iteration = status.iteration_number;
+                            status.update_score_best();
+                            outcome = MethodOutcome::NEW_BEST;
+                        } else {
+                            status.update_score_improving();
+                            outcome = MethodOutcome::IMPROVING;
+                        }
+                    } else {
+                        status.update_score_accepted();
+                        outcome = MethodOutcome::ACCEPTED;
+                    }
+
+                    copy_sec += detail::time_if(timed, [this] () { commit_new_solution(); });
+                } else {
+                    reject_new_solution();
+                }
+
+                if(params.collect_statistics) {
+                    status.statistics.destroy_methods[status.latest_destroy_id].record(outcome, timed, destroy_sec);
+                    status.statistics.repair_methods[status.latest_repair_id].record(outcome, timed, repair_sec);
+                    record_iteration_timings(timed, acceptance_sec, copy_sec);
+                }
+            }
+
+            // In batched mode, each candidate starts as a full copy of the current
+            // solution (reversible solutions are not exploited), the candidates are
+            // destroyed and repaired concurrently, and then they are examined
+            // sequentially, presenting each one to the acceptance criterion as the
+            // new solution. All pairs which produced a new best or an improving
+            // solution are rewarded; the accepted bonus only goes to the kept pair.
+            void run_batch_iteration() {
+                const std::size_t batch_size = params.batch_size;
+                const bool timed = timing_iteration();
+                double acceptance_sec = 0.0, copy_sec = 0.0;
+
+                prepare_batch();
+
+                for(auto k = 0u; k < batch_size; ++k) {
+                    status.candidate_destroy_ids[k] = status.destroy_scores.sample(status.mt);
+                    status.candidate_repair_ids[k] = status.repair_scores.sample(status.mt);
+                }
+
+                // The bound only depends on the best and current solutions, which
+                // do not change while the candidates are produced.
+                float cost_bound = std::numeric_limits<float>::infinity();
+
+                if constexpr(has_rejection_bound<AcceptanceCriterion, Solution>::value) {
+                    cost_bound = acceptance.rejection_bound(status);
+                }
+
+                pool->run(batch_size, [this, timed, cost_bound] (std::size_t k) -> void {
+                    auto& solution = status.candidate_solutions[k];
+                    auto& mt = status.candidate_mts[k];
+                    auto& destroy = *status.destroy_methods[status.candidate_destroy_ids[k]];
+                    auto& repair = *status.repair_methods[status.candidate_repair_ids[k]];
+                    bool repaired = true;
+
+                    // Each candidate is re-synchronised with the current solution on its own
+                    // thread, which only reads the current solution.
+                    candidate_copy_sec[k] = detail::time_if(timed, [&] () {
+                        if constexpr(is_reversible_solution<Solution>::value) {
+                            if(status.candidate_in_sync[k]) {
+                                solution.undo();
+                            } else {
+                                solution = status.current_solution;
+                                solution.commit();
+                                status.candidate_in_sync[k] = 1;
+                            }
+                        } else {
+                            solution = status.current_solution;
+                        }
+                    });
+
+                    candidate_destroy_sec[k] = detail::time_if(timed, [&] () {
+                        locked_call(destroy, destroy_locks[status.candidate_destroy_ids[k]], [&] () { destroy(solution, mt); });
+                    });
+                    candidate_repair_sec[k] = detail::time_if(timed, [&] () {
+                        locked_call(repair, repair_locks[status.candidate_repair_ids[k]], [&] () {
+                            if constexpr(has_rejection_bound<AcceptanceCriterion, Solution>::value) {
+                                repaired = repair(solution, mt, cost_bound);
                             } else {
-                                status.update_score_improving();
+                                repair(solution, mt);
+                            }
+                        });
+                    });
+
+                    status.candidate_costs[k] = repaired ? solution.cost() : std::numeric_limits<float>::infinity();
+                });
+
+                copy_sec += std::accumulate(candidate_copy_sec.begin(), candidate_copy_sec.end(), 0.0);
+
+                const auto best_cost = status.best_cost;
+                const auto current_cost = status.current_cost;
+
+                for(auto k = 0u; k < batch_size; ++k) {
+                    const auto cost = status.candidate_costs[k];
+                    const auto destroy_id = status.candidate_destroy_ids[k];
+                    const auto repair_id = status.candidate_repair_ids[k];
+
+                    if(cost < best_cost) {
+                        status.update_scores(destroy_id, repair_id, params.new_best_multiplier);
+                        candidate_outcomes[k] = MethodOutcome::NEW_BEST;
+                    } else if(cost < current_cost) {
+                        status.update_scores(destroy_id, repair_id, params.new_improving_multiplier);
+                        candidate_outcomes[k] = MethodOutcome::IMPROVING;
+                    } else {
+                        candidate_outcomes[k] = MethodOutcome::REJECTED;
+                    }
+                }
+
+                auto& order = candidate_order;
+                order.resize(batch_size);
+                std::iota(order.begin(), order.end(), 0u);
+
+                if(params.batch_selection == BatchSelection::BEST) {
+                    const auto best = std::min_element(order.begin(), order.end(),
+                        [this] (std::size_t k1, std::size_t k2) { return status.candidate_costs[k1] < status.candidate_costs[k2]; });
+                    order.front() = *best;
+                    order.resize(1u);
+                }
+
+                for(auto it = order.begin(); it != order.end(); ++it) {
+                    const auto k = *it;
+
+                    // The slot gets the previous new solution, and must be copied again.
+                    status.candidate_in_sync[k] = 0;
+                    std::swap(status.new_solution, status.candidate_solutions[k]);
+                    status.new_cost = status.candidate_costs[k];
+                    status.latest_destroy_id = status.candidate_destroy_ids[k];
+                    status.latest_repair_id = status.candidate_repair_ids[k];
+
+                    bool accepted = false;
+                    acceptance_sec += detail::time_if(timed, [&] () { accepted = acceptance(status); });
+
+                    if(accepted) {
+                        if(status.new_cost < status.current_cost) {
+                            if(status.new_cost < status.best_cost) {
+                                copy_sec += detail::time_if(timed, [this] () { status.best_solution = status.new_solution; });
+                                status.best_cost = status.new_cost;
+                                status.last_improvement_iteration = status.iteration_number;
                             }
                         } else {
                             status.update_score_accepted();
+                            candidate_outcomes[k] = MethodOutcome::ACCEPTED;
+                        }
+
+                        copy_sec += detail::time_if(timed, [this] () { status.current_solution = status.new_solution; });
+                        status.current_cost = status.new_cost;
+                        std::fill(status.candidate_in_sync.begin(), status.candidate_in_sync.end(), 0);
+
+                        if constexpr(is_reversible_solution<Solution>::value) {
+                            status.current_solution.commit();
                         }
 
-                        status.current_solution = status.new_solution;
+                        break;
                     }
 
-                    if(!visitor.on_iteration_end(status)) {
-                        return;
+                    // Keep the last examined candidate as the new solution.
+                    if(std::next(it) != order.end()) {
+                        std::swap(status.new_solution, status.candidate_solutions[k]);
                     }
+                }
 
-                    const auto current_time = high_resolution_clock::now();
-                    status.elapsed_time_sec = duration_cast<duration<float>>(current_time - start_time).count();
-                    ++status.iteration_number;
+                // The new solution, used outside batched mode, is no longer in sync.
+                status.new_solution_out_of_sync = true;
+
+                if(params.collect_statistics) {
+                    for(auto k = 0u; k < batch_size; ++k) {
+                        const auto outcome = candidate_outcomes[k];
+                        status.statistics.destroy_methods[status.candidate_destroy_ids[k]].record(outcome, timed, candidate_destroy_sec[k]);
+                        status.statistics.repair_methods[status.candidate_repair_ids[k]].record(outcome, timed, candidate_repair_sec[k]);
+                    }
+
+                    record_iteration_timings(timed, acceptance_sec, copy_sec);
+                }
+            }
+
+            TerminationReason termination_reason() const {
+                if(params.max_iterations > 0u && status.iteration_number >= params.max_iterations) {
+                    return TerminationReason::ITERATIONS;
+                }
+
+                if(params.time_limit_sec > 0.0f && status.elapsed_time_sec >= params.time_limit_sec) {
+                    return TerminationReason::TIME;
+                }
+
+                if(params.stagnation_iterations > 0u &&
+                   status.iteration_number - status.last_improvement_iteration >= params.stagnation_iterations) {
+                    return TerminationReason::STAGNATION;
+                }
+
+                if(status.best_cost <= params.target_cost) {
+                    return TerminationReason::TARGET_COST;
+                }
+
+                return TerminationReason::NONE;
+            }
+
+            bool timing_iteration() const {
+                return params.collect_statistics &&
+                       status.iteration_number % std::max(1u, params.statistics_timing_interval) == 0u;
+            }
+
+            void record_iteration_timings(bool timed, double acceptance_sec, double copy_sec) {
+                if(timed) {
+                    ++status.statistics.timed_iterations;
+                    status.statistics.acceptance_timed_sec += acceptance_sec;
+                    status.statistics.copy_timed_sec += copy_sec;
+                }
+            }
+
+            void prepare_batch() {
+                const std::size_t batch_size = params.batch_size;
+
+                if(!pool) {
+                    pool = std::make_unique<concurrency::ThreadPool>(params.batch_threads);
+                }
+
+                if(destroy_locks.size() != status.destroy_methods.size()) {
+                    destroy_locks = std::vector<std::mutex>(status.destroy_methods.size());
+                }
+
+                if(repair_locks.size() != status.repair_methods.size()) {
+                    repair_locks = std::vector<std::mutex>(status.repair_methods.size());
+                }
+
+                if(status.candidate_solutions.size() != batch_size) {
+                    status.candidate_solutions.assign(batch_size, status.current_solution);
+                    status.candidate_costs.assign(batch_size, status.current_cost);
+                    status.candidate_destroy_ids.assign(batch_size, 0u);
+                    status.candidate_repair_ids.assign(batch_size, 0u);
+                    status.candidate_mts.clear();
+                    candidate_outcomes.assign(batch_size, MethodOutcome::REJECTED);
+                    candidate_destroy_sec.assign(batch_size, 0.0);
+                    candidate_repair_sec.assign(batch_size, 0.0);
+                    candidate_copy_sec.assign(batch_size, 0.0);
+
+                    for(auto k = 0u; k < batch_size; ++k) {
+                        std::seed_seq seed{status.mt(), status.mt(), status.mt(), status.mt()};
+                        status.candidate_mts.emplace_back(seed);
+                    }
+                }
+
+                // Cleared whenever the current solution changes, e.g. by the user.
+                if(status.candidate_in_sync.size() != batch_size) {
+                    status.candidate_in_sync.assign(batch_size, 0);
+                }
+            }
+
+            template<class Method, class Call>
+            static void locked_call(const Method& method, std::mutex& lock, Call&& call) {
+                if(method.is_thread_safe()) {
+                    call();
+                } else {
+                    std::lock_guard<std::mutex> guard{lock};
+                    call();
+                }
+            }
+
+            void prepare_new_solution() {
+                if constexpr(is_reversible_solution<Solution>::value) {
+                    if(status.new_solution_out_of_sync) {
+                        status.new_solution = status.current_solution;
+                        status.new_solution.commit();
+                        status.current_solution.commit();
+                        status.new_solution_out_of_sync = false;
+                    }
+                } else {
+                    status.new_solution = status.current_solution;
+                }
+            }
+
+            void commit_new_solution() {
+                status.current_cost = status.new_cost;
+
+                status.candidate_in_sync.clear();
+
+                if constexpr(is_reversible_solution<Solution>::value) {
+                    status.new_solution.replay_on(status.current_solution);
+                    status.current_solution.commit();
+                    status.new_solution.commit();
+                } else {
+                    status.current_solution = status.new_solution;
+                }
+            }
+
+            void reject_new_solution() {
+                if constexpr(is_reversible_solution<Solution>::value) {
+                    status.new_solution.undo();
                 }
             }
         };
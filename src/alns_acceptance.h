@@ -6,6 +6,14 @@
 #define AS_ALNS_ACCEPTANCE_H
 
 #include "alns.h"
+#include "random.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <limits>
+#include <algorithm>
 
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -17,28 +25,49 @@ namespace as {
             TIME
         };
 
-        template<class Solution>
-        struct LinearRecordToRecordTravel {
+        /** @brief  The budget an acceptance criterion schedules its parameters over.
+         *
+         *          Acceptance criteria which change their behaviour over time (e.g.
+         *          a threshold or a temperature decreasing from a start to an end
+         *          value) derive from this class, which tells how much of the budget
+         *          was used so far. The budget is either a number of iterations or
+         *          a time limit.
+         */
+        struct TerminationSchedule {
             MainTerminationCriterion main_termination_criterion;
 
             std::size_t iterations_limit;
             float time_limit;
 
-            float start_threshold;
-            float end_threshold;
-
-            LinearRecordToRecordTravel() :
+            TerminationSchedule() :
                 main_termination_criterion{MainTerminationCriterion::ITERATIONS},
                 iterations_limit{1'000'000u},
-                time_limit{3600},
-                start_threshold{0.1},
-                end_threshold{0.0} {}
+                time_limit{3600} {}
 
-            LinearRecordToRecordTravel(std::string params_file) {
-                using namespace boost::property_tree;
+            /** @brief  Reads the schedule from a property tree.
+             *
+             *          The relevant parameters are acceptance.main_termination_criterion
+             *          (either "iterations" or "time"), iterations_limit, and time_limit.
+             *          When iterations_limit or time_limit are missing, the limits the
+             *          solver stops at, termination.max_iterations and termination.time_limit
+             *          (see \ref AlgorithmParams), are used instead, so that the schedule
+             *          ends when the run does. When the criterion is missing, it is time
+             *          if only a time limit is given, and iterations otherwise.
+             *
+             *  @param  pt  The property tree.
+             */
+            explicit TerminationSchedule(const boost::property_tree::ptree& pt) : TerminationSchedule{} {
+                const auto max_iterations = pt.get_optional<std::size_t>("iterations_limit")
+                    .value_or(pt.get<std::size_t>("termination.max_iterations", 0u));
+                const auto max_time = pt.get_optional<float>("time_limit")
+                    .value_or(pt.get<float>("termination.time_limit", 0.0f));
 
-                ptree pt;
-                read_json(params_file, pt);
+                if(max_iterations > 0u) { iterations_limit = max_iterations; }
+                if(max_time > 0.0f) { time_limit = max_time; }
+
+                if(max_iterations == 0u && max_time > 0.0f) {
+                    main_termination_criterion = MainTerminationCriterion::TIME;
+                }
 
                 try {
                     auto termination_cr = pt.get<std::string>("acceptance.main_termination_criterion");
@@ -48,26 +77,156 @@ namespace as {
                     } else if(termination_cr == "time") {
                         main_termination_criterion = MainTerminationCriterion::TIME;
                     }
-                } catch(...) {
+                } catch(...) {}
+            }
+
+            /** @brief  Schedules over the limits the solver stops at, i.e. the
+             *          iteration and time limits of the algorithm parameters, when
+             *          these are set. If only a time limit is set, the schedule
+             *          follows the elapsed time; otherwise, the iterations.
+             *
+             *  @param  params  The algorithm parameters.
+             */
+            void set_limits(const AlgorithmParams& params) {
+                if(params.max_iterations > 0u) {
+                    iterations_limit = params.max_iterations;
                     main_termination_criterion = MainTerminationCriterion::ITERATIONS;
                 }
 
+                if(params.time_limit_sec > 0.0f) {
+                    time_limit = params.time_limit_sec;
+
+                    if(params.max_iterations == 0u) {
+                        main_termination_criterion = MainTerminationCriterion::TIME;
+                    }
+                }
+            }
+
+            /** @brief  Gives the fraction of the budget used so far.
+             *
+             *  @return A number between 0 (start) and 1 (budget exhausted).
+             */
+            template<class Solution>
+            float progress(const AlgorithmStatus<Solution>& status) const {
+                float used;
+
+                if(main_termination_criterion == MainTerminationCriterion::ITERATIONS) {
+                    used = (iterations_limit == 0u) ? 1.0f :
+                           static_cast<float>(status.get_iteration_number()) / iterations_limit;
+                } else {
+                    used = (time_limit <= 0.0f) ? 1.0f : status.get_elapsed_time_sec() / time_limit;
+                }
+
+                return std::min(1.0f, std::max(0.0f, used));
+            }
+
+            /** @brief  Linearly interpolates between a start and an end value,
+             *          according to the fraction of the budget used so far.
+             *
+             *  @return The interpolated value.
+             */
+            template<class Solution>
+            float linear(const AlgorithmStatus<Solution>& status, float start, float end) const {
+                return start + (end - start) * progress(status);
+            }
+        };
+
+        namespace detail {
+            // Percentage tolerance which also works with non-positive reference costs.
+            inline float add_tolerance(float cost, float relative_tolerance) {
+                return cost + std::abs(cost) * relative_tolerance;
+            }
+        }
+
+        /** @brief  Record-to-record travel: accepts a new solution if its cost is
+         *          within a threshold of the best cost. The threshold decreases
+         *          linearly from \ref start_threshold to \ref end_threshold over
+         *          the schedule.
+         *
+         *          The threshold is computed once per iteration, and cached. The
+         *          criterion provides a rejection bound, which the solver passes to
+         *          repair methods (see \ref RepairMethod), so that they can give up
+         *          as soon as their partial solution is bound to be rejected.
+         */
+        template<class Solution>
+        struct LinearRecordToRecordTravel : TerminationSchedule {
+            float start_threshold;
+            float end_threshold;
+
+            LinearRecordToRecordTravel() :
+                TerminationSchedule{},
+                start_threshold{0.1},
+                end_threshold{0.0} {}
+
+            LinearRecordToRecordTravel(std::string params_file) :
+                LinearRecordToRecordTravel{read_params(params_file)} {}
+
+            explicit LinearRecordToRecordTravel(const boost::property_tree::ptree& pt) : TerminationSchedule{pt} {
                 try {
-                    iterations_limit = pt.get<std::size_t>("iterations_limit");
+                    start_threshold = pt.get<float>("acceptance.start_threshold");
                 } catch(...) {
-                    iterations_limit = 1'000'000u;
+                    start_threshold = 0.1f;
                 }
 
                 try {
-                    time_limit = pt.get<float>("time_limit");
+                    end_threshold = pt.get<float>("acceptance.end_threshold");
                 } catch(...) {
-                    time_limit = 3600;
+                    end_threshold = 0.0f;
                 }
+            }
+
+            /** @brief  Gives the relative threshold at the current iteration.
+             */
+            float threshold(const AlgorithmStatus<Solution>& status) {
+                if(status.get_iteration_number() != cached_iteration) {
+                    cached_iteration = status.get_iteration_number();
+                    cached_threshold = linear(status, start_threshold, end_threshold);
+                }
+
+                return cached_threshold;
+            }
+
+            /** @brief  Gives a cost above which new solutions are rejected.
+             */
+            float rejection_bound(const AlgorithmStatus<Solution>& status) {
+                return detail::add_tolerance(status.get_best_cost(), threshold(status));
+            }
+
+            bool operator()(AlgorithmStatus<Solution>& status) {
+                return status.get_new_cost() <= rejection_bound(status);
+            }
+
+        private:
+
+            static boost::property_tree::ptree read_params(const std::string& params_file) {
+                boost::property_tree::ptree pt;
+                boost::property_tree::read_json(params_file, pt);
+                return pt;
+            }
+
+            std::size_t cached_iteration = std::numeric_limits<std::size_t>::max();
+            float cached_threshold = 0.0f;
+        };
 
+        /** @brief  Threshold accepting: accepts a new solution if its cost is within
+         *          a threshold of the current cost. The threshold decreases linearly
+         *          from \ref start_threshold to \ref end_threshold over the schedule.
+         */
+        template<class Solution>
+        struct ThresholdAccepting : TerminationSchedule {
+            float start_threshold;
+            float end_threshold;
+
+            ThresholdAccepting() :
+                TerminationSchedule{},
+                start_threshold{0.05},
+                end_threshold{0.0} {}
+
+            explicit ThresholdAccepting(const boost::property_tree::ptree& pt) : TerminationSchedule{pt} {
                 try {
                     start_threshold = pt.get<float>("acceptance.start_threshold");
                 } catch(...) {
-                    start_threshold = 0.1f;
+                    start_threshold = 0.05f;
                 }
 
                 try {
@@ -77,19 +236,150 @@ namespace as {
                 }
             }
 
+            /** @brief  Gives a cost above which new solutions are rejected.
+             */
+            float rejection_bound(const AlgorithmStatus<Solution>& status) {
+                if(status.get_iteration_number() != cached_iteration) {
+                    cached_iteration = status.get_iteration_number();
+                    cached_threshold = linear(status, start_threshold, end_threshold);
+                }
+
+                return detail::add_tolerance(status.get_current_cost(), cached_threshold);
+            }
+
             bool operator()(AlgorithmStatus<Solution>& status) {
-                float threshold;
+                return status.get_new_cost() <= rejection_bound(status);
+            }
 
-                if(main_termination_criterion == MainTerminationCriterion::ITERATIONS) {
-                    threshold = start_threshold + (start_threshold - end_threshold) * (iterations_limit - status.get_iteration_number());
-                } else {
-                    threshold = start_threshold + (start_threshold - end_threshold) * (time_limit - status.get_elapsed_time_sec());
+        private:
+
+            std::size_t cached_iteration = std::numeric_limits<std::size_t>::max();
+            float cached_threshold = 0.0f;
+        };
+
+        /** @brief  Simulated annealing: always accepts a new solution not worse than
+         *          the current one, and accepts a worse one with probability
+         *          exp(-delta / T), where delta is the cost increase and T is the
+         *          temperature, which decreases geometrically from \ref start_temperature
+         *          to \ref end_temperature over the schedule.
+         *
+         *          The random number deciding acceptance is drawn once per iteration,
+         *          which turns the criterion into a threshold on the new cost and
+         *          allows it to provide a rejection bound.
+         */
+        template<class Solution>
+        struct SimulatedAnnealing : TerminationSchedule {
+            float start_temperature;
+            float end_temperature;
+
+            SimulatedAnnealing() :
+                TerminationSchedule{},
+                start_temperature{1.0f},
+                end_temperature{0.01f} {}
+
+            explicit SimulatedAnnealing(const boost::property_tree::ptree& pt) : TerminationSchedule{pt} {
+                try {
+                    start_temperature = pt.get<float>("acceptance.start_temperature");
+                } catch(...) {
+                    start_temperature = 1.0f;
                 }
 
-                const auto gap = (status.get_new_solution().cost() - status.get_best_solution().cost()) / status.get_new_solution().cost();
+                try {
+                    end_temperature = pt.get<float>("acceptance.end_temperature");
+                } catch(...) {
+                    end_temperature = 0.01f;
+                }
+            }
 
-                return (gap <= threshold);
+            /** @brief  Gives the temperature at the current iteration.
+             */
+            float temperature(const AlgorithmStatus<Solution>& status) const {
+                assert(start_temperature > 0.0f && end_temperature > 0.0f);
+                return start_temperature * std::pow(end_temperature / start_temperature, progress(status));
             }
+
+            /** @brief  Gives a cost above which new solutions are rejected.
+             */
+            float rejection_bound(const AlgorithmStatus<Solution>& status) {
+                if(status.get_iteration_number() != cached_iteration) {
+                    cached_iteration = status.get_iteration_number();
+
+                    // Draw u in (0,1]: the new solution is accepted iff u <= exp(-delta / T),
+                    // i.e. iff delta <= -T log(u).
+                    const auto u = 1.0f - std::uniform_real_distribution<float>{0.0f, 1.0f}(mt);
+                    cached_slack = -temperature(status) * std::log(u);
+                }
+
+                return status.get_current_cost() + cached_slack;
+            }
+
+            bool operator()(AlgorithmStatus<Solution>& status) {
+                return status.get_new_cost() <= rejection_bound(status);
+            }
+
+            /** @brief  Seeds the generator used to draw the acceptance thresholds.
+             *          The solver calls this, drawing the seed from the algorithm
+             *          status generator, when the criterion is set or the solver
+             *          is seeded.
+             */
+            void set_seed(std::mt19937::result_type seed) {
+                mt.seed(seed);
+                cached_iteration = std::numeric_limits<std::size_t>::max();
+            }
+
+        private:
+
+            std::mt19937 mt = rnd::get_seeded_mt();
+            std::size_t cached_iteration = std::numeric_limits<std::size_t>::max();
+            float cached_slack = 0.0f;
+        };
+
+        /** @brief  Late acceptance hill climbing: accepts a new solution if it is not
+         *          worse than the current one, or than the current solution of
+         *          \ref history_length iterations before.
+         *
+         *          This criterion does not need a schedule.
+         */
+        template<class Solution>
+        struct LateAcceptanceHillClimbing {
+            std::size_t history_length;
+
+            LateAcceptanceHillClimbing() : history_length{1000u} {}
+
+            explicit LateAcceptanceHillClimbing(const boost::property_tree::ptree& pt) {
+                try {
+                    history_length = pt.get<std::size_t>("acceptance.history_length");
+                } catch(...) {
+                    history_length = 1000u;
+                }
+            }
+
+            /** @brief  Gives a cost above which new solutions are rejected.
+             */
+            float rejection_bound(const AlgorithmStatus<Solution>& status) {
+                const auto length = std::max<std::size_t>(1u, history_length);
+
+                if(history.size() != length) {
+                    history.assign(length, status.get_current_cost());
+                }
+
+                return std::max(status.get_current_cost(), history[status.get_iteration_number() % history.size()]);
+            }
+
+            bool operator()(AlgorithmStatus<Solution>& status) {
+                const auto accept = status.get_new_cost() <= rejection_bound(status);
+
+                // In batched mode this is called once per examined candidate: the last
+                // call in the iteration, which corresponds to the kept candidate, wins.
+                history[status.get_iteration_number() % history.size()] =
+                    accept ? status.get_new_cost() : status.get_current_cost();
+
+                return accept;
+            }
+
+        private:
+
+            std::vector<float> history;
         };
     }
 }
@@ -0,0 +1,428 @@
+//
+// Created by alberto on 14/10/26.
+//
+
+#ifndef AS_ALNS_PARALLEL_H
+#define AS_ALNS_PARALLEL_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <exception>
+#include <functional>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "alns.h"
+#include "thread_pool.h"
+
+namespace as {
+    namespace alns {
+        /** @brief  Parameters specific to the parallel (island model) ALNS.
+         */
+        struct ParallelAlgorithmParams {
+            /**
+             * Number of islands, i.e. of independent ALNS runs which are
+             * executed concurrently, each on its own thread.
+             */
+            std::uint32_t n_islands;
+
+            /**
+             * Number of iterations each island performs between two
+             * consecutive migrations.
+             */
+            std::uint32_t migration_interval;
+
+            /**
+             * If true, when migrating, the scores of destroy and repair methods
+             * are averaged over all islands, and all islands continue with the
+             * averaged scores.
+             */
+            bool share_scores;
+
+            /**
+             * If true, when migrating, the overall best solution replaces the
+             * current solution of the islands with a worse best solution, too.
+             * This speeds up convergence, but all such islands then continue
+             * from the same solution, which reduces diversity. If false, only
+             * their best solution is replaced.
+             */
+            bool replace_current;
+
+            /** @brief Default constructor.
+             */
+            ParallelAlgorithmParams() :
+                n_islands{default_n_islands()},
+                migration_interval{100u},
+                share_scores{false},
+                replace_current{false} {}
+
+            /** @brief  Builds the params object from a json file.
+             *
+             *          Relevant parameters will be inside a "parallel" object at the root
+             *          level of the json file, and will be named: n_islands,
+             *          migration_interval, share_scores, and replace_current.
+             *
+             *  @param  params_file The json file with the parameter values.
+             */
+            ParallelAlgorithmParams(std::string params_file) {
+                using namespace boost::property_tree;
+
+                ptree pt;
+                read_json(params_file, pt);
+
+                try {
+                    n_islands = pt.get<std::uint32_t>("parallel.n_islands");
+                } catch(...) {
+                    n_islands = default_n_islands();
+                }
+
+                try {
+                    migration_interval = pt.get<std::uint32_t>("parallel.migration_interval");
+                } catch(...) {
+                    migration_interval = 100u;
+                }
+
+                try {
+                    share_scores = pt.get<bool>("parallel.share_scores");
+                } catch(...) {
+                    share_scores = false;
+                }
+
+                try {
+                    replace_current = pt.get<bool>("parallel.replace_current");
+                } catch(...) {
+                    replace_current = false;
+                }
+            }
+
+        private:
+
+            static std::uint32_t default_n_islands() {
+                return std::max(1u, std::thread::hardware_concurrency());
+            }
+        };
+
+        /** @brief  A parallel ALNS solver, implementing the island model.
+         *
+         *          The solver runs several independent \ref ALNSSolver instances
+         *          (the islands), each with its own algorithm status, pseudo-random
+         *          number generator, destroy and repair method instances, acceptance
+         *          criterion and visitor. Every \ref ParallelAlgorithmParams::migration_interval
+         *          iterations the islands synchronise: the overall best solution
+         *          replaces the best solution (and, optionally, the current solution)
+         *          of the islands which have a worse best solution and, optionally,
+         *          the destroy and repair methods scores are averaged. The algorithm
+         *          stops, at the next synchronisation, as soon as the visitor of any
+         *          island asks to stop.
+         *
+         *          The islands run on a pool of persistent threads, created with the
+         *          solver, so that synchronising does not create threads.
+         *
+         *          Because each island gets its own instances of the methods, these
+         *          are added via factories, which are called once per island.
+         *
+         *  @tparam Solution                The problem-specific solution type.
+         *  @tparam AcceptanceCriterion     The acceptance criterion type. Must be copiable.
+         *  @tparam AlgorithmVisitor        The solution visitor type. Must be copiable.
+         */
+        template<
+                class Solution,
+                class AcceptanceCriterion = DefaultAcceptanceCriterion<Solution>,
+                class AlgorithmVisitor = DefaultAlgorithmVisitor<Solution>
+        >
+        class ParallelALNSSolver {
+        public:
+            /**
+             * The solver type used for each island.
+             */
+            using Island = ALNSSolver<Solution, AcceptanceCriterion, AlgorithmVisitor>;
+
+            /**
+             * Type of a function which creates a new destroy method.
+             */
+            using DestroyMethodFactory = std::function<std::unique_ptr<DestroyMethod<Solution>>()>;
+
+            /**
+             * Type of a function which creates a new repair method.
+             */
+            using RepairMethodFactory = std::function<std::unique_ptr<RepairMethod<Solution>>()>;
+
+        private:
+            /**
+             * Parallel algorithm parameters.
+             */
+            ParallelAlgorithmParams parallel_params;
+
+            /**
+             * The islands. We keep them behind pointers, because each island's
+             * status holds a reference to the island's parameters.
+             */
+            std::vector<std::unique_ptr<Island>> islands;
+
+            /**
+             * Threads running the islands, one per island, including the thread
+             * calling \ref solve.
+             */
+            concurrency::ThreadPool pool;
+
+        public:
+            /** @brief  Creates a new solver, given the parameters and an initial solution.
+             *
+             *  @param params               The parameters used by each island.
+             *  @param parallel_params      The parallel parameters.
+             *  @param initial_solution     The initial solution, shared by all islands.
+             */
+            ParallelALNSSolver(AlgorithmParams params, ParallelAlgorithmParams parallel_params, Solution initial_solution) :
+                    parallel_params{parallel_params}, pool{std::max<std::size_t>(parallel_params.n_islands, 1u)}
+            {
+                assert(parallel_params.n_islands > 0u);
+                assert(parallel_params.migration_interval > 0u);
+
+                for(auto i = 0u; i < parallel_params.n_islands; ++i) {
+                    islands.push_back(std::make_unique<Island>(params, initial_solution));
+                }
+            }
+
+            /** @brief  Gets the number of islands.
+             *
+             *  @return The number of islands.
+             */
+            std::size_t number_of_islands() const {
+                return islands.size();
+            }
+
+            /** @brief  Gets an editable (non-const) reference to an island.
+             *
+             *  @param  island_id   The index of the island.
+             *  @return             The island's solver.
+             */
+            Island& get_island(std::size_t island_id) {
+                return *islands.at(island_id);
+            }
+
+            /** @brief  Gets an editable (non-const) reference to the status of an island.
+             *
+             *  @param  island_id   The index of the island.
+             *  @return             The island's algorithm status.
+             */
+            AlgorithmStatus<Solution>& get_island_status(std::size_t island_id) {
+                return islands.at(island_id)->get_status();
+            }
+
+            /** @brief  Gets the parallel algorithm parameters.
+             *
+             *  @return The parallel algorithm parameters.
+             */
+            const ParallelAlgorithmParams& get_parallel_params() const {
+                return parallel_params;
+            }
+
+            /** @brief  Seeds the pseudo-random number generators of the islands (and of
+             *          their acceptance criteria, see \ref ALNSSolver::set_seed), so that
+             *          runs can be reproduced. Island i gets seed \p seed + i.
+             *
+             *  @param  seed    The seed of the first island.
+             */
+            void set_seed(std::mt19937::result_type seed) {
+                for(auto i = 0u; i < islands.size(); ++i) {
+                    islands[i]->set_seed(seed + i);
+                }
+            }
+
+            /** @brief  Sets a new algorithm visitor. Each island gets its own copy.
+             *
+             *  @param  visitor The algorithm visitor.
+             */
+            void set_visitor(AlgorithmVisitor visitor) {
+                for(auto& island : islands) {
+                    island->set_visitor(visitor);
+                }
+            }
+
+            /** @brief  Sets a new acceptance criterion. Each island gets its own copy,
+             *          re-seeded from the island generator if the criterion has its
+             *          own one (see \ref has_seed).
+             *
+             *  @param  acceptance  The acceptance criterion.
+             */
+            void set_acceptance_criterion(AcceptanceCriterion acceptance) {
+                for(auto& island : islands) {
+                    island->set_acceptance_criterion(acceptance);
+                }
+            }
+
+            /** @brief  Adds a new destroy method to the destroy methods pool of each island.
+             *
+             *  @param  factory A function returning a new instance of the destroy method.
+             *                  It is called once per island.
+             *  @return         The index of the newly added destroy method in the destroy methods vector.
+             */
+            std::size_t add_destroy_method(const DestroyMethodFactory& factory) {
+                std::size_t id = 0u;
+
+                for(auto& island : islands) {
+                    id = island->add_destroy_method(factory());
+                }
+
+                return id;
+            }
+
+            /** @brief  Adds a new repair method to the repair methods pool of each island.
+             *
+             *  @param  factory A function returning a new instance of the repair method.
+             *                  It is called once per island.
+             *  @return         The index of the newly added repair method in the repair methods vector.
+             */
+            std::size_t add_repair_method(const RepairMethodFactory& factory) {
+                std::size_t id = 0u;
+
+                for(auto& island : islands) {
+                    id = island->add_repair_method(factory());
+                }
+
+                return id;
+            }
+
+            /** @brief  Gets an editable (non-const) reference to the overall best
+             *          solution, i.e. the best among the best solutions of all islands.
+             *
+             *  @return The overall best solution.
+             */
+            Solution& get_best_solution() {
+                return islands[best_island_id()]->get_status().get_best_solution();
+            }
+
+            /** @brief  Launches the algorithm.
+             *
+             *          Each island runs on its own thread of the pool, one of which is the
+             *          calling thread. The islands run \ref ParallelAlgorithmParams::migration_interval
+             *          iterations, then synchronise, and so on until the visitor of any island
+             *          asks to stop. If the methods of any island throw, the exception is
+             *          rethrown here, after all islands terminated their current run.
+             *
+             *          The elapsed time of the islands, and thus \ref AlgorithmParams::time_limit_sec,
+             *          is wall-clock time: after each synchronisation, all islands are set to the
+             *          time elapsed since the start of the run, including the time spent waiting
+             *          for slower islands and migrating. An island only checks its own clock in
+             *          between, so a run can exceed the limit by at most one migration interval.
+             */
+            void solve() {
+                using namespace std::chrono;
+                const auto n_islands = islands.size();
+
+                // Resume from the furthest island, e.g. after a previous call to solve.
+                float resumed_sec = 0.0f;
+
+                for(const auto& island : islands) {
+                    resumed_sec = std::max(resumed_sec, island->get_status().elapsed_time_sec);
+                }
+
+                const auto start_time = steady_clock::now() - duration_cast<steady_clock::duration>(duration<float>(resumed_sec));
+
+                // We don't use a vector<bool> because different threads will write
+                // to different elements concurrently.
+                std::vector<char> keep_going(n_islands, 1);
+                std::vector<std::exception_ptr> errors(n_islands);
+
+                const std::function<void(std::size_t)> run_island = [&] (std::size_t island_id) -> void {
+                    try {
+                        keep_going[island_id] = islands[island_id]->solve_iterations(parallel_params.migration_interval);
+                    } catch(...) {
+                        keep_going[island_id] = 0;
+                        errors[island_id] = std::current_exception();
+                    }
+                };
+
+                while(true) {
+                    pool.run(n_islands, run_island);
+
+                    for(const auto& error : errors) {
+                        if(error) {
+                            std::rethrow_exception(error);
+                        }
+                    }
+
+                    migrate();
+
+                    const auto elapsed_sec = duration_cast<duration<float>>(steady_clock::now() - start_time).count();
+
+                    for(auto& island : islands) {
+                        island->get_status().elapsed_time_sec = elapsed_sec;
+                    }
+
+                    if(!std::all_of(keep_going.begin(), keep_going.end(), [] (char k) { return k != 0; })) {
+                        return;
+                    }
+                }
+            }
+
+        private:
+
+            std::size_t best_island_id() {
+                std::size_t best_id = 0u;
+
+                for(auto i = 1u; i < islands.size(); ++i) {
+                    if(islands[i]->get_status().best_cost < islands[best_id]->get_status().best_cost) {
+                        best_id = i;
+                    }
+                }
+
+                return best_id;
+            }
+
+            void migrate() {
+                const auto best_id = best_island_id();
+                const auto& best_solution = islands[best_id]->get_status().best_solution;
+                const auto best_cost = islands[best_id]->get_status().best_cost;
+
+                for(auto i = 0u; i < islands.size(); ++i) {
+                    if(i == best_id) { continue; }
+
+                    auto& status = islands[i]->get_status();
+
+                    if(best_cost < status.best_cost) {
+                        status.best_solution = best_solution;
+                        status.best_cost = best_cost;
+                        status.last_improvement_iteration = status.iteration_number;
+
+                        if(parallel_params.replace_current) {
+                            status.current_solution = best_solution;
+                            status.mark_current_solution_modified();
+                        }
+                    }
+                }
+
+                if(parallel_params.share_scores) {
+                    average_scores([] (auto& status) -> rnd::WeightedSampler<float>& { return status.destroy_scores; });
+                    average_scores([] (auto& status) -> rnd::WeightedSampler<float>& { return status.repair_scores; });
+                }
+            }
+
+            template<class ScoresGetter>
+            void average_scores(ScoresGetter get_scores) {
+                std::vector<float> average(get_scores(islands[0]->get_status()).size(), 0.0f);
+
+                for(auto& island : islands) {
+                    const auto& scores = get_scores(island->get_status()).get_weights();
+                    assert(scores.size() == average.size());
+
+                    for(auto i = 0u; i < scores.size(); ++i) {
+                        average[i] += scores[i] / islands.size();
+                    }
+                }
+
+                for(auto& island : islands) {
+                    get_scores(island->get_status()) = rnd::WeightedSampler<float>{average};
+                }
+            }
+        };
+    }
+}
+
+#endif //AS_ALNS_PARALLEL_H
@@ -6,51 +6,87 @@
 #define AS_COMBINATORIAL_H
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
+#include <utility>
 #include <algorithm>
 #include <limits>
 #include <cassert>
+#include <type_traits>
+
+#include "thread_pool.h"
 
 namespace as {
     /** @namespace combi
      *  @brief     This namespace contains utilities related to combinatorics.
      */
     namespace combi {
+        /** @brief  Passed to Gray code visitors as the flipped element, for the first subset.
+         */
+        static constexpr std::size_t no_flipped_element = std::numeric_limits<std::size_t>::max();
+
         namespace detail {
-            template<typename Visitor>
-            inline void recursive_visit_subsets(std::vector<bool>& indicator, Visitor *const visitor, bool start_from_smaller, std::vector<bool>::size_type pivot) {
-                // The algorithm does not work is the vector "indicator" has exactly the largest possible
-                // size for a vector<bool> (!!)
-                assert(indicator.size() < std::numeric_limits<std::vector<bool>::size_type>::max());
+            /** @brief  Moves the indicator vector to the next subset, in the order given by
+             *          \p start_from_smaller. Element 0 is the least significant bit of the
+             *          number the vector represents.
+             *
+             *  @return False if the vector was the last subset.
+             */
+            inline bool next_subset(std::vector<bool>& indicator, bool start_from_smaller) {
+                // Counting up: trailing ones become zeros, and the first zero becomes a one.
+                // Counting down is the same, with zeros and ones swapped.
+                for(std::vector<bool>::size_type i = 0u; i < indicator.size(); ++i) {
+                    if(indicator[i] != start_from_smaller) {
+                        indicator[i] = start_from_smaller;
+                        return true;
+                    }
+
+                    indicator[i] = !start_from_smaller;
+                }
 
-                if(pivot == std::numeric_limits<std::vector<bool>::size_type>::max()) { // Relies on size_t underflow
-                    (*visitor)(indicator);
+                return false;
+            }
+
+            /** @brief  Calls the visitor, and tells whether to stop. Visitors returning void
+             *          never stop the enumeration.
+             */
+            template<typename Visitor, typename... Args>
+            inline bool visit_and_check_termination(Visitor *const visitor, Args&&... args) {
+                if constexpr(std::is_same<decltype((*visitor)(std::forward<Args>(args)...)), void>::value) {
+                    (*visitor)(std::forward<Args>(args)...);
+                    return false;
                 } else {
-                    indicator[pivot] = !start_from_smaller;
-                    recursive_visit_subsets(indicator, visitor, start_from_smaller, pivot - 1);
-                    indicator[pivot] = start_from_smaller;
-                    recursive_visit_subsets(indicator, visitor, start_from_smaller, pivot - 1);
+                    return static_cast<bool>((*visitor)(std::forward<Args>(args)...));
                 }
             }
 
-            // Returns true if it should terminate early.
-            template<typename EarlyTerminateVisitor>
-            inline bool recursive_visit_subsets_with_early_termination(std::vector<bool>& indicator, EarlyTerminateVisitor *const visitor, bool start_from_smaller, std::vector<bool>::size_type pivot) {
-                // The algorithm does not work is the vector "indicator" has exactly the largest possible
-                // size for a vector<bool> (!!)
-                assert(indicator.size() < std::numeric_limits<std::vector<bool>::size_type>::max());
+            /** @brief  Enumerates, in Gray code order, the subsets of the lowest
+             *          \p free_bits elements, each joined with the elements in \p fixed.
+             *
+             *  @return True if the visitor asked to terminate early.
+             */
+            template<typename Visitor>
+            inline bool gray_visit(std::uint64_t fixed, std::size_t free_bits, Visitor *const visitor) {
+                std::uint64_t mask = fixed;
+
+                if(visit_and_check_termination(visitor, mask, no_flipped_element)) {
+                    return true;
+                }
+
+                // The i-th Gray code differs from the previous one in the lowest set bit of i. The
+                // counter wraps to 0 after 2^64 - 1, which is the end when there are 64 free bits.
+                const std::uint64_t end = (free_bits == 64u) ? 0u : (std::uint64_t{1u} << free_bits);
 
-                if(pivot == std::numeric_limits<std::vector<bool>::size_type>::max()) { // Relies on size_t underflow
-                    return ((*visitor)(indicator));
-                } else {
-                    indicator[pivot] = !start_from_smaller;
-                    if(recursive_visit_subsets_with_early_termination(indicator, visitor, start_from_smaller, pivot - 1)) {
+                for(std::uint64_t i = 1u; i != end; ++i) {
+                    const auto flipped = static_cast<std::size_t>(__builtin_ctzll(i));
+                    mask ^= std::uint64_t{1u} << flipped;
+
+                    if(visit_and_check_termination(visitor, mask, flipped)) {
                         return true;
                     }
-
-                    indicator[pivot] = start_from_smaller;
-                    return recursive_visit_subsets_with_early_termination(indicator, visitor, start_from_smaller, pivot - 1);
                 }
+
+                return false;
             }
         }
 
@@ -61,9 +97,12 @@ namespace as {
          *  {0,0,0}, {0,0,1}, {0,1,0}, {0,1,1}, {1,0,0}, {1,0,1}, {1,1,0}, {1,1,1}
          *  If \p start_from_smaller is false, then the sequence would be reversed.
          *
+         *  The subsets are generated iteratively, in amortised constant time each. Visitors
+         *  which can update their state when one element flips should rather use
+         *  \ref visit_subsets_gray.
+         *
          *  @tparam Visitor             The class of visitor called on each subset (which is passed as a vector<bool>).
-         *  @param  size                Size of the original set. Must be strictly smaller than
-         *                              `std::numeric_limits<std::vector<bool>::size_type>::max()`.
+         *  @param  size                Size of the original set.
          *  @param  visitor             An instance of the visitor.
          *  @param  start_from_smaller  Tells the order in which the subsets should be visited. Smaller does not refer
          *                              to the size of the subset (i.e. the number of ones in the indicator vector).
@@ -72,8 +111,11 @@ namespace as {
          */
         template<typename Visitor>
         inline void visit_subsets(std::size_t size, Visitor *const visitor, bool start_from_smaller = true) {
-            std::vector<bool> indicator(size);
-            detail::recursive_visit_subsets(indicator, visitor, start_from_smaller, indicator.size() - 1);
+            std::vector<bool> indicator(size, !start_from_smaller);
+
+            do {
+                (*visitor)(indicator);
+            } while(detail::next_subset(indicator, start_from_smaller));
         }
 
         /** @brief Visits with a user-specified visitors all the subset of an indicator (0-1)
@@ -88,8 +130,7 @@ namespace as {
          *
          *  @tparam Visitor             The class of visitor called on each subset (which is passed as a vector<bool>).
          *                              It returns true if it wants the algorithm to terminate early, and false otherwise.
-         *  @param  size                Size of the original set. Must be strictly smaller than
-         *                              `std::numeric_limits<std::vector<bool>::size_type>::max()`.
+         *  @param  size                Size of the original set.
          *  @param  visitor             An instance of the visitor.
          *  @param  start_from_smaller  Tells the order in which the subsets should be visited. Smaller does not refer
          *                              to the size of the subset (i.e. the number of ones in the indicator vector).
@@ -98,8 +139,133 @@ namespace as {
          */
         template<typename Visitor>
         inline void visit_subsets_with_early_termination(std::size_t size, Visitor *const visitor, bool start_from_smaller = true) {
-            std::vector<bool> indicator(size);
-            detail::recursive_visit_subsets_with_early_termination(indicator, visitor, start_from_smaller, indicator.size() - 1);
+            std::vector<bool> indicator(size, !start_from_smaller);
+
+            do {
+                if((*visitor)(indicator)) { return; }
+            } while(detail::next_subset(indicator, start_from_smaller));
+        }
+
+        /** @brief Visits all the subsets of a set of at most 64 elements, in Gray code order.
+         *
+         *  Subsets are passed to the visitor as a bit mask (bit i is set iff element i is
+         *  in the subset), together with the element which was added or removed to get it
+         *  from the previous subset. Consecutive subsets differ by exactly one element, so
+         *  visitors can keep their state up to date in constant time. The first subset is the
+         *  empty set, for which the element passed is \ref no_flipped_element.
+         *
+         *  For example, if \p size is 3, the visitor will be called on the masks
+         *  0, 1, 3, 2, 6, 7, 5, 4, with flipped elements (none), 0, 1, 0, 2, 0, 1, 0.
+         *
+         *  If the visitor returns a value convertible to bool, a true value stops the enumeration.
+         *
+         *  @tparam Visitor     The class of the visitor, called as visitor(std::uint64_t mask, std::size_t flipped).
+         *  @param  size        Size of the original set. Must be at most 64.
+         *  @param  visitor     An instance of the visitor.
+         */
+        template<typename Visitor>
+        inline void visit_subsets_gray(std::size_t size, Visitor *const visitor) {
+            assert(size <= 64u);
+            detail::gray_visit(std::uint64_t{0u}, size, visitor);
+        }
+
+        /** @brief Visits, in Gray code order, the subsets of a set of at most 64 elements
+         *         whose highest \p prefix_size elements are given by \p prefix.
+         *
+         *  There are pow(2, \p prefix_size) prefixes, whose ranges partition all subsets, so
+         *  that the enumeration can be split across threads by handing out prefixes (see
+         *  \ref visit_subsets_gray_parallel). The visitor is called as in \ref visit_subsets_gray;
+         *  the first subset is the one containing only the elements of the prefix.
+         *
+         *  @tparam Visitor     The class of the visitor, called as visitor(std::uint64_t mask, std::size_t flipped).
+         *  @param  size        Size of the original set. Must be at most 64.
+         *  @param  prefix_size Number of elements fixed by the prefix. Must be at most \p size.
+         *  @param  prefix      The prefix: bit i tells whether element size - prefix_size + i is in the subsets.
+         *  @param  visitor     An instance of the visitor.
+         */
+        template<typename Visitor>
+        inline void visit_subsets_gray_with_prefix(std::size_t size, std::size_t prefix_size, std::uint64_t prefix, Visitor *const visitor) {
+            assert(size <= 64u);
+            assert(prefix_size <= size);
+
+            const auto free_bits = size - prefix_size;
+            const auto fixed = (free_bits == 64u) ? std::uint64_t{0u} : (prefix << free_bits);
+
+            detail::gray_visit(fixed, free_bits, visitor);
+        }
+
+        /** @brief Visits all the subsets of a set of at most 64 elements, in parallel.
+         *
+         *  The subsets are split in ranges with a common prefix (see \ref visit_subsets_gray_with_prefix),
+         *  a few per thread, which the threads of the pool visit concurrently. Each range is visited
+         *  in Gray code order by its own visitor, built by calling \p make_visitor with the index of
+         *  the range, so that visitors need no synchronisation while they run. Visitors can stop the
+         *  enumeration of their own range, as in \ref visit_subsets_gray.
+         *
+         *  @tparam VisitorFactory  A class such that make_visitor(std::size_t range) returns a visitor.
+         *  @param  size            Size of the original set. Must be at most 64.
+         *  @param  pool            The threads to use.
+         *  @param  make_visitor    Builds the visitor of each range.
+         *  @return                 The number of ranges.
+         */
+        template<typename VisitorFactory>
+        inline std::size_t visit_subsets_gray_parallel(std::size_t size, concurrency::ThreadPool& pool, const VisitorFactory& make_visitor) {
+            assert(size <= 64u);
+
+            // Enough ranges to balance the load when they take different times.
+            std::size_t prefix_size = 0u;
+
+            while(prefix_size < size && (std::size_t{1u} << prefix_size) < 4u * pool.size()) {
+                ++prefix_size;
+            }
+
+            const auto n_ranges = std::size_t{1u} << prefix_size;
+
+            pool.run(n_ranges, [&] (std::size_t range) {
+                auto visitor = make_visitor(range);
+                visit_subsets_gray_with_prefix(size, prefix_size, static_cast<std::uint64_t>(range), &visitor);
+            });
+
+            return n_ranges;
+        }
+
+        /** @brief Visits all the subsets with exactly \p k elements of a set of at most 64 elements.
+         *
+         *  Subsets are passed to the visitor as bit masks, in increasing order, and each is
+         *  computed from the previous one in constant time (Gosper's hack).
+         *  If the visitor returns a value convertible to bool, a true value stops the enumeration.
+         *
+         *  For example, if \p size is 4 and \p k is 2, the visitor will be called on the masks
+         *  3, 5, 6, 9, 10, 12.
+         *
+         *  @tparam Visitor     The class of the visitor, called as visitor(std::uint64_t mask).
+         *  @param  size        Size of the original set. Must be at most 64.
+         *  @param  k           Size of the subsets. Must be at most \p size.
+         *  @param  visitor     An instance of the visitor.
+         */
+        template<typename Visitor>
+        inline void visit_subsets_of_size(std::size_t size, std::size_t k, Visitor *const visitor) {
+            assert(size <= 64u);
+            assert(k <= size);
+
+            if(k == 0u) {
+                detail::visit_and_check_termination(visitor, std::uint64_t{0u});
+                return;
+            }
+
+            const std::uint64_t last = (k == 64u) ? ~std::uint64_t{0u} : (((std::uint64_t{1u} << k) - 1u) << (size - k));
+            std::uint64_t mask = (k == 64u) ? ~std::uint64_t{0u} : ((std::uint64_t{1u} << k) - 1u);
+
+            while(true) {
+                if(detail::visit_and_check_termination(visitor, mask)) { return; }
+                if(mask == last) { return; }
+
+                // The next number with the same number of ones: the lowest block of ones moves
+                // its highest one up by one position, and the others go back to the bottom.
+                const auto lowest = mask & (~mask + 1u);
+                const auto ripple = mask + lowest;
+                mask = ripple | (((mask ^ ripple) >> 2u) / lowest);
+            }
         }
 
         /** @brief Check whether a vector si a rotation (cyclic permutation) of another one.
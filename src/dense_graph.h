@@ -0,0 +1,426 @@
+//
+// Created by alberto on 14/10/26.
+//
+
+#ifndef AS_DENSE_GRAPH_H
+#define AS_DENSE_GRAPH_H
+
+#include <boost/graph/graph_traits.hpp>
+#include <boost/graph/adjacency_list.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <type_traits>
+
+namespace as {
+    namespace graph {
+        /** @namespace bits
+         *  @brief     Word-parallel operations on sets of vertices stored as bitsets,
+         *             i.e. as arrays of 64-bit words where bit i % 64 of word i / 64
+         *             tells whether vertex i is in the set.
+         */
+        namespace bits {
+            /** @brief  The type of the words making up a bitset.
+             */
+            using Word = std::uint64_t;
+
+            /** @brief  Number of bits in a \ref Word.
+             */
+            static constexpr std::size_t bits_per_word = 64u;
+
+            /** @brief          Number of words needed to store a set of n elements.
+             */
+            inline constexpr std::size_t number_of_words(std::size_t n) {
+                return (n + bits_per_word - 1u) / bits_per_word;
+            }
+
+            /** @brief          Tells whether element i is in the set.
+             */
+            inline bool test(const Word* set, std::size_t i) {
+                return (set[i / bits_per_word] >> (i % bits_per_word)) & Word{1u};
+            }
+
+            /** @brief          Adds element i to the set.
+             */
+            inline void set(Word* set, std::size_t i) {
+                set[i / bits_per_word] |= Word{1u} << (i % bits_per_word);
+            }
+
+            /** @brief          Removes element i from the set.
+             */
+            inline void reset(Word* set, std::size_t i) {
+                set[i / bits_per_word] &= ~(Word{1u} << (i % bits_per_word));
+            }
+
+            /** @brief          Gives the number of elements in the set.
+             */
+            inline std::size_t count(const Word* set, std::size_t words) {
+                std::size_t n = 0u;
+
+                for(auto w = 0u; w < words; ++w) {
+                    n += static_cast<std::size_t>(__builtin_popcountll(set[w]));
+                }
+
+                return n;
+            }
+
+            /** @brief          Gives the number of elements in the intersection of two sets,
+             *                  without computing the intersection.
+             */
+            inline std::size_t count_intersection(const Word* a, const Word* b, std::size_t words) {
+                std::size_t n = 0u;
+
+                for(auto w = 0u; w < words; ++w) {
+                    n += static_cast<std::size_t>(__builtin_popcountll(a[w] & b[w]));
+                }
+
+                return n;
+            }
+
+            /** @brief          Tells whether the set is empty.
+             */
+            inline bool none(const Word* set, std::size_t words) {
+                return std::all_of(set, set + words, [] (Word word) { return word == 0u; });
+            }
+
+            /** @brief          Writes a & b into out, which can alias either of them.
+             */
+            inline void intersect(Word* out, const Word* a, const Word* b, std::size_t words) {
+                for(auto w = 0u; w < words; ++w) {
+                    out[w] = a[w] & b[w];
+                }
+            }
+
+            /** @brief          Writes a & ~b into out, which can alias either of them.
+             */
+            inline void subtract(Word* out, const Word* a, const Word* b, std::size_t words) {
+                for(auto w = 0u; w < words; ++w) {
+                    out[w] = a[w] & ~b[w];
+                }
+            }
+
+            /** @brief          Calls f on each element of the set, in increasing order.
+             *
+             *  The set is read one word at a time, so f can remove from the set elements
+             *  in words which have not been reached yet.
+             */
+            template<class F>
+            inline void for_each(const Word* set, std::size_t words, F&& f) {
+                for(auto w = 0u; w < words; ++w) {
+                    for(auto word = set[w]; word != 0u; word &= word - 1u) {
+                        f(w * bits_per_word + static_cast<std::size_t>(__builtin_ctzll(word)));
+                    }
+                }
+            }
+        }
+
+        /** @class  DenseGraph
+         *  @brief  An undirected simple graph stored as an adjacency matrix of bits.
+         *
+         *          Row v of the matrix is the bitset of the neighbours of v (see
+         *          \ref bits), so that adjacency tests take O(1) time, and intersecting
+         *          or complementing neighbourhoods takes O(n / 64) time. The matrix takes
+         *          n^2 / 8 bytes, so the representation pays off on dense graphs and on
+         *          algorithms which test many pairs of vertices, such as those computing
+         *          complements, cliques and independent sets.
+         *
+         *          Vertices are numbered from 0 to n - 1, as in Boost graphs whose
+         *          vertices are stored in a vector.
+         */
+        class DenseGraph {
+            /** @brief Number of vertices.
+             */
+            std::size_t n;
+
+            /** @brief Number of words in each row of the matrix.
+             */
+            std::size_t words;
+
+            /** @brief The adjacency matrix, row by row.
+             */
+            std::vector<bits::Word> matrix;
+
+        public:
+            /** @brief      Builds a graph with n vertices and no edges.
+             *
+             *  @param n    The number of vertices.
+             */
+            explicit DenseGraph(std::size_t n = 0u) :
+                n{n}, words{bits::number_of_words(n)}, matrix(n * bits::number_of_words(n), 0u) {}
+
+            /** @brief      Builds the dense version of a Boost graph.
+             *
+             *  For directed graphs, two vertices are adjacent iff there is an arc between
+             *  them in either direction, as in \ref are_connected. Loops and parallel edges
+             *  are dropped.
+             *
+             *  @tparam BoostGraph  The underlying graph type. Vertices must be stored in a vector.
+             *  @param  graph       The graph.
+             *  @return             The dense graph.
+             */
+            template<class BoostGraph>
+            static DenseGraph from_boost(const BoostGraph& graph) {
+                static_assert(
+                    std::is_same<typename BoostGraph::vertex_list_selector, boost::vecS>::value,
+                    "DenseGraph::from_boost only works when vertices are stored in a vector."
+                );
+
+                DenseGraph dense{boost::num_vertices(graph)};
+                auto [it, end] = boost::edges(graph);
+
+                for(; it != end; ++it) {
+                    const auto source = boost::source(*it, graph);
+                    const auto target = boost::target(*it, graph);
+
+                    if(source != target) {
+                        dense.add_edge(source, target);
+                    }
+                }
+
+                return dense;
+            }
+
+            /** @brief      Adds the edges of this graph to a Boost graph with the same
+             *              number of vertices (and with vertices stored in a vector). In a
+             *              directed graph, the arc from the lower to the higher vertex is added.
+             *
+             *  @tparam BoostGraph  The underlying graph type.
+             *  @param  graph       The graph to which the edges are added.
+             */
+            template<class BoostGraph>
+            void add_edges_to(BoostGraph& graph) const {
+                assert(boost::num_vertices(graph) == n);
+
+                for(auto v = 0u; v < n; ++v) {
+                    const auto* row = neighbourhood(v);
+
+                    // Only look at the neighbours higher than v, starting from the word containing v + 1.
+                    const auto first_word = (v + 1u) / bits::bits_per_word;
+                    const auto first_mask = ~bits::Word{0u} << ((v + 1u) % bits::bits_per_word);
+
+                    for(auto w = first_word; w < words; ++w) {
+                        auto word = (w == first_word) ? (row[w] & first_mask) : row[w];
+
+                        for(; word != 0u; word &= word - 1u) {
+                            boost::add_edge(v, w * bits::bits_per_word + static_cast<std::size_t>(__builtin_ctzll(word)), graph);
+                        }
+                    }
+                }
+            }
+
+            /** @brief      Builds a Boost graph with the same vertices and edges, and with
+             *              default-constructed properties.
+             *
+             *  @tparam BoostGraph  The graph type to build. Vertices must be stored in a vector.
+             *  @return             The Boost graph.
+             */
+            template<class BoostGraph>
+            BoostGraph to_boost() const {
+                static_assert(
+                    std::is_same<typename BoostGraph::vertex_list_selector, boost::vecS>::value,
+                    "DenseGraph::to_boost only works when vertices are stored in a vector."
+                );
+
+                BoostGraph graph(n);
+                add_edges_to(graph);
+                return graph;
+            }
+
+            /** @brief  Gives the number of vertices.
+             */
+            std::size_t number_of_vertices() const { return n; }
+
+            /** @brief  Gives the number of words in each neighbourhood bitset.
+             */
+            std::size_t number_of_words() const { return words; }
+
+            /** @brief  Gives the number of edges. It takes O(n^2 / 64) time.
+             */
+            std::size_t number_of_edges() const {
+                return bits::count(matrix.data(), matrix.size()) / 2u;
+            }
+
+            /** @brief  Adds the edge {v, w}, if it is not there already.
+             */
+            void add_edge(std::size_t v, std::size_t w) {
+                assert(v < n && w < n && v != w);
+                bits::set(row(v), w);
+                bits::set(row(w), v);
+            }
+
+            /** @brief  Removes the edge {v, w}, if it is there.
+             */
+            void remove_edge(std::size_t v, std::size_t w) {
+                assert(v < n && w < n);
+                bits::reset(row(v), w);
+                bits::reset(row(w), v);
+            }
+
+            /** @brief  Tells whether v and w are adjacent.
+             */
+            bool are_connected(std::size_t v, std::size_t w) const {
+                assert(v < n && w < n);
+                return bits::test(neighbourhood(v), w);
+            }
+
+            /** @brief  Gives the bitset of the neighbours of v, made of
+             *          \ref number_of_words words.
+             */
+            const bits::Word* neighbourhood(std::size_t v) const {
+                assert(v < n);
+                return matrix.data() + v * words;
+            }
+
+            /** @brief  Gives the number of neighbours of v.
+             */
+            std::size_t degree(std::size_t v) const {
+                return bits::count(neighbourhood(v), words);
+            }
+
+            /** @brief  Gives the number of vertices adjacent to both v and w.
+             */
+            std::size_t number_of_common_neighbours(std::size_t v, std::size_t w) const {
+                return bits::count_intersection(neighbourhood(v), neighbourhood(w), words);
+            }
+
+            /** @brief  Calls f on each neighbour of v, in increasing order.
+             */
+            template<class F>
+            void for_each_neighbour(std::size_t v, F&& f) const {
+                bits::for_each(neighbourhood(v), words, std::forward<F>(f));
+            }
+
+            /** @brief  Gives the complement graph, which has an edge between two
+             *          distinct vertices iff this graph does not.
+             */
+            DenseGraph complement() const {
+                DenseGraph comp{n};
+
+                // Bits past the last vertex, in the last word of each row, must stay off.
+                const auto tail = n % bits::bits_per_word;
+                const auto last_mask = (tail == 0u) ? ~bits::Word{0u} : ((bits::Word{1u} << tail) - 1u);
+
+                for(auto v = 0u; v < n; ++v) {
+                    const auto* from = neighbourhood(v);
+                    auto* to = comp.row(v);
+
+                    for(auto w = 0u; w < words; ++w) {
+                        to[w] = ~from[w];
+                    }
+
+                    to[words - 1u] &= last_mask;
+                    bits::reset(to, v);
+                }
+
+                return comp;
+            }
+
+        private:
+
+            bits::Word* row(std::size_t v) {
+                return matrix.data() + v * words;
+            }
+        };
+
+        /** @brief  Finds a family of maximal independent sets such that any two non-adjacent
+         *          vertices are both in at least one of the sets.
+         *
+         *          The sets are the classes of a greedy colouring of the graph, each extended
+         *          to a maximal independent set, plus further sets grown greedily from the pairs
+         *          which are still uncovered. In a clique formulation, one inequality per set
+         *          replaces the inequalities of all the pairs it covers.
+         *
+         *  @param  graph   The graph.
+         *  @return         The independent sets, each sorted by increasing vertex.
+         */
+        inline std::vector<std::vector<std::size_t>> independent_set_cover(const DenseGraph& graph) {
+            const auto n = graph.number_of_vertices();
+            const auto words = graph.number_of_words();
+            const auto non_adjacent = graph.complement();
+
+            // Edges of this graph are the pairs of non-adjacent vertices which are already covered.
+            DenseGraph covered{n};
+            std::vector<std::vector<std::size_t>> sets;
+            std::vector<bits::Word> candidates(words);
+
+            // Grows the set into a maximal independent set, picking vertices from the candidates
+            // (which must be non-adjacent to all its vertices), and marks its pairs as covered.
+            auto complete = [&] (std::vector<std::size_t> set) {
+                for(auto w = 0u; w < words; ++w) {
+                    while(candidates[w] != 0u) {
+                        const auto v = w * bits::bits_per_word + static_cast<std::size_t>(__builtin_ctzll(candidates[w]));
+
+                        set.push_back(v);
+                        bits::intersect(candidates.data(), candidates.data(), non_adjacent.neighbourhood(v), words);
+                    }
+                }
+
+                if(set.size() < 2u) { return; }
+
+                std::sort(set.begin(), set.end());
+
+                for(auto i = 0u; i < set.size(); ++i) {
+                    for(auto j = i + 1u; j < set.size(); ++j) {
+                        covered.add_edge(set[i], set[j]);
+                    }
+                }
+
+                sets.push_back(std::move(set));
+            };
+
+            // Greedy colouring: each class takes the lowest uncoloured vertices which are not
+            // adjacent to the class, and is then extended with vertices of earlier classes.
+            std::vector<bits::Word> uncoloured(words, ~bits::Word{0u});
+
+            if(n % bits::bits_per_word != 0u) {
+                uncoloured.back() = (bits::Word{1u} << (n % bits::bits_per_word)) - 1u;
+            }
+
+            while(!bits::none(uncoloured.data(), words)) {
+                std::vector<std::size_t> set;
+                std::vector<bits::Word> colour_class = uncoloured;
+
+                for(auto w = 0u; w < words; ++w) {
+                    while(colour_class[w] != 0u) {
+                        const auto v = w * bits::bits_per_word + static_cast<std::size_t>(__builtin_ctzll(colour_class[w]));
+
+                        set.push_back(v);
+                        bits::reset(uncoloured.data(), v);
+                        bits::intersect(colour_class.data(), colour_class.data(), non_adjacent.neighbourhood(v), words);
+                    }
+                }
+
+                std::fill(candidates.begin(), candidates.end(), ~bits::Word{0u});
+
+                for(const auto v : set) {
+                    bits::intersect(candidates.data(), candidates.data(), non_adjacent.neighbourhood(v), words);
+                }
+
+                complete(std::move(set));
+            }
+
+            // Pairs which no colour class covers.
+            for(auto v = 0u; v < n; ++v) {
+                for(auto w = 0u; w < words; ++w) {
+                    auto uncovered = non_adjacent.neighbourhood(v)[w] & ~covered.neighbourhood(v)[w];
+
+                    while(uncovered != 0u) {
+                        const auto u = w * bits::bits_per_word + static_cast<std::size_t>(__builtin_ctzll(uncovered));
+                        uncovered &= uncovered - 1u;
+
+                        if(u < v || covered.are_connected(v, u)) { continue; }
+
+                        bits::intersect(candidates.data(), non_adjacent.neighbourhood(v), non_adjacent.neighbourhood(u), words);
+                        complete({v, u});
+                    }
+                }
+            }
+
+            return sets;
+        }
+    }
+}
+
+#endif //AS_DENSE_GRAPH_H
@@ -12,6 +12,10 @@
 #include <csignal>
 #include <numeric>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 
 #include "tsplib.h"
 #include "numeric.h"
@@ -22,12 +26,6 @@ namespace as {
      */
     namespace tsp {
         namespace {
-            inline sigjmp_buf concorde_signal_buffer;
-
-            inline void concorde_crash_handler(int) {
-                siglongjmp(concorde_signal_buffer, -1);
-            }
-
             enum class DiscordeStatus : std::uint32_t {
                 SUCCESS,
                 CONCORDE_CRASH,
@@ -36,47 +34,231 @@ namespace as {
             };
         }
 
+        namespace detail {
+            /** @brief  Buffers passed to Concorde, reused across calls on the same
+             *          thread, so that repeated solves do not allocate.
+             */
+            struct DiscordeScratch {
+                /** @brief The cost matrix, row-major and contiguous.
+                 */
+                std::vector<int> costs;
+
+                /** @brief Pointers to the rows of \ref costs, as Concorde wants them.
+                 */
+                std::vector<int*> rows;
+
+                /** @brief Distances from one node, as given by the instance, when
+                 *         solving on all nodes.
+                 */
+                std::vector<float> distances;
+
+                /** @brief The tour computed by Concorde.
+                 */
+                std::vector<int> tour;
+
+                /** @brief          Makes room for a problem with n nodes.
+                 */
+                void resize(std::size_t n) {
+                    // Shrinking a vector does not release its memory, so buffers only
+                    // grow to the size of the largest problem solved on the thread.
+                    costs.resize(n * n);
+                    rows.resize(n);
+                    tour.resize(n);
+
+                    for(auto i = 0u; i < n; ++i) {
+                        rows[i] = costs.data() + i * n;
+                    }
+                }
+            };
+
+            /** @brief  Gives the scratch buffers of the calling thread.
+             */
+            inline DiscordeScratch& discorde_scratch() {
+                thread_local DiscordeScratch scratch;
+                return scratch;
+            }
+
+            /** @brief  Fills the scratch buffers with the cost matrix of a subset of nodes,
+             *          as Concorde wants it. This is all the work \ref discorde_solve_tsp
+             *          does before calling Concorde.
+             *
+             *  @param  instance    The TSP instance.
+             *  @param  nodes       The subset of nodes of the instance to consider.
+             *  @param  scratch     The buffers to fill.
+             */
+            inline void fill_discorde_costs(const tsplib::TSPInstance& instance, const std::vector<std::uint32_t>& nodes, DiscordeScratch& scratch) {
+                const auto n_nodes = static_cast<int>(nodes.size());
+                scratch.resize(nodes.size());
+
+                // When solving on all nodes in their natural order, the rows of the cost matrix are
+                // the rows of the instance's distances, which we read in one go. Otherwise, we read
+                // the distances between the nodes of the subset, which is usually much smaller.
+                bool all_nodes = (nodes.size() == instance.number_of_vertices());
+
+                for(auto i = 0u; all_nodes && i < nodes.size(); ++i) {
+                    all_nodes = (nodes[i] == i);
+                }
+
+                if(all_nodes) {
+                    scratch.distances.resize(nodes.size());
+
+                    for(auto i = 0; i < n_nodes; ++i) {
+                        instance.get_distances_from(i, scratch.distances.data());
+                        std::transform(scratch.distances.begin(), scratch.distances.end(), scratch.rows[i],
+                                       [] (float d) { return static_cast<int>(d); });
+                    }
+                } else {
+                    for(auto i = 0; i < n_nodes; ++i) {
+                        for(auto j = 0; j < n_nodes; ++j) {
+                            scratch.rows[i][j] = static_cast<int>(instance.get_distance_unchecked(nodes[i], nodes[j]));
+                        }
+                    }
+                }
+            }
+
+            /** @brief  State used to recover from a crash in Concorde, which is
+             *          kept per thread so that threads can call Concorde concurrently.
+             */
+            struct ConcordeRecovery {
+                /** @brief Where to jump back to, if Concorde crashes.
+                 */
+                sigjmp_buf buffer;
+
+                /** @brief True while the thread is running Concorde.
+                 */
+                volatile std::sig_atomic_t active = 0;
+            };
+
+            /** @brief  Gives the recovery state of the calling thread.
+             */
+            inline ConcordeRecovery& concorde_recovery() {
+                thread_local ConcordeRecovery recovery;
+                return recovery;
+            }
+
+            /** @brief  The SIGSEGV action which was installed before ours.
+             */
+            inline struct sigaction previous_segv_action;
+
+            /** @brief  Handles SIGSEGV, which is delivered to the thread which caused it.
+             *
+             *  If the thread is running Concorde, it jumps back to before the call.
+             *  Otherwise, the crash is not ours: we restore the previous action and
+             *  return, so that the faulting instruction runs again and the previous
+             *  action (by default, terminating the process) takes place.
+             */
+            inline void concorde_crash_handler(int, siginfo_t*, void*) {
+                auto& recovery = concorde_recovery();
+
+                if(recovery.active) {
+                    recovery.active = 0;
+                    siglongjmp(recovery.buffer, -1);
+                }
+
+                ::sigaction(SIGSEGV, &previous_segv_action, nullptr);
+            }
+
+            /** @brief  Serialises the calls to Concorde, unless concurrent calls are allowed.
+             */
+            inline std::mutex& concorde_mutex() {
+                static std::mutex mutex;
+                return mutex;
+            }
+
+            /** @brief  Whether calls to Concorde may run concurrently, see
+             *          \ref as::tsp::allow_concurrent_concorde.
+             */
+            inline std::atomic<bool>& concorde_concurrent() {
+                static std::atomic<bool> concurrent{false};
+                return concurrent;
+            }
+
+            /** @brief  Installs \ref concorde_crash_handler, once per process.
+             *
+             *  The handler stays installed, because installing and removing it around each
+             *  call would race with other threads calling Concorde at the same time.
+             */
+            inline void install_concorde_crash_handler() {
+                static std::once_flag installed;
+
+                std::call_once(installed, [] () {
+                    struct sigaction action{};
+                    action.sa_sigaction = concorde_crash_handler;
+                    action.sa_flags = SA_SIGINFO;
+                    sigemptyset(&action.sa_mask);
+                    ::sigaction(SIGSEGV, &action, &previous_segv_action);
+                });
+            }
+        }
+
+        /** @brief  Allows or forbids concurrent calls to Concorde.
+         *
+         *  By default, \ref discorde_solve_tsp holds a process-wide mutex while Concorde
+         *  runs, because Concorde is not documented to be thread-safe. Builds of Concorde
+         *  known to keep their state in per-call structures can opt into concurrent
+         *  solves, e.g. in \ref solve_all.
+         *
+         *  @param  concurrent  True to let several threads run Concorde at the same time.
+         */
+        inline void allow_concurrent_concorde(bool concurrent) {
+            detail::concorde_concurrent() = concurrent;
+        }
+
         /** @brief Solves a TSP Instance using the Concorde solver via the Discorde C++ API.
          *
          *  Discorde is a thin C++ API around the TSP solver Concorde.
          *  It can throw, in case an error occurs when calling Concorde.
          *
+         *  The buffers passed to Concorde are kept in thread-local storage and reused
+         *  across calls, so that solving many small problems does not allocate.
+         *
+         *  The function can be called from several threads. Unless concurrent calls are
+         *  allowed with \ref allow_concurrent_concorde, the calls to Concorde itself are
+         *  serialised, while the cost matrices are still filled concurrently. Crashes in
+         *  Concorde are caught per thread, and only affect the thread where they occur.
+         *
          *  @param  instance The TSP instance.
          *  @param  nodes    The subset of nodes of the instance to consider.
          *  @return          The optimal tour.
          */
         inline std::vector<std::uint32_t> discorde_solve_tsp(const tsplib::TSPInstance& instance, const std::vector<std::uint32_t>& nodes) {
-            // Mapping of node numbers between the subgraph to give Discorde, and the original graph.
-            std::map<int, std::uint32_t> subgraph_mapping;
-
             // Prepare data for ::discorde::concorde_full
 
             assert(numeric::can_type_fit_value<int>(nodes.size()));
-            auto n_nodes = static_cast<const int>(nodes.size());
+            const auto n_nodes = static_cast<int>(nodes.size());
 
-            int** cost_matrix = new int*[n_nodes];
-            for(auto i = 0; i < n_nodes; ++i) {
-                cost_matrix[i] = new int[n_nodes];
-                subgraph_mapping[i] = nodes[i];
-
-                for(auto j = 0; j < n_nodes; ++j) {
-                    cost_matrix[i][j] = static_cast<int>(instance.get_distance(nodes[i], nodes[j]));
+            for(const auto node : nodes) {
+                if(node >= instance.number_of_vertices()) {
+                    throw std::out_of_range("No such vertex: " + std::to_string(node));
                 }
             }
 
-            int* out_tour = new int[n_nodes];
+            auto& scratch = detail::discorde_scratch();
+            detail::fill_discorde_costs(instance, nodes, scratch);
+
             double out_cost;
             int out_status;
             int ret_code;
             DiscordeStatus status = DiscordeStatus::SUCCESS;
 
+            detail::install_concorde_crash_handler();
+            auto& recovery = detail::concorde_recovery();
+
+            // Taken before sigsetjmp, so that jumping back after a crash keeps it held.
+            std::unique_lock<std::mutex> concorde_lock{detail::concorde_mutex(), std::defer_lock};
+
+            if(!detail::concorde_concurrent()) {
+                concorde_lock.lock();
+            }
+
             // This will contain a flag indicating whether a longjump occurred.
             int signal_handler_jump_state;
 
             // Save the stack into the buffer. When the function is called normally,
             // the return value will be 0; when we get here from a signal, the return
-            // value will be non-0.
-            signal_handler_jump_state = sigsetjmp(concorde_signal_buffer, 1);
+            // value will be non-0. The signal mask is saved too, so that SIGSEGV is
+            // unblocked again after the jump.
+            signal_handler_jump_state = sigsetjmp(recovery.buffer, 1);
 
             if(signal_handler_jump_state != 0) {
                 // We are getting here from a signal handler longjump!
@@ -84,13 +266,12 @@ namespace as {
             }
 
             if(status == DiscordeStatus::SUCCESS) {
-                // Catch SIGSEGV signals happening in Concorde
-                std::signal(SIGSEGV, concorde_crash_handler);
+                // Catch SIGSEGV signals happening in Concorde, on this thread
+                recovery.active = 1;
 
-                ret_code = ::discorde::concorde_full(n_nodes, cost_matrix, out_tour, &out_cost, &out_status);
+                ret_code = ::discorde::concorde_full(n_nodes, scratch.rows.data(), scratch.tour.data(), &out_cost, &out_status);
 
-                // Reset the SIGSEGV handler
-                std::signal(SIGSEGV, SIG_DFL);
+                recovery.active = 0;
 
                 if(ret_code == DISCORDE_RETURN_FAILURE) {
                     status = DiscordeStatus::DISCORDE_FAIL;
@@ -101,24 +282,18 @@ namespace as {
                 }
             }
 
-            std::vector<std::uint32_t> tour_nodes(nodes.size());
-            if(status == DiscordeStatus::SUCCESS) {
-                for(auto i = 0; i < n_nodes; ++i) {
-                    tour_nodes[i] = subgraph_mapping.at(out_tour[i]);
-                }
+            if(status != DiscordeStatus::SUCCESS) {
+                throw std::runtime_error("Discorde failed to provide the optimal solution to the TSP.");
             }
 
-            delete out_tour;
+            // Map the tour from the subgraph given to Discorde back to the original graph.
+            std::vector<std::uint32_t> tour_nodes(nodes.size());
+
             for(auto i = 0; i < n_nodes; ++i) {
-                delete cost_matrix[i];
+                tour_nodes[i] = nodes[scratch.tour[i]];
             }
-            delete cost_matrix;
 
-            if(status == DiscordeStatus::SUCCESS) {
-                return tour_nodes;
-            } else {
-                throw std::runtime_error("Discorde failed to provide the optimal solution to the TSP.");
-            }
+            return tour_nodes;
         }
 
         /** @brief Solves a TSP Instance using the Concorde solver via the Discorde C++ API.
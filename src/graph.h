@@ -6,6 +6,7 @@
 #define AS_GRAPH_H
 
 #include "iterator_pair.h"
+#include "dense_graph.h"
 #include <boost/graph/graph_traits.hpp>
 #include <boost/graph/adjacency_list.hpp>
 #include <numeric>
@@ -309,24 +310,22 @@ namespace as {
                 boost::add_vertex(graph[v], digraph);
             }
 
-            for(const auto& v : vertices(graph)) {
-                for(const auto& w : vertices(graph)) {
-                    if(v == w) { continue; }
-                    
-                    const auto& [edge, edge_exist] = boost::edge(v, w, graph);
-
-                    if(edge_exist) {
-                        const auto& source = ord(v, w) ? v : w;
-                        const auto& target = ord(v, w) ? w : v;
-
-                        // Because the two for loops will check for both
-                        // edge {v,w} and {w,v} we have to be careful not
-                        // to insert the same arc twice!
-                        if(!boost::edge(source, target, digraph).second) {
-                            boost::add_edge(source, target, graph[edge], digraph);
-                        }
-                    }
-                }
+            // Each edge is visited once, so we only need to skip parallel edges, which
+            // we detect with a bitset of the pairs already oriented.
+            DenseGraph oriented{boost::num_vertices(graph)};
+
+            for(const auto& edge : edges(graph)) {
+                const auto v = boost::source(edge, graph);
+                const auto w = boost::target(edge, graph);
+
+                if(v == w || oriented.are_connected(v, w)) { continue; }
+
+                oriented.add_edge(v, w);
+
+                const auto& source = ord(v, w) ? v : w;
+                const auto& target = ord(v, w) ? w : v;
+
+                boost::add_edge(source, target, graph[edge], digraph);
             }
 
             digraph[boost::graph_bundle] = graph[boost::graph_bundle];
@@ -359,14 +358,7 @@ namespace as {
                 boost::add_vertex(graph[v], comp);
             }
 
-            for(auto i = 0u; i < boost::num_vertices(graph); ++i) {
-                for(auto j = i + 1; j < boost::num_vertices(graph); ++j) {
-                    const bool edge_exists = boost::edge(i, j, graph).second;
-                    if(!edge_exists) {
-                        boost::add_edge(i, j, comp);
-                    }
-                }
-            }
+            DenseGraph::from_boost(graph).complement().add_edges_to(comp);
 
             comp[boost::graph_bundle] = graph[boost::graph_bundle];
 
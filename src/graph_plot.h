@@ -7,6 +7,12 @@
 
 #include <boost/graph/graph_concepts.hpp>
 #include <boost/graph/graph_traits.hpp>
+
+// Plots are only saved to file: do not open windows, nor link X11.
+#ifndef cimg_display
+#define cimg_display 0
+#endif
+
 #include <CImg.h>
 
 #include <optional>
@@ -15,6 +21,15 @@
 #include <array>
 #include <tuple>
 #include <string>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <utility>
+#include <algorithm>
+#include <exception>
+#include <condition_variable>
 
 #include "graph.h"
 
@@ -27,6 +42,8 @@ namespace as {
          *  @brief     This namespace provides utilities to plot graphs to images.
          */
         namespace plot {
+            template<typename Graph> class TourAnimator;
+
             /** @class PlottedGraph
              *  @brief A class representing a graph which is going to be plotted.
              *
@@ -200,6 +217,7 @@ namespace as {
                 PlottedGraph& set_scaling(float factor) {
                     scaling_x = factor;
                     scaling_y = factor;
+                    return *this;
                 }
 
                 /** @brief Sets the picture padding.
@@ -337,6 +355,14 @@ namespace as {
                  *  @param filename The path of the file where the png picture will be saved.
                  */
                 void plot_png(const std::string& filename) const {
+                    render().save_png(filename.c_str());
+                }
+
+                /** @brief Plots the graph to an image.
+                 *
+                 *  @return The image.
+                 */
+                Image render() const {
                     const auto original_width = max_vertex_x - min_vertex_x;
                     const auto original_height = max_vertex_y - min_vertex_y;
                     std::uint32_t image_width = original_width;
@@ -361,7 +387,7 @@ namespace as {
                             3u                                                       // Colour depth (RGB -> 3)
                     );
 
-                    cimg_forXYZ(img, x, y, z) { img.fillC(x, y, z, 255, 255, 255); }
+                    img.fill(255);
 
                     if(print_vertices) {
                         add_vertices_to(img);
@@ -381,10 +407,12 @@ namespace as {
                         colour_edges(highlight_edges[n], colours[colour_n].data(), img);
                     }
 
-                    img.save_png(filename.c_str());
+                    return img;
                 }
 
             private:
+                friend class TourAnimator<Graph>;
+
                 std::pair<float, float> minmax_dimensions(const std::function<float(const Vertex&)>& dim) const {
                     const auto iters = boost::vertices(graph);
                     const auto minmax = std::minmax_element(iters.first, iters.second,
@@ -409,9 +437,10 @@ namespace as {
                 }
 
                 void draw_edge(const Edge& e, const unsigned char colour[3], Image& img) const {
-                    const auto& orig = boost::source(e, graph);
-                    const auto& dest = boost::target(e, graph);
+                    draw_segment(boost::source(e, graph), boost::target(e, graph), colour, img);
+                }
 
+                void draw_segment(const Vertex& orig, const Vertex& dest, const unsigned char colour[3], Image& img) const {
                     const auto x1 = get_vertex_canvas_x(orig), y1 = get_vertex_canvas_y(orig);
                     const auto x2 = get_vertex_canvas_x(dest), y2 = get_vertex_canvas_y(dest);
 
@@ -449,6 +478,367 @@ namespace as {
                     }
                 }
             };
+
+            /** @class TourAnimator
+             *  @brief Renders a sequence of tours on a graph as frames, on a background thread.
+             *
+             *  The vertices, as plotted by a \ref PlottedGraph, make up a base layer which is
+             *  rendered once. Each frame is the previous frame, where only the edges which
+             *  left or entered the tour are redrawn: the area covered by edges which left is
+             *  copied back from the base layer, and the edges of the tour crossing that area
+             *  are drawn again. Frames are passed to a sink, e.g. \ref png_files, which writes
+             *  them to disk; a tool such as ffmpeg can then make a video out of them.
+             *
+             *  Adding a frame never waits for rendering: if more than a given number of frames
+             *  are waiting, the oldest one is dropped.
+             *
+             *  @tparam Graph   The underlying boost graph, as in \ref PlottedGraph.
+             */
+            template<typename Graph>
+            class TourAnimator {
+                /** @brief Graph vertex descriptor.
+                 */
+                using Vertex = typename boost::graph_traits<Graph>::vertex_descriptor;
+
+                /** @brief Image type provided by CImg.
+                 */
+                using Image = cimg_library::CImg<unsigned char>;
+
+                /** @brief An undirected edge, with the smaller vertex first.
+                 */
+                using Segment = std::pair<Vertex, Vertex>;
+
+            public:
+                /** @brief A tour, as the sequence of vertices visited.
+                 */
+                using Tour = std::vector<Vertex>;
+
+                /** @brief  Function receiving each frame with its number, starting from 0.
+                 *          It is called on the rendering thread.
+                 */
+                using FrameSink = std::function<void(const Image&, std::size_t)>;
+
+            private:
+                /** @brief  Supplies the coordinates and the base layer. It is a copy, so that
+                 *          the caller can change its own while frames are being rendered.
+                 */
+                PlottedGraph<Graph> plotted;
+
+                /** @brief  The vertices, with the highlights of \ref plotted.
+                 */
+                Image base;
+
+                /** @brief  The latest frame.
+                 */
+                Image frame;
+
+                /** @brief  The edges of the tour in \ref frame, sorted.
+                 */
+                std::vector<Segment> drawn;
+
+                /** @brief  Colour of the tour edges.
+                 */
+                std::array<unsigned char, 3> colour;
+
+                FrameSink sink;
+
+                /** @brief  Maximum number of tours waiting to be rendered.
+                 */
+                std::size_t max_pending;
+
+                /** @brief  Tours waiting to be rendered.
+                 */
+                std::deque<Tour> pending;
+
+                std::atomic<std::size_t> n_rendered;
+                std::atomic<std::size_t> n_dropped;
+
+                /** @brief  The first exception thrown while rendering, if any.
+                 */
+                std::exception_ptr error;
+
+                bool stopping;
+
+                /** @brief  Protects \ref pending, \ref stopping and \ref error.
+                 */
+                std::mutex mutex;
+                std::condition_variable has_work;
+                std::thread worker;
+
+            public:
+                /** @brief               Starts the rendering thread.
+                 *
+                 *  @param plotted      How to plot the vertices. Edges should usually be hidden.
+                 *  @param sink         What to do with each frame.
+                 *  @param max_pending  Maximum number of frames waiting to be rendered.
+                 *  @param colour_n     Index, in the palette of \ref PlottedGraph, of the tour colour.
+                 */
+                TourAnimator(PlottedGraph<Graph> plotted, FrameSink sink, std::size_t max_pending = 16u, std::size_t colour_n = 1u) :
+                    plotted{std::move(plotted)}, colour{PlottedGraph<Graph>::colours[colour_n % PlottedGraph<Graph>::colours.size()]},
+                    sink{std::move(sink)}, max_pending{std::max<std::size_t>(max_pending, 1u)},
+                    n_rendered{0u}, n_dropped{0u}, stopping{false}
+                {
+                    base = this->plotted.render();
+                    frame = base;
+                    worker = std::thread{[this] () { render_loop(); }};
+                }
+
+                TourAnimator(const TourAnimator&) = delete;
+                TourAnimator& operator=(const TourAnimator&) = delete;
+
+                /** @brief Renders the waiting frames, and stops the rendering thread.
+                 */
+                ~TourAnimator() {
+                    stop();
+                }
+
+                /** @brief  A sink which saves frame i to file prefix-i.png, with i padded to
+                 *          six digits.
+                 *
+                 *  @param  prefix  Path and name of the files, before the frame number.
+                 *  @return         The sink.
+                 */
+                static FrameSink png_files(std::string prefix) {
+                    return [prefix = std::move(prefix)] (const Image& img, std::size_t frame_n) {
+                        char number[32];
+                        std::snprintf(number, sizeof(number), "-%06zu.png", frame_n);
+                        img.save_png((prefix + number).c_str());
+                    };
+                }
+
+                /** @brief  Queues a tour to be rendered as the next frame. It does not wait.
+                 *
+                 *  @param  tour    The vertices, in the order in which they are visited.
+                 */
+                void add_frame(Tour tour) {
+                    {
+                        std::lock_guard<std::mutex> lock{mutex};
+
+                        if(stopping) { return; }
+
+                        if(pending.size() == max_pending) {
+                            pending.pop_front();
+                            ++n_dropped;
+                        }
+
+                        pending.push_back(std::move(tour));
+                    }
+
+                    has_work.notify_one();
+                }
+
+                /** @brief  Renders the waiting frames, and stops the rendering thread. Further
+                 *          frames are ignored. It throws if the sink threw.
+                 */
+                void finish() {
+                    stop();
+
+                    if(error) {
+                        std::rethrow_exception(std::exchange(error, nullptr));
+                    }
+                }
+
+                /** @brief  Gives the number of frames passed to the sink so far.
+                 */
+                std::size_t number_of_frames() const {
+                    return n_rendered;
+                }
+
+                /** @brief  Gives the number of frames dropped because too many were waiting.
+                 */
+                std::size_t number_of_dropped_frames() const {
+                    return n_dropped;
+                }
+
+            private:
+
+                void stop() {
+                    {
+                        std::lock_guard<std::mutex> lock{mutex};
+                        stopping = true;
+                    }
+
+                    has_work.notify_one();
+
+                    if(worker.joinable()) {
+                        worker.join();
+                    }
+                }
+
+                void render_loop() {
+                    for(;;) {
+                        Tour tour;
+
+                        {
+                            std::unique_lock<std::mutex> lock{mutex};
+                            has_work.wait(lock, [this] () { return stopping || !pending.empty(); });
+
+                            if(pending.empty() || error) { return; }
+
+                            tour = std::move(pending.front());
+                            pending.pop_front();
+                        }
+
+                        try {
+                            draw(tour);
+                            sink(frame, n_rendered);
+                            ++n_rendered;
+                        } catch(...) {
+                            std::lock_guard<std::mutex> lock{mutex};
+                            error = std::current_exception();
+                            return;
+                        }
+                    }
+                }
+
+                static std::vector<Segment> segments_of(const Tour& tour) {
+                    std::vector<Segment> segments;
+
+                    if(tour.size() < 2u) { return segments; }
+
+                    segments.reserve(tour.size());
+
+                    for(auto i = 0u; i < tour.size(); ++i) {
+                        const auto v = tour[i], w = tour[(i + 1u) % tour.size()];
+                        segments.emplace_back(std::min(v, w), std::max(v, w));
+                    }
+
+                    std::sort(segments.begin(), segments.end());
+                    segments.erase(std::unique(segments.begin(), segments.end()), segments.end());
+                    return segments;
+                }
+
+                /** @brief  Pixels covered by a segment: x0, y0, x1, y1, inclusive. Lines are
+                 *          drawn one pixel thick to the left and to the top, see draw_segment.
+                 */
+                std::array<int, 4> box_of(const Segment& s) const {
+                    const int x1 = plotted.get_vertex_canvas_x(s.first), y1 = plotted.get_vertex_canvas_y(s.first);
+                    const int x2 = plotted.get_vertex_canvas_x(s.second), y2 = plotted.get_vertex_canvas_y(s.second);
+
+                    return {{
+                        std::max(std::min(x1, x2) - 1, 0),
+                        std::max(std::min(y1, y2) - 1, 0),
+                        std::min(std::max(x1, x2), frame.width() - 1),
+                        std::min(std::max(y1, y2), frame.height() - 1)
+                    }};
+                }
+
+                void draw(const Tour& tour) {
+                    const auto segments = segments_of(tour);
+                    std::vector<Segment> removed, added;
+
+                    std::set_difference(drawn.begin(), drawn.end(), segments.begin(), segments.end(), std::back_inserter(removed));
+                    std::set_difference(segments.begin(), segments.end(), drawn.begin(), drawn.end(), std::back_inserter(added));
+
+                    if(removed.size() >= segments.size()) {
+                        // Most of the tour changed: start again from the base layer.
+                        frame = base;
+
+                        for(const auto& s : segments) {
+                            plotted.draw_segment(s.first, s.second, colour.data(), frame);
+                        }
+                    } else {
+                        std::vector<std::array<int, 4>> dirty;
+                        dirty.reserve(removed.size());
+
+                        for(const auto& s : removed) {
+                            const auto box = box_of(s);
+
+                            if(box[0] > box[2] || box[1] > box[3]) { continue; }
+
+                            frame.draw_image(box[0], box[1], base.get_crop(box[0], box[1], box[2], box[3]));
+                            dirty.push_back(box);
+                        }
+
+                        auto is_dirty = [&] (const std::array<int, 4>& box) {
+                            return std::any_of(dirty.begin(), dirty.end(), [&] (const std::array<int, 4>& d) {
+                                return box[0] <= d[2] && d[0] <= box[2] && box[1] <= d[3] && d[1] <= box[3];
+                            });
+                        };
+
+                        for(const auto& s : segments) {
+                            const bool is_new = std::binary_search(added.begin(), added.end(), s);
+
+                            if(is_new || is_dirty(box_of(s))) {
+                                plotted.draw_segment(s.first, s.second, colour.data(), frame);
+                            }
+                        }
+                    }
+
+                    drawn = segments;
+                }
+            };
+
+            /** @brief Which solution a \ref TourAnimationVisitor animates.
+             */
+            enum class AnimatedSolution {
+                /**
+                 * The best solution, each time it improves.
+                 */
+                BEST,
+
+                /**
+                 * The current solution, every given number of iterations.
+                 */
+                CURRENT
+            };
+
+            /** @class TourAnimationVisitor
+             *  @brief An ALNS algorithm visitor which passes tours to a \ref TourAnimator.
+             *
+             *  It works with any algorithm status providing get_iteration_number,
+             *  get_best_cost, get_best_solution and get_current_solution, as
+             *  as::alns::AlgorithmStatus does. Since the animator renders on its own
+             *  thread, the visitor only costs extracting the tour.
+             *
+             *  @tparam Graph   The underlying boost graph of the animator.
+             *  @tparam TourOf  Callable giving the tour (a vector of vertices) of a solution.
+             */
+            template<typename Graph, typename TourOf>
+            class TourAnimationVisitor {
+                TourAnimator<Graph>* animator;
+                TourOf tour_of;
+                AnimatedSolution which;
+                std::size_t every;
+                std::optional<float> last_best_cost;
+
+            public:
+                /** @brief              Builds the visitor.
+                 *
+                 *  @param animator     The animator, which must outlive the visitor.
+                 *  @param tour_of      Gives the tour of a solution.
+                 *  @param which        Which solution to animate.
+                 *  @param every        With \ref AnimatedSolution::CURRENT, how many iterations
+                 *                      to wait between frames.
+                 */
+                TourAnimationVisitor(TourAnimator<Graph>& animator, TourOf tour_of, AnimatedSolution which = AnimatedSolution::BEST, std::size_t every = 1u) :
+                    animator{&animator}, tour_of{std::move(tour_of)}, which{which}, every{std::max<std::size_t>(every, 1u)} {}
+
+                /** @brief  Adds a frame, if needed. It never stops the algorithm.
+                 */
+                template<class AlgorithmStatus>
+                bool on_iteration_end(AlgorithmStatus& status) {
+                    if(which == AnimatedSolution::BEST) {
+                        const float cost = status.get_best_cost();
+
+                        if(!last_best_cost || cost < *last_best_cost) {
+                            last_best_cost = cost;
+                            animator->add_frame(tour_of(status.get_best_solution()));
+                        }
+                    } else if(status.get_iteration_number() % every == 0u) {
+                        animator->add_frame(tour_of(status.get_current_solution()));
+                    }
+
+                    return true;
+                }
+            };
+
+            /** @brief  Builds a \ref TourAnimationVisitor, deducing its types.
+             */
+            template<typename Graph, typename TourOf>
+            TourAnimationVisitor<Graph, TourOf> make_tour_animation_visitor(TourAnimator<Graph>& animator, TourOf tour_of, AnimatedSolution which = AnimatedSolution::BEST, std::size_t every = 1u) {
+                return TourAnimationVisitor<Graph, TourOf>{animator, std::move(tour_of), which, every};
+            }
         }
     }
 }
@@ -16,6 +16,8 @@
 #include <chrono>
 #include <vector>
 #include <cstring>
+#include <optional>
+#include <stdexcept>
 #include <type_traits>
 
 extern "C" {
@@ -24,162 +26,209 @@ extern "C" {
 
 #include "graph.h"
 #include "numeric.h"
+#include "max_clique_solution.h"
 
 namespace as {
-    namespace details {
-        // The following two TMP definitions check for a ::weight member in a struct.
-        // This is used to determine whether the graph has a vertex property which
-        // has such a member. In that case, we solve the weighted version of the problem.
-        
-        template<typename T, typename = float>
-        struct has_weight : std::false_type {};
-
-        template<typename T>
-        struct has_weight<T, decltype((void) T::weight, 0.0f)> : std::true_type {};
-
-        // The get_weight function gets the ::weight member of a struct, if such
-        // a member exist and is publicly accessible. Otherwise, it returns 1.0f.
-
-        template<typename VertexProperty>
-        float get_weight(std::false_type, const VertexProperty&) {
-            return 1.0f;
-        }
-
-        template<typename VertexProperty>
-        float get_weight(std::true_type, const VertexProperty& prop) {
-            return prop.weight;
-        }
-
-        template<typename VertexProperty>
-        float get_weight(const VertexProperty& prop) {
-            return get_weight(has_weight<VertexProperty>{}, prop);
-        }
-    }
-
     /** @namespace  max_clique
      *  @brief      This namespace contains utilities to solve the Maximum Clique Problem on boost graphs.
      */
     namespace max_clique {
-        /** @struct MaxCliqueSolution
-         *  @brief  Contains data about the solution of a Maximum (Weight) Clique Problem.
+        /** @brief  Which inequalities forbid two non-adjacent vertices in the same clique.
          */
-        template<typename BoostGraph>
-        struct MaxCliqueSolution {
+        enum class MipFormulation {
             /**
-             *  List of vertices making up the largest (or heaviest, in the weighted case)
-             *  found by the algorithm. It might be optimal or not.
+             * One inequality x[v] + x[w] <= 1 for each pair of non-adjacent vertices.
              */
-            std::vector<typename boost::graph_traits<BoostGraph>::vertex_descriptor> best_clique;
+            EDGE,
 
             /**
-             *  A lower bound on the size of the optimal clique (or on its total weight, in
-             *  the weighted case). If the maximal clique has been found, it coincides with
-             *  the upper bound \ref ub .
+             * One inequality sum(x[v] : v in S) <= 1 for each set S of a family of maximal
+             * independent sets covering all pairs of non-adjacent vertices (see
+             * \ref graph::independent_set_cover). It has far fewer rows, and a much
+             * tighter linear relaxation.
              */
-            float lb;
-
-            /**
-             *  An upper bound on the size of the optimal clique (or on its total weight,
-             *  in the weighted case). If the maximal clique has been found, it coincides
-             *  with the lower bound \ref lb .
-             */
-            float ub;
-
-            /**
-             *  Times taken by the solver to complete. During this time it might or might
-             *  not have found the optimal clique. Check the values of \ref lb and \ref ub
-             *  to verify if the optimal clique was found.
-             */
-            float elapsed_time;
+            INDEPENDENT_SET
         };
 
-        /** @brief  Solves the Maximum (Weight) Clique Problem via a simple MIP model through CPLEX.
-         *
-         *  It supports solving two variants of the problem:
-         *
-         *  * The MCP, where we simply try to find a clique of maximal size (i.e., number of vertices).
-         *  * The MWCP, where we associate a weight to each vertex, and we attempt to find a clique
-         *    with maximal sum of the weights of its vertices.
+        /** @class  MipCliqueSolver
+         *  @brief  A MIP model of the Maximum (Weight) Clique Problem on a fixed graph,
+         *          which can be solved repeatedly with different vertex weights.
          *
-         *  The detection of the problem to solve is automatic: if the \ref BoostGraph has a vertex
-         *  property with a publicly accessible weight member, then we solve the weighted version.
-         *  Otherwise, we solve the unweighted version.
+         *          The model is built once, and each call to \ref solve only changes the
+         *          objective function, so that CPLEX can start from the previous solution.
+         *          This suits pricing loops, where the graph is fixed and the weights change
+         *          at each iteration.
          *
-         *  @tparam BoostGraph  The underlying graph type.
-         *  @param  g           The graph.
-         *  @return             A structure repreesnting the solution (see \ref MaxCliqueSolution).
+         *  @tparam BoostGraph  The underlying graph type. Vertices must be stored in a vector.
          */
         template<typename BoostGraph>
-        inline MaxCliqueSolution<BoostGraph> solve_with_mip(const BoostGraph& g, std::optional<float> timeout = std::nullopt) {
+        class MipCliqueSolver {
             static_assert(
                 std::is_same<typename BoostGraph::vertex_list_selector, boost::vecS>::value,
-                "solve_with_mip relies on vertices to be stored in a vertex to map their indices to the variables' indices."
+                "MipCliqueSolver relies on vertices to be stored in a vector to map their indices to the variables' indices."
             );
 
+            /** @brief Number of vertices, i.e. of variables.
+             */
+            std::size_t n;
+
+            /** @brief Default vertex weights, read from the graph (see \ref solve_with_mip).
+             */
+            std::vector<float> graph_weights;
+
             IloEnv env;
-            IloModel model{env};
-            const auto n = boost::num_vertices(g);
+            IloModel model;
+            IloNumVarArray x;
+            IloObjective objective;
+            IloCplex cplex;
+
+        public:
+            /** @brief              Builds the model.
+             *
+             *  @param g            The graph.
+             *  @param formulation  Which inequalities to use.
+             */
+            explicit MipCliqueSolver(const BoostGraph& g, MipFormulation formulation = MipFormulation::EDGE) :
+                n{boost::num_vertices(g)}, graph_weights(boost::num_vertices(g)), env{}, model{env}
+            {
+                assert(numeric::can_type_fit_value<IloInt>(n));
+                x = IloNumVarArray{env, static_cast<IloInt>(n), 0, 1, IloNumVar::Bool};
+
+                for(const auto& v : graph::vertices(g)) {
+                    graph_weights[v] = details::get_weight(g[v]);
+                }
 
-            assert(numeric::can_type_fit_value<IloInt>(n));
-            IloNumVarArray x{env, static_cast<IloInt>(n)};
+                objective = IloMaximize(env);
+                model.add(objective);
 
-            IloExpr expr{env};
+                const auto dense = graph::DenseGraph::from_boost(g);
 
-            for(const auto& v : graph::vertices(g)) {
-                x[v] = IloNumVar{env, 0, 1, IloNumVar::Bool};
-                expr += details::get_weight(g[v]) * x[v];
-            }
+                if(formulation == MipFormulation::EDGE) {
+                    // One constraint for each pair of non-adjacent vertices, which we read off
+                    // the complement's adjacency matrix rather than testing each pair in g.
+                    const auto non_edges = dense.complement();
 
-            model.add(IloObjective{env, expr, IloObjective::Maximize});
-            expr.end();
+                    for(auto v = 0u; v < n; ++v) {
+                        non_edges.for_each_neighbour(v, [&] (std::size_t w) {
+                            if(w > v) {
+                                model.add(x[v] + x[w] <= 1);
+                            }
+                        });
+                    }
+                } else {
+                    for(const auto& set : graph::independent_set_cover(dense)) {
+                        IloExpr expr{env};
+
+                        for(const auto v : set) {
+                            expr += x[v];
+                        }
 
-            for(auto v = 0u; v < n; ++v) {
-                for(auto w = v + 1; w < n; ++w) {
-                    if(!graph::are_connected(v, w, g)) {
-                        model.add(x[v] + x[w] <= 1);
+                        model.add(expr <= 1);
+                        expr.end();
                     }
                 }
-            }
-
-            IloCplex cplex{model};
-            IloBool solved{false};
 
-            if(timeout) {
-                cplex.setParam(IloCplex::Param::TimeLimit, *timeout);
+                cplex = IloCplex{model};
             }
 
-            const auto start_time = std::chrono::high_resolution_clock::now();
+            MipCliqueSolver(const MipCliqueSolver&) = delete;
+            MipCliqueSolver& operator=(const MipCliqueSolver&) = delete;
 
-            try {
-                solved = cplex.solve();
-            } catch(IloException& e) {
+            ~MipCliqueSolver() {
                 env.end();
-                throw std::runtime_error("Cplex crashed when solving the problem");
             }
 
-            const auto end_time = std::chrono::high_resolution_clock::now();
-
-            if(!solved) {
-                cplex.exportModel("error.lp");
-                env.end();
-                throw std::runtime_error("Cplex could not find a solution for this instance of the problem");
+            /** @brief          Solves the problem with the weights of the graph's vertices.
+             *
+             *  @param timeout  Optional time limit, in seconds.
+             *  @return         A structure representing the solution (see \ref MaxCliqueSolution).
+             */
+            MaxCliqueSolution<BoostGraph> solve(std::optional<float> timeout = std::nullopt) {
+                return solve(graph_weights, timeout);
             }
 
-            std::vector<typename boost::graph_traits<BoostGraph>::vertex_descriptor> clique;
+            /** @brief          Solves the problem with the given vertex weights.
+             *
+             *  @param weights  The weights, indexed as the vertices.
+             *  @param timeout  Optional time limit, in seconds.
+             *  @return         A structure representing the solution (see \ref MaxCliqueSolution).
+             */
+            MaxCliqueSolution<BoostGraph> solve(const std::vector<float>& weights, std::optional<float> timeout = std::nullopt) {
+                assert(weights.size() == n);
+
+                IloNumArray coefficients{env, static_cast<IloInt>(n)};
 
-            for(const auto& v : graph::vertices(g)) {
-                if(details::get_weight(g[v]) && cplex.getValue(x[v]) > 0) {
-                    clique.push_back(v);
+                for(auto v = 0u; v < n; ++v) {
+                    coefficients[v] = weights[v];
                 }
-            }
 
-            const float lb = cplex.getBestObjValue();
-            const float ub = cplex.getObjValue();
-            const float elapsed_time = std::chrono::duration_cast<std::chrono::duration<float>>(end_time - start_time).count();
+                objective.setLinearCoefs(x, coefficients);
+                coefficients.end();
+
+                // CPLEX's default time limit is 1e75 seconds.
+                cplex.setParam(IloCplex::Param::TimeLimit, timeout ? *timeout : 1e75);
+
+                IloBool solved{false};
+                const auto start_time = std::chrono::high_resolution_clock::now();
+
+                try {
+                    solved = cplex.solve();
+                } catch(IloException& e) {
+                    throw std::runtime_error("Cplex crashed when solving the problem");
+                }
 
-            env.end();
+                const auto end_time = std::chrono::high_resolution_clock::now();
+
+                if(!solved) {
+                    cplex.exportModel("error.lp");
+                    throw std::runtime_error("Cplex could not find a solution for this instance of the problem");
+                }
+
+                std::vector<typename boost::graph_traits<BoostGraph>::vertex_descriptor> clique;
+
+                for(auto v = 0u; v < n; ++v) {
+                    if(weights[v] && cplex.getValue(x[v]) > 0) {
+                        clique.push_back(v);
+                    }
+                }
+
+                const float lb = cplex.getBestObjValue();
+                const float ub = cplex.getObjValue();
+                const float elapsed_time = std::chrono::duration_cast<std::chrono::duration<float>>(end_time - start_time).count();
+
+                return { clique, lb, ub, elapsed_time };
+            }
+        };
 
-            return { clique, lb, ub, elapsed_time };
+        /** @brief  Solves the Maximum (Weight) Clique Problem via a simple MIP model through CPLEX.
+         *
+         *  It supports solving two variants of the problem:
+         *
+         *  * The MCP, where we simply try to find a clique of maximal size (i.e., number of vertices).
+         *  * The MWCP, where we associate a weight to each vertex, and we attempt to find a clique
+         *    with maximal sum of the weights of its vertices.
+         *
+         *  The detection of the problem to solve is automatic: if the \ref BoostGraph has a vertex
+         *  property with a publicly accessible weight member, then we solve the weighted version.
+         *  Otherwise, we solve the unweighted version.
+         *
+         *  To solve the problem repeatedly on the same graph with different weights, use a
+         *  \ref MipCliqueSolver instead, which keeps the model between calls.
+         *
+         *  @tparam BoostGraph  The underlying graph type.
+         *  @param  g           The graph.
+         *  @param  timeout     Optional time limit, in seconds.
+         *  @param  formulation Which inequalities to use (see \ref MipFormulation).
+         *  @return             A structure repreesnting the solution (see \ref MaxCliqueSolution).
+         */
+        template<typename BoostGraph>
+        inline MaxCliqueSolution<BoostGraph> solve_with_mip(
+            const BoostGraph& g,
+            std::optional<float> timeout = std::nullopt,
+            MipFormulation formulation = MipFormulation::EDGE
+        ) {
+            MipCliqueSolver<BoostGraph> solver{g, formulation};
+            return solver.solve(timeout);
         };
 
         /** @brief  Solves the Maximum Clique Problem via the Parallel Maximum Clique (PMC) library.
@@ -0,0 +1,406 @@
+//
+// Created by alberto on 14/10/26.
+//
+
+#ifndef AS_MAX_CLIQUE_BNB_H
+#define AS_MAX_CLIQUE_BNB_H
+
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/graph_traits.hpp>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <numeric>
+#include <optional>
+#include <algorithm>
+#include <type_traits>
+
+#include "dense_graph.h"
+#include "thread_pool.h"
+#include "max_clique_solution.h"
+
+namespace as {
+    namespace max_clique {
+        namespace detail {
+            /** @class  BranchAndBound
+             *  @brief  Branch-and-bound for the Maximum Weight Clique Problem on a dense graph.
+             *
+             *          Each node of the tree has a clique C and a set P of candidates, i.e. of
+             *          vertices adjacent to all the vertices of C. P is greedily partitioned in
+             *          independent sets (colour classes), and since a clique takes at most one
+             *          vertex from each class, the sum over the classes of their heaviest vertex
+             *          is an upper bound on the weight that P can add to C. Candidates are listed
+             *          class by class, and tried from the last one, so that each branch can use
+             *          the bound of the classes before it (as in MCS, and in WLMC for the weighted
+             *          case).
+             *
+             *          The root is split in one subproblem per vertex v, whose candidates are the
+             *          neighbours of v which come after it. Subproblems are independent, except
+             *          for the incumbent they share, and are run as the tasks of a thread pool.
+             */
+            class BranchAndBound {
+                /** @brief Number of tree nodes explored between two deadline checks.
+                 */
+                static constexpr std::uint32_t nodes_between_checks = 1024u;
+
+                /** @brief The graph, with vertices by non-increasing degree.
+                 */
+                graph::DenseGraph graph;
+
+                /** @brief The weights of the vertices of \ref graph.
+                 */
+                std::vector<float> weights;
+
+                /** @brief Maps the vertices of \ref graph to those of the original graph.
+                 */
+                std::vector<std::size_t> vertex_of;
+
+                /** @brief Number of words in each bitset.
+                 */
+                std::size_t words;
+
+                /** @brief When to stop, if there is a timeout.
+                 */
+                std::optional<std::chrono::steady_clock::time_point> deadline;
+
+                /** @brief Set when the deadline is reached.
+                 */
+                std::atomic<bool> stop;
+
+                /** @brief Weight of the best clique found so far, read without locking to prune.
+                 */
+                std::atomic<float> best_weight;
+
+                /** @brief The best clique found so far.
+                 */
+                std::vector<std::size_t> best_clique;
+
+                /** @brief Protects \ref best_clique, and updates of \ref best_weight.
+                 */
+                std::mutex best_mutex;
+
+                /** @brief The state of the search from one root subproblem.
+                 */
+                struct Search {
+                    std::vector<std::size_t> clique;
+                    float clique_weight = 0.0f;
+
+                    // One candidate set, colouring order, and bound list per depth.
+                    std::vector<std::vector<graph::bits::Word>> candidates;
+                    std::vector<std::vector<std::size_t>> orders;
+                    std::vector<std::vector<float>> bounds;
+
+                    // Scratch sets for the colouring.
+                    std::vector<graph::bits::Word> uncoloured, colour_class;
+
+                    std::uint32_t nodes_since_check = 0u;
+                };
+
+            public:
+                /** @brief  Outcome of \ref solve, in terms of the original vertices.
+                 */
+                struct Result {
+                    std::vector<std::size_t> clique;
+                    float lb;
+                    float ub;
+                };
+
+                /** @brief  Prepares the search.
+                 *
+                 *  @param original         The graph.
+                 *  @param original_weights The weights of its vertices, which must be non-negative.
+                 *  @param timeout          Optional time limit, in seconds.
+                 */
+                BranchAndBound(const graph::DenseGraph& original, const std::vector<float>& original_weights, std::optional<float> timeout) :
+                    graph{original.number_of_vertices()},
+                    weights(original.number_of_vertices()),
+                    vertex_of(original.number_of_vertices()),
+                    words{original.number_of_words()},
+                    stop{false},
+                    best_weight{0.0f}
+                {
+                    assert(original_weights.size() == original.number_of_vertices());
+                    assert(std::all_of(original_weights.begin(), original_weights.end(), [] (float w) { return w >= 0.0f; }));
+
+                    // High-degree vertices first: their subproblems are the largest, so they get
+                    // handed out first, and the colouring sees them first, which gives fewer classes.
+                    const auto n = original.number_of_vertices();
+                    std::vector<std::size_t> degree(n);
+
+                    for(auto v = 0u; v < n; ++v) {
+                        degree[v] = original.degree(v);
+                    }
+
+                    std::iota(vertex_of.begin(), vertex_of.end(), 0u);
+                    std::stable_sort(vertex_of.begin(), vertex_of.end(), [&] (std::size_t v, std::size_t w) {
+                        return degree[v] > degree[w] || (degree[v] == degree[w] && original_weights[v] > original_weights[w]);
+                    });
+
+                    std::vector<std::size_t> position(n);
+
+                    for(auto i = 0u; i < n; ++i) {
+                        position[vertex_of[i]] = i;
+                        weights[i] = original_weights[vertex_of[i]];
+                    }
+
+                    for(auto i = 0u; i < n; ++i) {
+                        original.for_each_neighbour(vertex_of[i], [&] (std::size_t w) {
+                            if(position[w] > i) {
+                                graph.add_edge(i, position[w]);
+                            }
+                        });
+                    }
+
+                    if(timeout) {
+                        deadline = std::chrono::steady_clock::now() +
+                            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(*timeout));
+                    }
+                }
+
+                /** @brief          Runs the search.
+                 *
+                 *  @param pool     The threads which explore the root subproblems.
+                 *  @return         The best clique, with its weight as lower bound, and an
+                 *                  upper bound which coincides with it unless the search
+                 *                  was stopped by the timeout.
+                 */
+                Result solve(concurrency::ThreadPool& pool) {
+                    const auto n = graph.number_of_vertices();
+
+                    // Bound on the weight of the cliques of each root subproblem, and whether the
+                    // subproblem was explored to the end. Each task only writes its own slots.
+                    std::vector<float> root_bound(n);
+                    std::vector<std::uint8_t> explored(n, 0u);
+
+                    pool.run(n, [&] (std::size_t v) {
+                        Search search;
+                        root_bound[v] = weights[v] + candidates_weight(search, v);
+
+                        if(stop.load(std::memory_order_relaxed)) { return; }
+
+                        search.clique.push_back(v);
+                        search.clique_weight = weights[v];
+                        expand(search, 0u);
+
+                        if(!stop.load(std::memory_order_relaxed)) {
+                            explored[v] = 1u;
+                        }
+                    });
+
+                    Result result;
+                    result.lb = best_weight.load();
+                    result.ub = result.lb;
+
+                    for(auto v = 0u; v < n; ++v) {
+                        if(!explored[v]) {
+                            result.ub = std::max(result.ub, root_bound[v]);
+                        }
+                    }
+
+                    for(const auto v : best_clique) {
+                        // As in the MIP, vertices which do not contribute to the weight are left out.
+                        if(weights[v] > 0.0f) {
+                            result.clique.push_back(vertex_of[v]);
+                        }
+                    }
+
+                    std::sort(result.clique.begin(), result.clique.end());
+                    return result;
+                }
+
+            private:
+                /** @brief  Sets up the candidates of the root subproblem of v, and gives a
+                 *          quick bound on their weight: their total weight.
+                 */
+                float candidates_weight(Search& search, std::size_t v) const {
+                    search.candidates.emplace_back(graph.neighbourhood(v), graph.neighbourhood(v) + words);
+
+                    // Neighbours of v which come before it are handled by their own subproblem.
+                    auto& candidates = search.candidates[0u];
+                    const auto v_word = v / graph::bits::bits_per_word;
+
+                    std::fill(candidates.begin(), candidates.begin() + v_word, graph::bits::Word{0u});
+                    candidates[v_word] &= ~((graph::bits::Word{2u} << (v % graph::bits::bits_per_word)) - 1u);
+
+                    float total = 0.0f;
+
+                    graph::bits::for_each(candidates.data(), words, [&] (std::size_t w) {
+                        total += weights[w];
+                    });
+
+                    return total;
+                }
+
+                /** @brief  Partitions the candidates at the given depth in colour classes,
+                 *          listing them class by class, together with the bound on the weight
+                 *          that the candidates up to each of them can add to the clique.
+                 */
+                void colour(Search& search, std::size_t depth) const {
+                    const auto& candidates = search.candidates[depth];
+                    auto& order = search.orders[depth];
+                    auto& bounds = search.bounds[depth];
+
+                    order.clear();
+                    bounds.clear();
+                    search.uncoloured = candidates;
+                    search.colour_class.resize(words);
+
+                    float previous_classes = 0.0f;
+
+                    while(!graph::bits::none(search.uncoloured.data(), words)) {
+                        auto& colour_class = search.colour_class;
+                        colour_class = search.uncoloured;
+                        float heaviest = 0.0f;
+
+                        for(auto w = 0u; w < words; ++w) {
+                            while(colour_class[w] != 0u) {
+                                const auto bit = static_cast<std::size_t>(__builtin_ctzll(colour_class[w]));
+                                const auto v = w * graph::bits::bits_per_word + bit;
+                                const auto* neighbours = graph.neighbourhood(v);
+
+                                colour_class[w] &= colour_class[w] - 1u;
+                                graph::bits::reset(search.uncoloured.data(), v);
+
+                                // Only words from w onward are still to be read.
+                                for(auto u = w; u < words; ++u) {
+                                    colour_class[u] &= ~neighbours[u];
+                                }
+
+                                heaviest = std::max(heaviest, weights[v]);
+                                order.push_back(v);
+                                bounds.push_back(previous_classes + heaviest);
+                            }
+                        }
+
+                        previous_classes += heaviest;
+                    }
+                }
+
+                /** @brief  Explores the node of the tree whose candidates are at the given depth.
+                 */
+                void expand(Search& search, std::size_t depth) {
+                    if(++search.nodes_since_check == nodes_between_checks) {
+                        search.nodes_since_check = 0u;
+
+                        if(deadline && std::chrono::steady_clock::now() >= *deadline) {
+                            stop.store(true, std::memory_order_relaxed);
+                        }
+                    }
+
+                    if(search.clique_weight > best_weight.load(std::memory_order_relaxed)) {
+                        std::lock_guard<std::mutex> lock{best_mutex};
+
+                        if(search.clique_weight > best_weight.load(std::memory_order_relaxed)) {
+                            best_weight.store(search.clique_weight, std::memory_order_relaxed);
+                            best_clique = search.clique;
+                        }
+                    }
+
+                    if(search.orders.size() <= depth) {
+                        search.orders.resize(depth + 1u);
+                        search.bounds.resize(depth + 1u);
+                    }
+
+                    if(search.candidates.size() <= depth + 1u) {
+                        search.candidates.resize(depth + 2u, std::vector<graph::bits::Word>(words));
+                    }
+
+                    colour(search, depth);
+
+                    // Not references: deeper calls may resize the vectors holding them.
+                    const auto n_candidates = search.orders[depth].size();
+
+                    for(auto k = n_candidates; k-- > 0u;) {
+                        if(stop.load(std::memory_order_relaxed)) { return; }
+
+                        if(search.clique_weight + search.bounds[depth][k] <= best_weight.load(std::memory_order_relaxed)) {
+                            return;
+                        }
+
+                        const auto v = search.orders[depth][k];
+                        auto* candidates = search.candidates[depth].data();
+
+                        graph::bits::intersect(search.candidates[depth + 1u].data(), candidates, graph.neighbourhood(v), words);
+
+                        search.clique.push_back(v);
+                        search.clique_weight += weights[v];
+
+                        expand(search, depth + 1u);
+
+                        search.clique.pop_back();
+                        search.clique_weight -= weights[v];
+
+                        graph::bits::reset(search.candidates[depth].data(), v);
+                    }
+                }
+            };
+        }
+
+        /** @brief  Solves the Maximum (Weight) Clique Problem with a native branch-and-bound.
+         *
+         *  As \ref solve_with_mip, it solves the weighted version of the problem if the vertex
+         *  property of \ref BoostGraph has a publicly accessible weight member, and the unweighted
+         *  version otherwise. Weights must be non-negative, and vertices with zero weight are not
+         *  reported as part of the clique. For directed graphs, two vertices are adjacent if there
+         *  is an arc between them in either direction.
+         *
+         *  The graph is converted to a \ref graph::DenseGraph, which needs n^2 / 8 bytes. Bounds
+         *  come from greedy colourings of the candidate sets, computed with bitset operations.
+         *  The subproblems of the root are spread over the threads of the pool.
+         *
+         *  @tparam BoostGraph  The underlying graph type. Vertices must be stored in a vector.
+         *  @param  g           The graph.
+         *  @param  pool        The threads to use.
+         *  @param  timeout     Optional time limit, in seconds. If it is reached, the solution
+         *                      holds the best clique found and an upper bound on the optimum.
+         *  @return             A structure representing the solution (see \ref MaxCliqueSolution).
+         */
+        template<typename BoostGraph>
+        inline MaxCliqueSolution<BoostGraph> solve_with_bnb(const BoostGraph& g, concurrency::ThreadPool& pool, std::optional<float> timeout = std::nullopt) {
+            static_assert(
+                std::is_same<typename BoostGraph::vertex_list_selector, boost::vecS>::value,
+                "solve_with_bnb relies on vertices to be stored in a vector to map them to the rows of the adjacency matrix."
+            );
+
+            const auto start_time = std::chrono::high_resolution_clock::now();
+
+            std::vector<float> weights(boost::num_vertices(g));
+
+            for(auto v = 0u; v < weights.size(); ++v) {
+                weights[v] = details::get_weight(g[v]);
+            }
+
+            detail::BranchAndBound bnb{graph::DenseGraph::from_boost(g), weights, timeout};
+            const auto result = bnb.solve(pool);
+
+            const auto end_time = std::chrono::high_resolution_clock::now();
+            const float elapsed_time = std::chrono::duration_cast<std::chrono::duration<float>>(end_time - start_time).count();
+
+            return {
+                std::vector<typename boost::graph_traits<BoostGraph>::vertex_descriptor>(result.clique.begin(), result.clique.end()),
+                result.lb, result.ub, elapsed_time
+            };
+        }
+
+        /** @brief  Solves the Maximum (Weight) Clique Problem with a native branch-and-bound,
+         *          on the calling thread.
+         *
+         *  See the overload taking a \ref concurrency::ThreadPool.
+         *
+         *  @tparam BoostGraph  The underlying graph type. Vertices must be stored in a vector.
+         *  @param  g           The graph.
+         *  @param  timeout     Optional time limit, in seconds.
+         *  @return             A structure representing the solution (see \ref MaxCliqueSolution).
+         */
+        template<typename BoostGraph>
+        inline MaxCliqueSolution<BoostGraph> solve_with_bnb(const BoostGraph& g, std::optional<float> timeout = std::nullopt) {
+            concurrency::ThreadPool pool{1u};
+            return solve_with_bnb(g, pool, timeout);
+        }
+    }
+}
+
+#endif //AS_MAX_CLIQUE_BNB_H
@@ -0,0 +1,79 @@
+//
+// Created by alberto on 14/10/26.
+//
+
+#ifndef AS_MAX_CLIQUE_SOLUTION_H
+#define AS_MAX_CLIQUE_SOLUTION_H
+
+#include <boost/graph/graph_traits.hpp>
+#include <vector>
+#include <type_traits>
+
+namespace as {
+    namespace details {
+        // The following two TMP definitions check for a ::weight member in a struct.
+        // This is used to determine whether the graph has a vertex property which
+        // has such a member. In that case, we solve the weighted version of the problem.
+        
+        template<typename T, typename = float>
+        struct has_weight : std::false_type {};
+
+        template<typename T>
+        struct has_weight<T, decltype((void) T::weight, 0.0f)> : std::true_type {};
+
+        // The get_weight function gets the ::weight member of a struct, if such
+        // a member exist and is publicly accessible. Otherwise, it returns 1.0f.
+
+        template<typename VertexProperty>
+        float get_weight(std::false_type, const VertexProperty&) {
+            return 1.0f;
+        }
+
+        template<typename VertexProperty>
+        float get_weight(std::true_type, const VertexProperty& prop) {
+            return prop.weight;
+        }
+
+        template<typename VertexProperty>
+        float get_weight(const VertexProperty& prop) {
+            return get_weight(has_weight<VertexProperty>{}, prop);
+        }
+    }
+
+    namespace max_clique {
+        /** @struct MaxCliqueSolution
+         *  @brief  Contains data about the solution of a Maximum (Weight) Clique Problem.
+         */
+        template<typename BoostGraph>
+        struct MaxCliqueSolution {
+            /**
+             *  List of vertices making up the largest (or heaviest, in the weighted case)
+             *  found by the algorithm. It might be optimal or not.
+             */
+            std::vector<typename boost::graph_traits<BoostGraph>::vertex_descriptor> best_clique;
+
+            /**
+             *  A lower bound on the size of the optimal clique (or on its total weight, in
+             *  the weighted case). If the maximal clique has been found, it coincides with
+             *  the upper bound \ref ub .
+             */
+            float lb;
+
+            /**
+             *  An upper bound on the size of the optimal clique (or on its total weight,
+             *  in the weighted case). If the maximal clique has been found, it coincides
+             *  with the lower bound \ref lb .
+             */
+            float ub;
+
+            /**
+             *  Times taken by the solver to complete. During this time it might or might
+             *  not have found the optimal clique. Check the values of \ref lb and \ref ub
+             *  to verify if the optimal clique was found.
+             */
+            float elapsed_time;
+        };
+    }
+}
+
+#endif //AS_MAX_CLIQUE_SOLUTION_H
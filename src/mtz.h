@@ -16,6 +16,10 @@
 #include <vector>
 #include <numeric>
 #include <map>
+#include <mutex>
+#include <string>
+#include <optional>
+#include <stdexcept>
 
 #include "tsplib.h"
 
@@ -119,6 +123,385 @@ namespace as {
             return tour;
         }
 
+        /** @brief  How \ref MtzSolver forbids subtours.
+         */
+        enum class MtzFormulation {
+            /**
+             * Miller-Tucker-Zemlin constraints on node potentials: compact, but
+             * with a weak linear relaxation.
+             */
+            MTZ,
+
+            /**
+             * Subtour elimination constraints, added by a lazy constraint callback
+             * whenever an integer solution has a subtour. The relaxation is much
+             * stronger, and the model has no quadratic number of constraints.
+             */
+            LAZY_SUBTOUR_ELIMINATION
+        };
+
+        /** @class  MtzSolver
+         *  @brief  A Cplex model of the TSP on all the nodes of an instance, which solves
+         *          the TSP on subsets of nodes by changing bounds instead of rebuilding it.
+         *
+         *          The model is built once, with a variable for each arc. To solve on a subset,
+         *          the arcs touching a node outside the subset get an upper bound of 0, and the
+         *          degree constraints of such a node get a right-hand side of 0; only the nodes
+         *          which entered or left the subset since the previous call are updated. Cplex
+         *          can also be given a starting tour, e.g. from a heuristic or a cache.
+         *
+         *          The model has n^2 variables (and, with \ref MtzFormulation::MTZ, n^2
+         *          constraints), so it suits instances of up to a few hundred nodes, on which
+         *          subsets are solved many times. Calls to \ref solve are serialised, so that
+         *          the solver can be shared, e.g. through \ref SolveOptions.
+         */
+        class MtzSolver {
+            /** @brief  Adds a subtour elimination constraint for each subtour of an integer
+             *          solution, i.e. for each cycle not visiting all nodes of the subset.
+             */
+            class SubtourCallback : public IloCplex::LazyConstraintCallbackI {
+                const MtzSolver& solver;
+
+            public:
+                SubtourCallback(IloEnv env, const MtzSolver& solver) : IloCplex::LazyConstraintCallbackI{env}, solver{solver} {}
+
+                IloCplex::CallbackI* duplicateCallback() const override {
+                    return new (getEnv()) SubtourCallback{*this};
+                }
+
+                void main() override {
+                    const auto& nodes = solver.current_nodes;
+                    const auto k = nodes.size();
+                    std::vector<std::size_t> next(k, k);
+
+                    for(auto i = 0u; i < k; ++i) {
+                        for(auto j = 0u; j < k; ++j) {
+                            if(i != j && getValue(solver.x[nodes[i]][nodes[j]]) > 0.5) {
+                                next[i] = j;
+                                break;
+                            }
+                        }
+                    }
+
+                    std::vector<bool> seen(k, false);
+
+                    for(auto start = 0u; start < k; ++start) {
+                        if(seen[start]) { continue; }
+
+                        std::vector<std::size_t> cycle;
+
+                        for(auto i = start; i < k && !seen[i]; i = next[i]) {
+                            seen[i] = true;
+                            cycle.push_back(i);
+                        }
+
+                        if(cycle.size() == k) { return; }
+
+                        IloExpr expr{getEnv()};
+
+                        for(const auto i : cycle) {
+                            for(const auto j : cycle) {
+                                if(i != j) { expr += solver.x[nodes[i]][nodes[j]]; }
+                            }
+                        }
+
+                        add(expr <= static_cast<IloNum>(cycle.size() - 1u));
+                        expr.end();
+                    }
+                }
+            };
+
+            const tsplib::TSPInstance& instance;
+            std::size_t n;
+            MtzFormulation formulation;
+
+            IloEnv env;
+            IloModel model;
+            IloArray<IloNumVarArray> x;
+            IloNumVarArray u;
+            IloRangeArray out_degree, in_degree;
+
+            /** @brief mtz[i][j] is the MTZ constraint of arc (i, j), with \ref MtzFormulation::MTZ.
+             */
+            IloArray<IloRangeArray> mtz;
+
+            IloCplex cplex;
+
+            /** @brief Which nodes are in the current subset.
+             */
+            std::vector<bool> active;
+
+            /** @brief The nodes of the current subset, as passed to \ref solve.
+             */
+            std::vector<std::uint32_t> current_nodes;
+
+            /** @brief The node whose MTZ constraints are relaxed, as the start of the tour.
+             */
+            std::optional<std::uint32_t> root;
+
+            /** @brief Serialises calls to \ref solve.
+             */
+            std::mutex mutex;
+
+        public:
+            /** @brief              Builds the model on all nodes, with an empty subset.
+             *
+             *  @param instance     The TSP instance, which must outlive the solver.
+             *  @param formulation  How to forbid subtours.
+             */
+            explicit MtzSolver(const tsplib::TSPInstance& instance, MtzFormulation formulation = MtzFormulation::MTZ) :
+                instance{instance}, n{instance.number_of_vertices()}, formulation{formulation}, env{}, model{env},
+                x{env, static_cast<IloInt>(n)}, u{env, static_cast<IloInt>(n)},
+                out_degree{env, static_cast<IloInt>(n)}, in_degree{env, static_cast<IloInt>(n)},
+                mtz{env, static_cast<IloInt>(n)}, active(n, false)
+            {
+                IloExpr expr{env};
+
+                for(auto i = 0u; i < n; ++i) {
+                    x[i] = IloNumVarArray{env, static_cast<IloInt>(n)};
+
+                    for(auto j = 0u; j < n; ++j) {
+                        if(i == j) { continue; }
+
+                        // Arcs start fixed to 0, as the subset is empty.
+                        x[i][j] = IloNumVar{env, 0, 0, IloNumVar::Bool};
+                        expr += x[i][j] * instance.get_distance(i, j);
+                    }
+                }
+
+                model.add(IloObjective{env, expr});
+                expr.clear();
+
+                for(auto i = 0u; i < n; ++i) {
+                    IloExpr fxpr{env};
+
+                    for(auto j = 0u; j < n; ++j) {
+                        if(i != j) {
+                            expr += x[i][j];
+                            fxpr += x[j][i];
+                        }
+                    }
+
+                    out_degree[i] = IloRange{env, 0, expr, 0};
+                    in_degree[i] = IloRange{env, 0, fxpr, 0};
+                    model.add(out_degree[i]);
+                    model.add(in_degree[i]);
+                    expr.clear();
+                    fxpr.end();
+                }
+
+                expr.end();
+
+                if(formulation == MtzFormulation::MTZ) {
+                    const auto big_m = static_cast<IloNum>(n - 1u);
+
+                    for(auto i = 0u; i < n; ++i) {
+                        u[i] = IloNumVar{env, 1, big_m, IloNumVar::Float};
+                    }
+
+                    for(auto i = 0u; i < n; ++i) {
+                        mtz[i] = IloRangeArray{env, static_cast<IloInt>(n)};
+
+                        for(auto j = 0u; j < n; ++j) {
+                            if(i == j) { continue; }
+
+                            // u[i] - u[j] + 1 <= (n - 1) (1 - x[i][j]).
+                            mtz[i][j] = IloRange{env, -IloInfinity, u[i] - u[j] + big_m * x[i][j], big_m - 1};
+                            model.add(mtz[i][j]);
+                        }
+                    }
+                }
+
+                cplex = IloCplex{model};
+
+                if(formulation == MtzFormulation::LAZY_SUBTOUR_ELIMINATION) {
+                    cplex.use(IloCplex::Callback{new (env) SubtourCallback{env, *this}});
+                }
+            }
+
+            MtzSolver(const MtzSolver&) = delete;
+            MtzSolver& operator=(const MtzSolver&) = delete;
+
+            ~MtzSolver() {
+                env.end();
+            }
+
+            /** @brief Solves the TSP on a subset of the nodes.
+             *
+             *  It can throw, in case Cplex fails to provide the optimal solution.
+             *  If Cplex does not crash, in case of error, the corresponding model is saved to file "error.lp".
+             *
+             *  @param  nodes       The subset of nodes of the instance to consider.
+             *  @param  initial     Optionally, a tour of the same nodes given to Cplex as a starting solution.
+             *  @return             The optimal tour, starting from the first node of \p nodes.
+             */
+            std::vector<std::uint32_t> solve(const std::vector<std::uint32_t>& nodes, const std::optional<std::vector<std::uint32_t>>& initial = std::nullopt) {
+                std::lock_guard<std::mutex> lock{mutex};
+
+                for(const auto node : nodes) {
+                    if(node >= n) {
+                        throw std::out_of_range("No such vertex: " + std::to_string(node));
+                    }
+                }
+
+                if(nodes.size() < 3u) {
+                    return nodes;
+                }
+
+                set_subset(nodes);
+
+                if(formulation == MtzFormulation::MTZ) {
+                    set_root(nodes[0u]);
+                }
+
+                if(cplex.getNMIPStarts() > 0) {
+                    cplex.deleteMIPStarts(0, cplex.getNMIPStarts());
+                }
+
+                if(initial) {
+                    add_mip_start(*initial);
+                }
+
+                IloBool solved = false;
+
+                try {
+                    solved = cplex.solve();
+                } catch(const IloException& e) {
+                    throw std::runtime_error("Cplex crashed when solving the problem");
+                }
+
+                if(!solved) {
+                    cplex.exportModel("error.lp");
+                    throw std::runtime_error("Cplex could not find a solution for this instance of the problem");
+                }
+
+                std::vector<std::uint32_t> tour{nodes[0u]};
+
+                while(tour.size() < nodes.size()) {
+                    const auto current = tour.back();
+                    auto successor = current;
+
+                    for(const auto node : nodes) {
+                        if(node != current && cplex.getValue(x[current][node]) > 0.5) {
+                            successor = node;
+                            break;
+                        }
+                    }
+
+                    if(successor == nodes[0u] || successor == current) {
+                        throw std::runtime_error("Cplex returned a solution which is not a tour");
+                    }
+
+                    tour.push_back(successor);
+                }
+
+                return tour;
+            }
+
+        private:
+
+            /** @brief  Activates the arcs and degree constraints of the nodes in the subset, and
+             *          deactivates those of the other nodes, touching only nodes which changed.
+             */
+            void set_subset(const std::vector<std::uint32_t>& nodes) {
+                current_nodes = nodes;
+
+                std::vector<bool> next_active(n, false);
+                std::vector<std::uint32_t> changed;
+
+                for(const auto node : nodes) {
+                    next_active[node] = true;
+                }
+
+                for(auto i = 0u; i < n; ++i) {
+                    if(next_active[i] == active[i]) { continue; }
+
+                    active[i] = next_active[i];
+                    changed.push_back(i);
+
+                    const IloNum degree = active[i] ? 1 : 0;
+                    out_degree[i].setBounds(degree, degree);
+                    in_degree[i].setBounds(degree, degree);
+                }
+
+                // An arc is usable iff both its ends are active, so only the arcs
+                // touching a node which changed need a new bound.
+                for(const auto i : changed) {
+                    for(auto j = 0u; j < n; ++j) {
+                        if(i == j) { continue; }
+
+                        const IloNum ub = (active[i] && active[j]) ? 1 : 0;
+                        x[i][j].setUB(ub);
+                        x[j][i].setUB(ub);
+                    }
+                }
+            }
+
+            /** @brief  Makes node the start of the MTZ ordering, by relaxing the MTZ
+             *          constraints of its arcs and restoring those of the previous root.
+             */
+            void set_root(std::uint32_t node) {
+                if(root == node) { return; }
+
+                const auto big_m = static_cast<IloNum>(n - 1u);
+
+                // Restore all the old root's constraints before relaxing the new root's, so
+                // that the arcs between the two roots end up relaxed.
+                if(root) {
+                    for(auto j = 0u; j < n; ++j) {
+                        if(j != *root) {
+                            mtz[*root][j].setUB(big_m - 1);
+                            mtz[j][*root].setUB(big_m - 1);
+                        }
+                    }
+                }
+
+                for(auto j = 0u; j < n; ++j) {
+                    if(j != node) {
+                        mtz[node][j].setUB(IloInfinity);
+                        mtz[j][node].setUB(IloInfinity);
+                    }
+                }
+
+                root = node;
+            }
+
+            /** @brief  Gives Cplex a tour of the current subset as a starting solution.
+             */
+            void add_mip_start(std::vector<std::uint32_t> tour) {
+                if(tour.size() != current_nodes.size() ||
+                   !std::all_of(tour.begin(), tour.end(), [&] (std::uint32_t v) { return v < n && active[v]; }))
+                {
+                    throw std::invalid_argument("The starting tour does not visit the nodes to consider");
+                }
+
+                // With MTZ, the tour must start from the root, where the potentials start.
+                std::rotate(tour.begin(), std::find(tour.begin(), tour.end(), current_nodes[0u]), tour.end());
+
+                const auto k = tour.size();
+                IloNumVarArray vars{env};
+                IloNumArray values{env};
+
+                for(auto p = 0u; p < k; ++p) {
+                    for(auto q = 0u; q < k; ++q) {
+                        if(p == q) { continue; }
+
+                        vars.add(x[tour[p]][tour[q]]);
+                        values.add(q == (p + 1u) % k ? 1 : 0);
+                    }
+
+                    if(formulation == MtzFormulation::MTZ && p > 0u) {
+                        vars.add(u[tour[p]]);
+                        values.add(static_cast<IloNum>(p));
+                    }
+                }
+
+                cplex.addMIPStart(vars, values, IloCplex::MIPStartRepair);
+                vars.end();
+                values.end();
+            }
+        };
+
         /** @brief Solves a TSP Instance using the Cplex solver via an MTZ model.
          *
          *  It can throw, in case Cplex fails to provide the optimal solution.
@@ -12,6 +12,9 @@
 #include <numeric>
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
 
 namespace as {
     /** @namespace  mwis
@@ -35,6 +38,250 @@ namespace as {
             }
         }
 
+        /** @class  MwisSolver
+         *  @brief  Keeps the data structures of Sewell's library allocated across calls,
+         *          to solve the MWIS repeatedly on graphs with the same number of vertices.
+         *
+         *          The graph is allocated once, in the constructor. Each call to \ref solve
+         *          only copies the weights, and the adjacency matrix is only rewritten (and
+         *          the adjacency lists only rebuilt) when the edges are changed with
+         *          \ref set_edges. This suits pricing loops, where the weights change at each
+         *          iteration but the graph changes rarely, if at all.
+         */
+        class MwisSolver {
+            /** @brief Number of vertices.
+             */
+            std::size_t n;
+
+            detail::MWSSgraph m_graph;
+            detail::MWSSdata m_data;
+            detail::wstable_info m_info;
+            detail::wstable_parameters m_params;
+
+            /** @brief  True when the adjacency matrix changed since the adjacency lists were built.
+             */
+            bool needs_build;
+
+        public:
+            /** @brief      Allocates the graph, without edges.
+             *
+             *  @param n    The number of vertices.
+             */
+            explicit MwisSolver(std::size_t n) : n{n}, needs_build{true} {
+                using namespace mwis::detail;
+
+                reset_pointers(&m_graph, &m_data, &m_info);
+                default_parameters(&m_params);
+
+                assert(numeric::can_type_fit_value<int>(n));
+
+                // We allocate enough memory for the graph, and check whether
+                // we succeeded, with the MWIS-provided function.
+                if(allocate_graph(&m_graph, static_cast<int>(n)) != 0) {
+                    free_max_wstable(&m_graph, &m_data, &m_info);
+                    throw std::runtime_error("Cannot allocate MWIS graph structure.");
+                }
+
+                // For some reason, we need to specify this again.
+                m_graph.n_nodes = static_cast<int>(n);
+
+                // From this moment on, we have to keep in mind that, once more
+                // for unknown reasons, in MWIS vertices are indexed starting
+                // from 1, and not from 0. (!!!)
+                for(std::size_t i = 1u; i <= n; ++i) {
+                    std::fill(&m_graph.adj[i][1u], &m_graph.adj[i][1u] + n, 0);
+                }
+            }
+
+            /** @brief          Allocates the graph, with the edges of the given graph.
+             *
+             *  @param graph    The graph.
+             */
+            explicit MwisSolver(const graph::DenseGraph& graph) : MwisSolver{graph.number_of_vertices()} {
+                set_edges(graph);
+            }
+
+            MwisSolver(const MwisSolver&) = delete;
+            MwisSolver& operator=(const MwisSolver&) = delete;
+
+            ~MwisSolver() {
+                detail::free_max_wstable(&m_graph, &m_data, &m_info);
+            }
+
+            /** @brief  Gives the number of vertices.
+             */
+            std::size_t number_of_vertices() const { return n; }
+
+            /** @brief          Replaces the edges with those of the given graph, decoding the
+             *                  rows of its adjacency matrix directly into Sewell's matrix.
+             *
+             *  @param graph    A graph with \ref number_of_vertices vertices.
+             */
+            void set_edges(const graph::DenseGraph& graph) {
+                assert(graph.number_of_vertices() == n);
+
+                for(std::size_t i = 1u; i <= n; ++i) {
+                    auto* row = &m_graph.adj[i][1u];
+
+                    std::fill(row, row + n, 0);
+                    graph.for_each_neighbour(i - 1u, [&] (std::size_t j) { row[j] = 1; });
+                }
+
+                needs_build = true;
+            }
+
+            /** @brief          Replaces the edges with those of the given Boost graph.
+             *
+             *  @tparam BoostGraph  The underlying undirected graph type. Vertices must be stored in a vector.
+             *  @param graph        A graph with \ref number_of_vertices vertices.
+             */
+            template<typename BoostGraph>
+            void set_edges(const BoostGraph& graph) {
+                static_assert(
+                    std::is_same<typename BoostGraph::vertex_list_selector, boost::vecS>::value,
+                    "MwisSolver only works when vertices are stored in a vector."
+                );
+
+                assert(boost::num_vertices(graph) == n);
+
+                for(std::size_t i = 1u; i <= n; ++i) {
+                    std::fill(&m_graph.adj[i][1u], &m_graph.adj[i][1u] + n, 0);
+                }
+
+                for(const auto& edge : graph::edges(graph)) {
+                    const auto source = boost::source(edge, graph) + 1;
+                    const auto target = boost::target(edge, graph) + 1;
+
+                    if(source != target) {
+                        m_graph.adj[source][target] = 1;
+                        m_graph.adj[target][source] = 1;
+                    }
+                }
+
+                needs_build = true;
+            }
+
+            /** @brief Finds the maximum-weight independent set with the given weights.
+             *
+             *  (For more information on this problem, see as::mwis).
+             *
+             *  @param weights      The vector of weights, indexed as the vertices.
+             *  @return             The maximum-weight independent set. If an error occurs, we return an empty vector.
+             */
+            std::vector<std::size_t> solve(const std::vector<std::uint32_t>& weights) {
+                assert(weights.size() == n);
+
+                // Sewell's library, for some reason, uses int as weight type,
+                // even though it says that weights should be all non-negative.
+                // So, we have to make sure that, whatever size int is on the
+                // current platform, we can put all our uint32_t weights in it.
+                assert(std::all_of(weights.begin(), weights.end(),
+                    [] (const std::uint32_t& weight) { return numeric::can_type_fit_value<int>(weight); }
+                ));
+
+                using namespace mwis::detail;
+
+                if(n == 0u) {
+                    return std::vector<std::size_t>{};
+                }
+
+                // Minimum weight to achieve.
+                int m_weight_lower_bound = static_cast<int>(
+                    *std::min_element(weights.begin(), weights.end())
+                );
+
+                // Maximum weight achievable.
+                int m_weight_upper_bound = static_cast<int>(
+                    std::accumulate(weights.begin(), weights.end(), 0u)
+                );
+
+                // Variables that will get error codes from Sewell's library.
+                int m_initialised = 0, m_called = 0;
+
+                // Create the stable set vector.
+                // We create it here, because MWIS uses goto to jump to a label, and
+                // creating it later would mean the jump would cross this initialisation,
+                // which is not allowed.
+                std::vector<std::size_t> stable_set{};
+
+                // We set the weights (remember, vertices start from 1):
+                std::transform(weights.begin(), weights.end(), &m_graph.weight[1u],
+                    [] (std::uint32_t weight) { return static_cast<int>(weight); }
+                );
+
+                if(needs_build) {
+                    // build_graph fills in:
+                    //  * m_graph.n_edges
+                    //  * m_graph.edge_list
+                    //  * m_graph.adj_last
+                    //  * m_graph.node_list[i].adjacent
+                    //  * m_graph.node_list[i].name
+                    //  * m_graph.node_list[i].degree
+                    //  * m_graph.node_list[i].adjv
+                    //  * m_graph.node_list[i].adj2
+                    // (see wstable.c:1562)
+                    // None of these depends on the weights, so it only needs to run
+                    // when the edges change.
+                    build_graph(&m_graph);
+
+                    // Checks consistency of the internal variables of m_graph.
+                    assert(check_graph(&m_graph) == 1);
+
+                    needs_build = false;
+                }
+
+                // Initialise the solver, and check init was ok.
+                m_initialised = initialize_max_wstable(&m_graph, &m_info);
+                MWIScheck_rval(m_initialised, "Cannot initialise MWIS algorithm.");
+
+                // Run the solver, and check it completed ok.
+                m_called = call_max_wstable(&m_graph, &m_data, &m_params, &m_info, m_weight_upper_bound, m_weight_lower_bound);
+
+                // If the solver did not work, return an empty set.
+                if(m_called == 0) {
+                    // Resize the stable set with the size of the set found by MWIS.
+                    stable_set.resize(m_data.n_best);
+
+                    // Fill in the values.
+                    for(int i = 1; i <= m_data.n_best; ++i) {
+                        if(m_data.best_sol[i] != NULL) {
+                            int vertex_id = m_data.best_sol[i]->name - 1;
+                            assert(vertex_id >= 0);
+
+                            stable_set[i - 1] = static_cast<std::size_t>(vertex_id);
+                        }
+                    }
+                }
+
+                // Free the memory used by this call, but keep the graph.
+                // Notice that we *have* to use a label called ``CLEANUP'',
+                // as the C code has a goto which depends on this.
+                CLEANUP: free_data(&m_data);
+
+                return stable_set;
+            }
+        };
+
+        /** @brief Finds the maximum-weight independent set in the given graph, with the given weights.
+         *
+         *  (For more information on this problem, see as::mwis).
+         *
+         *  The adjacency matrix passed to Sewell's library is read directly off the
+         *  rows of the dense graph. To solve the problem repeatedly on graphs of the
+         *  same size, use a \ref MwisSolver instead.
+         *
+         *  @param weights      The vector of weights, indexed as the vertices.
+         *  @param graph        The graph.
+         *  @return             The maximum-weight independent set. If an error occurs, we return an empty vector.
+         */
+        inline std::vector<std::size_t> mwis(
+            const std::vector<std::uint32_t>& weights,
+            const graph::DenseGraph& graph
+        ) {
+            MwisSolver solver{graph};
+            return solver.solve(weights);
+        }
+
         /** @brief Finds the maximum-weight independent set in the given graph, with the given weights.
          *
          *  (For more information on this problem, see as::mwis).
@@ -44,7 +291,7 @@ namespace as {
          *  @param graph        The graph.
          *  @return             The maximum-weight independent set. If an error occurs, we return an empty vector.
          */
-        template<typename BoostGraph>
+        template<typename BoostGraph, typename = std::enable_if_t<!std::is_same<BoostGraph, graph::DenseGraph>::value>>
         inline std::vector<typename boost::graph_traits<BoostGraph>::vertex_descriptor> mwis(
             const std::vector<std::uint32_t>& weights,
             const BoostGraph& graph
@@ -62,129 +309,11 @@ namespace as {
                 "mwis is intended to be used with undirected graphs."
             );
 
-            // Sewell's library, for some reason, uses int as weight type,
-            // even though it says that weights should be all non-negative.
-            // So, we have to make sure that, whatever size int is on the
-            // current platform, we can put all our uint32_t weights in it.
-            assert(std::all_of(weights.begin(), weights.end(),
-                [] (const std::uint32_t& weight) { return numeric::can_type_fit_value<int>(weight); }
-            ));
-
-            using namespace mwis::detail;
-
-            MWSSgraph m_graph;
-            MWSSdata m_data;
-            wstable_info m_info;
-            wstable_parameters m_params;
+            const auto stable_set = mwis(weights, graph::DenseGraph::from_boost(graph));
 
-            // Minimum weight to achieve.
-            int m_weight_lower_bound = static_cast<int>(
-                *std::min_element(weights.begin(), weights.end())
+            return std::vector<typename boost::graph_traits<BoostGraph>::vertex_descriptor>(
+                stable_set.begin(), stable_set.end()
             );
-
-            // Maximum weight achievable.
-            int m_weight_upper_bound = static_cast<int>(
-                std::accumulate(weights.begin(), weights.end(), 0u)
-            );
-
-            // Variables that will get error codes from Sewell's library.
-            int m_graph_allocated = 0, m_initialised = 0, m_called = 0;
-
-            // Create the stable set vector.
-            // We create it here, because MWIS uses goto to jump to a label, and
-            // creating it later would mean the jump would cross this initialisation,
-            // which is not allowed.
-            std::vector<typename boost::graph_traits<BoostGraph>::vertex_descriptor> stable_set{};
-
-            // Initialise the data.
-            reset_pointers(&m_graph, &m_data, &m_info);
-            default_parameters(&m_params);
-
-            const auto num_vertices = boost::num_vertices(graph);
-
-            // We allocate enough memory for the graph, and check whether
-            // we succeeded, with the MWIS-provided function.
-            m_graph_allocated = allocate_graph(&m_graph, num_vertices);
-            MWIScheck_rval(m_graph_allocated, "Cannot allocate MWIS graph structure.");
-
-            // For some reason, we need to specify this again.
-            m_graph.n_nodes = num_vertices;
-
-            // From this moment on, we have to keep in mind that, once more
-            // for unknown reasons, in MWIS vertices are indexed starting
-            // from 1, and not from 0. (!!!)
-
-            // We set the weights:
-            for(std::size_t i = 1u; i <= num_vertices; ++i) {
-                m_graph.weight[i] = weights.at(i - 1u);
-
-                // We also use this loop to clear the adjacency matrix:
-                for(std::size_t j = 1u; j <= num_vertices; ++j) {
-                    m_graph.adj[i][j] = 0;
-                }
-            }
-
-            // This should be redundant, but we make sure once more that
-            // no overflow happened and some weight became negative:
-            assert(std::all_of(&m_graph.weight[1], &m_graph.weight[num_vertices],
-                [] (const int& weight) { return weight >= 0; }
-            ));
-
-            // We set the adjacency matrix:
-            for(const auto& edge : graph::edges(graph)) {
-                const auto source = boost::source(edge, graph) + 1;
-                const auto target = boost::target(edge, graph) + 1;
-                m_graph.adj[source][target] = 1;
-                m_graph.adj[target][source] = 1;
-            }
-
-            // build_graph fills in:
-            //  * m_graph.n_edges
-            //  * m_graph.edge_list
-            //  * m_graph.adj_last
-            //  * m_graph.node_list[i].adjacent
-            //  * m_graph.node_list[i].name
-            //  * m_graph.node_list[i].degree
-            //  * m_graph.node_list[i].adjv
-            //  * m_graph.node_list[i].adj2
-            // (see wstable.c:1562)
-            build_graph(&m_graph);
-
-            // Checks consistency of the internal variables of m_graph.
-            assert(check_graph(&m_graph) == 1);
-
-            // Initialise the solver, and check init was ok.
-            m_initialised = initialize_max_wstable(&m_graph, &m_info);
-            MWIScheck_rval(m_initialised, "Cannot initialise MWIS algorithm.");
-
-            // Run the solver, and check it completed ok.
-            m_called = call_max_wstable(&m_graph, &m_data, &m_params, &m_info, m_weight_upper_bound, m_weight_lower_bound);
-
-            // If the solver did not work, return an empty set.
-            if(m_called != 0) {
-                free_max_wstable(&m_graph, &m_data, &m_info);
-                return std::vector<typename boost::graph_traits<BoostGraph>::vertex_descriptor>{};
-            }
-
-            // Resize the stable set with the size of the set found by MWIS.
-            stable_set.resize(m_data.n_best);
-
-            // Fill in the values.
-            for(int i = 1; i <= m_data.n_best; ++i) {
-                if(m_data.best_sol[i] != NULL) {
-                    int vertex_id = m_data.best_sol[i]->name - 1;
-                    assert(vertex_id >= 0);
-
-                    stable_set[i - 1] = static_cast<typename boost::graph_traits<BoostGraph>::vertex_descriptor>(vertex_id);
-                }
-            }
-
-            // Free the memory used by MWIS.
-            // Notice that we *have* to use a label called ``CLEANUP'',
-            // as the C code has a goto which depends on this.
-            CLEANUP: free_max_wstable(&m_graph, &m_data, &m_info);
-
-            return stable_set;
         }
     }
 }
@@ -7,6 +7,14 @@
 
 #include <string>
 #include <vector>
+#include <limits>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
 
 #include "tsplib.h"
 
@@ -30,15 +38,33 @@ namespace as {
              */
             std::vector<float> prizes;
 
+            /** @brief The vertex where tours start and end.
+             */
+            std::size_t depot;
+
+            /** @brief Distance of going from the depot to each vertex, and back.
+             */
+            std::vector<float> round_trip_distances;
+
+            /** @brief  The vertices other than the depot which can be visited within the
+             *          maximum travel time, by decreasing prize over round trip distance.
+             */
+            std::vector<std::uint32_t> ratio_ranking;
+
         public:
 
             /** @brief              Builds an instance from an OPLIB file.
+             *
+             *                      The file can also be a binary instance file written
+             *                      by \ref write_binary, which includes the prizes.
              *
              *  @param oplib_file   The file containing the instance data.
              */
             OPInstance(std::string oplib_file) : TSPInstance(oplib_file) {
                 max_travel_time = tsp.get_specification<float>("COST_LIMIT");
                 set_prizes();
+                set_depot();
+                set_round_trips();
             }
 
             /** @brief          Returns the prize associated with a vertex.
@@ -61,27 +87,377 @@ namespace as {
                 return max_travel_time;
             }
 
+            /** @brief  Gets the depot, where tours start and end. It is the first vertex
+             *          of the DEPOT_SECTION, if the file has one, and vertex 0 otherwise.
+             *
+             *  @return The depot.
+             */
+            std::size_t get_depot() const {
+                return depot;
+            }
+
+            /** @brief          Returns the distance of going from the depot to a vertex, and back.
+             *
+             *  @param vertex   The vertex.
+             *  @return         The round trip distance.
+             */
+            float get_round_trip_distance(std::size_t vertex) const {
+                if(vertex >= n_vertices) {
+                    throw std::out_of_range("No such vertex: " + std::to_string(vertex));
+                }
+                return round_trip_distances[vertex];
+            }
+
+            /** @brief          Tells whether a vertex can be visited at all, i.e. whether going
+             *                  there from the depot and back is within the maximum travel time.
+             *
+             *  @param vertex   The vertex.
+             *  @return         True iff the vertex is within reach.
+             */
+            bool is_reachable(std::size_t vertex) const {
+                return get_round_trip_distance(vertex) <= max_travel_time;
+            }
+
+            /** @brief  Gives the vertices, other than the depot, which are within reach,
+             *          by decreasing ratio between their prize and their round trip distance.
+             *
+             *  @return The vertices, best first.
+             */
+            const std::vector<std::uint32_t>& get_vertices_by_prize_ratio() const {
+                return ratio_ranking;
+            }
+
+            /** @brief              Sorts some vertices by decreasing ratio between their prize and
+             *                      their distance from a given vertex, e.g. the last one visited.
+             *
+             *  @param from         The vertex from which distances are measured.
+             *  @param candidates   The vertices to sort.
+             *  @return             The candidates, best first.
+             */
+            std::vector<std::uint32_t> rank_by_prize_ratio(std::size_t from, std::vector<std::uint32_t> candidates) const {
+                if(from >= n_vertices) {
+                    throw std::out_of_range("No such vertex: " + std::to_string(from));
+                }
+
+                std::vector<std::pair<float, std::uint32_t>> keyed(candidates.size());
+
+                for(auto i = 0u; i < candidates.size(); ++i) {
+                    keyed[i] = {prize_ratio(get_prize(candidates[i]), get_distance_unchecked(from, candidates[i])), candidates[i]};
+                }
+
+                std::stable_sort(keyed.begin(), keyed.end(), [] (const auto& a, const auto& b) { return a.first > b.first; });
+
+                for(auto i = 0u; i < candidates.size(); ++i) {
+                    candidates[i] = keyed[i].second;
+                }
+
+                return candidates;
+            }
+
         private:
 
+            /** @brief  Prize per unit of distance; free prizes come first.
+             */
+            static float prize_ratio(float prize, float distance) {
+                return distance > 0.0f ? prize / distance : std::numeric_limits<float>::infinity();
+            }
+
+            void set_depot() {
+                depot = 0u;
+
+                if(tsp.has_data("DEPOT_SECTION") && !tsp.get_data("DEPOT_SECTION").empty()) {
+                    const auto depot_id = tsp.get_data("DEPOT_SECTION").front();
+
+                    if(depot_id < 1.0f || depot_id > static_cast<float>(n_vertices)) {
+                        throw std::out_of_range("Invalid depot: " + std::to_string(depot_id));
+                    }
+
+                    depot = static_cast<std::size_t>(depot_id) - 1u;
+                }
+            }
+
+            void set_round_trips() {
+                round_trip_distances.resize(n_vertices);
+
+                for(auto v = 0u; v < n_vertices; ++v) {
+                    round_trip_distances[v] = get_distance_unchecked(depot, v) + get_distance_unchecked(v, depot);
+                }
+
+                ratio_ranking.clear();
+
+                for(auto v = 0u; v < n_vertices; ++v) {
+                    if(v != depot && round_trip_distances[v] <= max_travel_time) {
+                        ratio_ranking.push_back(v);
+                    }
+                }
+
+                std::stable_sort(ratio_ranking.begin(), ratio_ranking.end(), [this] (std::uint32_t v, std::uint32_t w) {
+                    return prize_ratio(prizes[v], round_trip_distances[v]) > prize_ratio(prizes[w], round_trip_distances[w]);
+                });
+            }
+
             void set_prizes() {
-                auto p_list = tsp.get_data("NODE_SCORE_SECTION");
-                prizes.resize(n_vertices);
+                const auto& p_list = tsp.get_data("NODE_SCORE_SECTION");
+                prizes.assign(n_vertices, 0.0f);
 
                 // Coordinates come in couples:
                 // - The first number is the vertex id
                 // - The second number is the prize
-                // Here we assume the vertex id is always sequential.
-                for(auto i = 0u; i < p_list.size(); i += 2) {
+                // Vertices can come in any order; those which are not listed have no prize.
+                std::vector<bool> seen(n_vertices, false);
+
+                if(p_list.size() % 2u != 0u) {
+                    throw std::logic_error("Node prize section with an odd number of values: the last vertex has no prize");
+                }
+
+                for(auto i = 0u; i + 1u < p_list.size(); i += 2) {
+                    if(p_list[i] < 1.0f || p_list[i] > static_cast<float>(n_vertices)) {
+                        throw std::out_of_range("Prize given for no such vertex: " + std::to_string(p_list[i]));
+                    }
+
                     std::size_t vertex_id = static_cast<std::size_t>(p_list[i]) - 1;
 
-                    if(vertex_id != i / 2) {
-                        throw std::logic_error("Node prizes not given in sequential order");
+                    if(seen[vertex_id]) {
+                        throw std::logic_error("Node prize given twice for vertex " + std::to_string(vertex_id + 1));
                     }
 
+                    seen[vertex_id] = true;
                     prizes[vertex_id] = p_list[i + 1];
                 }
             }
         };
+
+        /** @class  OPTour
+         *  @brief  A tour of an \ref OPInstance, starting and ending at the depot, which
+         *          keeps its length and prize up to date, so that the cost and feasibility
+         *          of inserting or removing a vertex are computed in O(1).
+         *
+         *          The vertices are kept in a contiguous vector, together with the position
+         *          of each vertex of the instance in the tour; changing the tour takes time
+         *          linear in its size, to shift the vertices after the change.
+         */
+        class OPTour {
+            /** @brief Marks vertices which are not in the tour.
+             */
+            static constexpr std::uint32_t absent = std::numeric_limits<std::uint32_t>::max();
+
+            const OPInstance& instance;
+
+            /** @brief The vertices visited, starting with the depot. The return to the
+             *         depot is implicit.
+             */
+            std::vector<std::uint32_t> tour;
+
+            /** @brief position[v] is the index of v in \ref tour, or \ref absent.
+             */
+            std::vector<std::uint32_t> position;
+
+            float tour_length;
+            float tour_prize;
+
+        public:
+            /** @brief              Builds the tour visiting only the depot.
+             *
+             *  @param instance     The instance, which must outlive the tour.
+             */
+            explicit OPTour(const OPInstance& instance) :
+                instance{instance}, position(instance.number_of_vertices(), absent),
+                tour_length{0.0f}, tour_prize{instance.get_prize(instance.get_depot())}
+            {
+                tour.push_back(static_cast<std::uint32_t>(instance.get_depot()));
+                position[instance.get_depot()] = 0u;
+            }
+
+            /** @brief              Builds a tour from a sequence of vertices.
+             *
+             *  @param instance     The instance, which must outlive the tour.
+             *  @param vertices     The vertices, which must include the depot, each once.
+             */
+            OPTour(const OPInstance& instance, const std::vector<std::uint32_t>& vertices) :
+                instance{instance}, position(instance.number_of_vertices(), absent)
+            {
+                const auto depot = std::find(vertices.begin(), vertices.end(), instance.get_depot());
+
+                if(depot == vertices.end()) {
+                    throw std::invalid_argument("The tour does not visit the depot");
+                }
+
+                // Rotate so that the tour starts at the depot.
+                tour.insert(tour.end(), depot, vertices.end());
+                tour.insert(tour.end(), vertices.begin(), depot);
+
+                for(auto i = 0u; i < tour.size(); ++i) {
+                    if(tour[i] >= position.size()) {
+                        throw std::out_of_range("No such vertex: " + std::to_string(tour[i]));
+                    }
+
+                    if(position[tour[i]] != absent) {
+                        throw std::invalid_argument("The tour visits vertex " + std::to_string(tour[i]) + " twice");
+                    }
+
+                    position[tour[i]] = i;
+                }
+
+                recompute();
+            }
+
+            /** @brief  Gives the vertices visited, starting with the depot.
+             */
+            const std::vector<std::uint32_t>& vertices() const { return tour; }
+
+            /** @brief  Gives the number of vertices visited, including the depot.
+             */
+            std::size_t size() const { return tour.size(); }
+
+            /** @brief  Gives the length of the tour, including the return to the depot.
+             */
+            float length() const { return tour_length; }
+
+            /** @brief  Gives the prize collected.
+             */
+            float prize() const { return tour_prize; }
+
+            /** @brief  Tells whether the length is within the maximum travel time.
+             */
+            bool is_feasible() const { return tour_length <= instance.get_max_travel_time(); }
+
+            /** @brief  Tells whether the tour visits a vertex.
+             */
+            bool contains(std::size_t vertex) const {
+                return vertex < position.size() && position[vertex] != absent;
+            }
+
+            /** @brief  Gives the index of a vertex in the tour, or nullopt if it doesn't
+             *          visit the vertex.
+             */
+            std::optional<std::size_t> position_of(std::size_t vertex) const {
+                if(!contains(vertex)) { return std::nullopt; }
+                return position[vertex];
+            }
+
+            /** @brief          Gives the change in length of inserting a vertex at a position.
+             *
+             *  @param vertex   A vertex not in the tour.
+             *  @param index    Where to insert it, between 1 (after the depot) and \ref size()
+             *                  (before going back to the depot).
+             *  @return         The increase in length.
+             */
+            float insertion_delta(std::size_t vertex, std::size_t index) const {
+                assert(index >= 1u && index <= tour.size());
+
+                const auto previous = tour[index - 1u];
+                const auto next = tour[index % tour.size()];
+
+                return instance.get_distance_unchecked(previous, vertex) +
+                       instance.get_distance_unchecked(vertex, next) -
+                       instance.get_distance_unchecked(previous, next);
+            }
+
+            /** @brief  Tells whether inserting a vertex at a position keeps the tour within
+             *          the maximum travel time.
+             */
+            bool can_insert(std::size_t vertex, std::size_t index) const {
+                return tour_length + insertion_delta(vertex, index) <= instance.get_max_travel_time();
+            }
+
+            /** @brief          Finds the position where inserting a vertex lengthens the tour
+             *                  the least.
+             *
+             *  @param vertex   A vertex not in the tour.
+             *  @return         The position, and the increase in length.
+             */
+            std::pair<std::size_t, float> best_insertion(std::size_t vertex) const {
+                std::pair<std::size_t, float> best{1u, insertion_delta(vertex, 1u)};
+
+                for(auto index = 2u; index <= tour.size(); ++index) {
+                    const auto delta = insertion_delta(vertex, index);
+
+                    if(delta < best.second) {
+                        best = {index, delta};
+                    }
+                }
+
+                return best;
+            }
+
+            /** @brief          Inserts a vertex at a position.
+             *
+             *  @param vertex   A vertex not in the tour.
+             *  @param index    Where to insert it, as in \ref insertion_delta.
+             */
+            void insert(std::size_t vertex, std::size_t index) {
+                if(vertex >= position.size()) {
+                    throw std::out_of_range("No such vertex: " + std::to_string(vertex));
+                }
+
+                if(index == 0u || index > tour.size()) {
+                    throw std::out_of_range("Cannot insert a vertex at position " + std::to_string(index));
+                }
+
+                if(contains(vertex)) {
+                    throw std::invalid_argument("The tour already visits vertex " + std::to_string(vertex));
+                }
+
+                tour_length += insertion_delta(vertex, index);
+                tour_prize += instance.get_prize(vertex);
+                tour.insert(tour.begin() + index, static_cast<std::uint32_t>(vertex));
+                update_positions(index);
+            }
+
+            /** @brief          Gives the change in length of removing the vertex at a position.
+             *
+             *  @param index    The position of the vertex, other than 0 (the depot).
+             *  @return         The decrease in length.
+             */
+            float removal_delta(std::size_t index) const {
+                assert(index >= 1u && index < tour.size());
+
+                const auto previous = tour[index - 1u];
+                const auto vertex = tour[index];
+                const auto next = tour[(index + 1u) % tour.size()];
+
+                return instance.get_distance_unchecked(previous, vertex) +
+                       instance.get_distance_unchecked(vertex, next) -
+                       instance.get_distance_unchecked(previous, next);
+            }
+
+            /** @brief          Removes the vertex at a position.
+             *
+             *  @param index    The position of the vertex, other than 0 (the depot).
+             */
+            void remove(std::size_t index) {
+                if(index == 0u || index >= tour.size()) {
+                    throw std::out_of_range("Cannot remove the vertex at position " + std::to_string(index));
+                }
+
+                tour_length -= removal_delta(index);
+                tour_prize -= instance.get_prize(tour[index]);
+                position[tour[index]] = absent;
+                tour.erase(tour.begin() + index);
+                update_positions(index);
+            }
+
+            /** @brief  Computes the length and prize from scratch, e.g. to get rid of
+             *          rounding errors after many changes.
+             */
+            void recompute() {
+                tour_length = 0.0f;
+                tour_prize = 0.0f;
+
+                for(auto i = 0u; i < tour.size(); ++i) {
+                    tour_length += instance.get_distance_unchecked(tour[i], tour[(i + 1u) % tour.size()]);
+                    tour_prize += instance.get_prize(tour[i]);
+                }
+            }
+
+        private:
+
+            void update_positions(std::size_t from) {
+                for(auto i = from; i < tour.size(); ++i) {
+                    position[tour[i]] = static_cast<std::uint32_t>(i);
+                }
+            }
+        };
     }
 }
 
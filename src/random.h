@@ -10,6 +10,13 @@
 #include <algorithm>
 #include <numeric>
 #include <type_traits>
+#include <vector>
+#include <array>
+#include <limits>
+#include <cstdint>
+#include <iterator>
+#include <unordered_set>
+#include <cassert>
 #include "containers.h"
 
 namespace as {
@@ -32,13 +39,342 @@ namespace as {
             return std::mt19937(seeds);
         }
 
+        /** @class  SplitMix64
+         *  @brief  A tiny 64-bit pseudo-random number generator, mostly useful to expand
+         *          a single seed into the state of a larger generator.
+         *
+         *          It satisfies the UniformRandomBitGenerator requirements, so it can be
+         *          used with the standard distributions.
+         */
+        class SplitMix64 {
+            std::uint64_t state;
+
+        public:
+            using result_type = std::uint64_t;
+
+            explicit SplitMix64(std::uint64_t seed = 0u) : state{seed} {}
+
+            static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+            static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+            result_type operator()() {
+                std::uint64_t z = (state += 0x9e3779b97f4a7c15u);
+                z = (z ^ (z >> 30u)) * 0xbf58476d1ce4e5b9u;
+                z = (z ^ (z >> 27u)) * 0x94d049bb133111ebu;
+                return z ^ (z >> 31u);
+            }
+        };
+
+        /** @class  Xoshiro256StarStar
+         *  @brief  The xoshiro256** pseudo-random number generator, by Blackman and Vigna.
+         *
+         *          Its state is 32 bytes (against about 5 KB for std::mt19937), it is faster,
+         *          and it has good statistical quality for all purposes except cryptography.
+         *          It satisfies the UniformRandomBitGenerator requirements, so it can be used
+         *          with the standard distributions.
+         *
+         *          The period is 2^256 - 1, and \ref jump advances the state by 2^128 steps in
+         *          constant time. Therefore, \ref split gives generators whose sequences do not
+         *          overlap in practice, which can be handed to different threads.
+         */
+        class Xoshiro256StarStar {
+            std::array<std::uint64_t, 4u> state;
+
+            static constexpr std::uint64_t rotl(std::uint64_t x, int k) {
+                return (x << k) | (x >> (64 - k));
+            }
+
+            /** @brief  Advances the state by the number of steps encoded by the polynomial.
+             */
+            void jump(const std::array<std::uint64_t, 4u>& polynomial) {
+                std::array<std::uint64_t, 4u> jumped{};
+
+                for(const auto word : polynomial) {
+                    for(auto b = 0u; b < 64u; ++b) {
+                        if(word & (std::uint64_t{1u} << b)) {
+                            for(auto i = 0u; i < 4u; ++i) { jumped[i] ^= state[i]; }
+                        }
+
+                        (*this)();
+                    }
+                }
+
+                state = jumped;
+            }
+
+        public:
+            using result_type = std::uint64_t;
+
+            /** @brief          Builds a generator, expanding the seed with \ref SplitMix64.
+             *
+             *  @param seed     The seed.
+             */
+            explicit Xoshiro256StarStar(std::uint64_t seed = 0u) {
+                this->seed(seed);
+            }
+
+            /** @brief          Builds a generator with the given state, which must not be all zeros.
+             *
+             *  @param state    The state.
+             */
+            explicit Xoshiro256StarStar(const std::array<std::uint64_t, 4u>& state) : state{state} {
+                assert(std::any_of(state.begin(), state.end(), [] (std::uint64_t w) { return w != 0u; }));
+            }
+
+            /** @brief          Re-seeds the generator, expanding the seed with \ref SplitMix64.
+             *
+             *  @param seed     The seed.
+             */
+            void seed(std::uint64_t seed) {
+                SplitMix64 expander{seed};
+                std::generate(state.begin(), state.end(), std::ref(expander));
+            }
+
+            static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+            static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+            result_type operator()() {
+                const auto result = rotl(state[1] * 5u, 7) * 9u;
+                const auto t = state[1] << 17u;
+
+                state[2] ^= state[0];
+                state[3] ^= state[1];
+                state[1] ^= state[2];
+                state[0] ^= state[3];
+                state[2] ^= t;
+                state[3] = rotl(state[3], 45);
+
+                return result;
+            }
+
+            /** @brief  Advances the generator by 2^128 steps.
+             */
+            void jump() {
+                jump({0x180ec6d33cfd0abau, 0xd5a61266f0c9392cu, 0xa9582618e03fc9aau, 0x39abdc4529b1661cu});
+            }
+
+            /** @brief  Advances the generator by 2^192 steps.
+             */
+            void long_jump() {
+                jump({0x76e15d3efefdcbbfu, 0xc5004e441c522fb3u, 0x77710069854ee241u, 0x39109bb02acbe635u});
+            }
+
+            /** @brief  Gives a generator which continues the current sequence, and
+             *          moves this one 2^128 steps ahead, so that the two sequences
+             *          do not overlap for the next 2^128 draws.
+             *
+             *  @return The new generator.
+             */
+            Xoshiro256StarStar split() {
+                auto child = *this;
+                jump();
+                return child;
+            }
+
+            /** @brief  Gives the state of the generator.
+             */
+            const std::array<std::uint64_t, 4u>& get_state() const {
+                return state;
+            }
+
+            bool operator==(const Xoshiro256StarStar& other) const { return state == other.state; }
+            bool operator!=(const Xoshiro256StarStar& other) const { return state != other.state; }
+        };
+
+        /** @brief  Gets a \ref Xoshiro256StarStar generator seeded by std::random_device.
+         *
+         *  @return The generator.
+         */
+        inline Xoshiro256StarStar get_seeded_xoshiro() {
+            std::random_device random_source;
+            std::array<std::uint64_t, 4u> state{};
+
+            // Do not rely on random_device giving 64 bits at a time.
+            for(auto& word : state) {
+                word = (static_cast<std::uint64_t>(random_source()) << 32u) ^ random_source();
+            }
+
+            // The all-zero state is the only forbidden one.
+            if(std::all_of(state.begin(), state.end(), [] (std::uint64_t w) { return w == 0u; })) {
+                state[0] = 1u;
+            }
+
+            return Xoshiro256StarStar{state};
+        }
+
+        /** @brief          Gets independent generators, e.g. one per thread.
+         *
+         *  The first generator is seeded with \p seed, and each of the others starts
+         *  2^128 steps after the previous one.
+         *
+         *  @param n        The number of generators.
+         *  @param seed     The seed.
+         *  @return         The generators.
+         */
+        inline std::vector<Xoshiro256StarStar> make_streams(std::size_t n, std::uint64_t seed) {
+            std::vector<Xoshiro256StarStar> streams;
+            streams.reserve(n);
+
+            Xoshiro256StarStar generator{seed};
+
+            for(auto i = 0u; i < n; ++i) {
+                streams.push_back(generator.split());
+            }
+
+            return streams;
+        }
+
+        namespace detail {
+            /** @brief  Gives the generator used by the functions which are not passed one.
+             *
+             *  It is seeded the first time each thread uses it, so that those functions
+             *  do not build and seed a new generator on every call.
+             */
+            inline Xoshiro256StarStar& thread_prng() {
+                thread_local Xoshiro256StarStar prng = get_seeded_xoshiro();
+                return prng;
+            }
+        }
+
+        /** @brief  Moves a random sample of the elements of a container to its front, by
+         *          shuffling the container partially. The samples are guaranteed to be
+         *          unique. If we are requesting more samples than elements in the container,
+         *          the whole container is shuffled.
+         *
+         *          No copy is made, and it takes time proportional to the number of samples
+         *          (with random-access iterators).
+         *
+         *  @tparam Container    The container type. Must be usable with std::begin() and std::end().
+         *  @tparam Prng         The pseudo-random number generator type to use.
+         *  @param container     The container to sample.
+         *  @param how_many      The number of samples to extract.
+         *  @param prng          The pseudo-random number generator.
+         *  @return              The number of samples, which are the first elements of \ref container.
+         */
+        template<class Container, class Prng>
+        inline typename Container::size_type sample_in_place(Container& container, typename Container::size_type how_many, Prng&& prng) {
+            using size_type = typename Container::size_type;
+
+            const auto length = std::distance(std::begin(container), std::end(container));
+
+            assert(length >= 0);
+
+            if(how_many > static_cast<size_type>(length)) {
+                how_many = static_cast<size_type>(length);
+            }
+
+            auto begin = std::begin(container);
+            auto remaining = static_cast<size_type>(length);
+
+            for(size_type i = 0u; i < how_many; ++i) {
+                auto piv = begin;
+                auto dist = std::uniform_int_distribution<size_type>(0u, remaining - 1u);
+
+                std::advance(piv, dist(prng));
+                std::swap(*begin, *piv);
+
+                ++begin;
+                --remaining;
+            }
+
+            return how_many;
+        }
+
+        /** @brief  Draws distinct integers from 0 to n - 1, uniformly among all subsets of
+         *          that size. If we are requesting more integers than n, all of them are returned.
+         *
+         *          It uses Floyd's algorithm, which takes time and memory proportional to
+         *          the number of integers drawn, regardless of n. The integers are returned
+         *          in the order they were drawn, which is not uniformly random: shuffle
+         *          them if the order matters.
+         *
+         *  @tparam Prng         The pseudo-random number generator type to use.
+         *  @param n             The number of integers to choose from.
+         *  @param how_many      The number of integers to draw.
+         *  @param prng          The pseudo-random number generator.
+         *  @return              The integers drawn.
+         */
+        template<class Prng>
+        inline std::vector<std::size_t> sample_indices(std::size_t n, std::size_t how_many, Prng&& prng) {
+            how_many = std::min(how_many, n);
+
+            std::vector<std::size_t> indices;
+            std::unordered_set<std::size_t> drawn;
+
+            indices.reserve(how_many);
+            drawn.reserve(how_many);
+
+            // For each j in n - how_many, ..., n - 1, draw t in 0, ..., j, and take
+            // t if it was not taken yet, or j otherwise (which cannot have been taken).
+            for(auto j = n - how_many; j < n; ++j) {
+                const auto t = std::uniform_int_distribution<std::size_t>(0u, j)(prng);
+                const auto index = drawn.insert(t).second ? t : j;
+
+                if(index == j) { drawn.insert(j); }
+                indices.push_back(index);
+            }
+
+            return indices;
+        }
+
+        /** @brief  Draws distinct integers from 0 to n - 1, uniformly among all subsets of
+         *          that size, using a thread-local generator (see the overload with a generator).
+         *
+         *  @param n             The number of integers to choose from.
+         *  @param how_many      The number of integers to draw.
+         *  @return              The integers drawn.
+         */
+        inline std::vector<std::size_t> sample_indices(std::size_t n, std::size_t how_many) {
+            return sample_indices(n, how_many, detail::thread_prng());
+        }
+
+        /** @brief  Draws a uniform sample of the elements in a range, possibly not random-access,
+         *          in a single pass, keeping only the sample in memory (reservoir sampling).
+         *          If we are requesting more samples than elements in the range, all of them
+         *          are returned.
+         *
+         *  @tparam InputIterator   The type of the iterators to the range.
+         *  @tparam Prng            The pseudo-random number generator type to use.
+         *  @param first            The beginning of the range.
+         *  @param last             The end of the range.
+         *  @param how_many         The number of samples to extract.
+         *  @param prng             The pseudo-random number generator.
+         *  @return                 The samples.
+         */
+        template<class InputIterator, class Prng>
+        inline std::vector<typename std::iterator_traits<InputIterator>::value_type> reservoir_sample(
+            InputIterator first, InputIterator last, std::size_t how_many, Prng&& prng
+        ) {
+            std::vector<typename std::iterator_traits<InputIterator>::value_type> reservoir;
+            reservoir.reserve(how_many);
+
+            std::size_t seen = 0u;
+
+            for(; first != last; ++first, ++seen) {
+                if(seen < how_many) {
+                    reservoir.push_back(*first);
+                } else {
+                    // Element number seen replaces a random element of the reservoir with
+                    // probability how_many / (seen + 1).
+                    const auto j = std::uniform_int_distribution<std::size_t>(0u, seen)(prng);
+
+                    if(j < how_many) {
+                        reservoir[j] = *first;
+                    }
+                }
+            }
+
+            return reservoir;
+        }
+
         /** @brief  Gets samples from a container. The samples are guaranteed
          *          to be unique. If we are requesting more samples than elements
          *          in the container, the request is ignored, and instead a
          *          random permutation of the container is returned.
          *
          *          A copy of the input container is made, so this method might
-         *          be unsuitable for particularly large containers.
+         *          be unsuitable for particularly large containers: see
+         *          \ref sample_in_place and \ref sample_indices for alternatives.
          *
          *  @tparam Container    The container type.
          *                       Must be copiable, usable with std::begin() and std::end(),
@@ -50,37 +386,20 @@ namespace as {
          *  @return              A container with \ref how_many elements from \ref container.
          */
         template<class Container, class Prng = std::mt19937>
-        inline Container sample(const Container container, typename Container::size_type how_many, Prng&& prng) {
+        inline Container sample(const Container& container, typename Container::size_type how_many, Prng&& prng) {
             static_assert(std::is_copy_constructible<Container>::value, "Container needs to be copy constructible");
 
             Container container_copy(container);
-            auto length = std::distance(std::begin(container_copy), std::end(container_copy));
+            const auto n_samples = sample_in_place(container_copy, how_many, prng);
 
-            assert(length >= 0);
-
-            if(length == 0u) {
+            if(n_samples == static_cast<typename Container::size_type>(std::distance(std::begin(container_copy), std::end(container_copy)))) {
                 return container_copy;
             }
 
-            if(how_many > static_cast<typename Container::size_type>(length)) {
-                how_many = length;
-            }
-
-            auto begin = std::begin(container_copy);
-            auto n_samples = how_many;
-
-            while(n_samples--) {
-                auto piv = begin;
-                auto dist = std::uniform_int_distribution<typename Container::size_type>(0u, length - 1u);
-
-                std::advance(piv, dist(prng));
-                std::swap(*begin, *piv);
-
-                ++begin;
-                --length;
-            }
+            auto end = std::begin(container_copy);
+            std::advance(end, n_samples);
 
-            return Container(std::begin(container_copy), std::begin(container_copy) + how_many);
+            return Container(std::begin(container_copy), end);
         }
 
         /** @brief  Gets samples from a container. The samples are guaranteed
@@ -90,8 +409,8 @@ namespace as {
          *
          *          A copy of the input container is made, so this method might
          *          be unsuitable for particularly large containers.
-         *          A Mersenne Twister pseudo-random number generator is built,
-         *          seeded and used to extract the samples.
+         *          A thread-local generator, seeded the first time each thread
+         *          uses it, is used to extract the samples.
          *
          *  @tparam Container    The container type.
          *                       Must be copiable, usable with std::begin() and std::end(),
@@ -101,8 +420,8 @@ namespace as {
          *  @return              A container with \ref how_many elements from \ref container.
          */
         template<class Container>
-        inline Container sample(const Container container, typename Container::size_type how_many) {
-            return sample(container, how_many, get_seeded_mt());
+        inline Container sample(const Container& container, typename Container::size_type how_many) {
+            return sample(container, how_many, detail::thread_prng());
         }
 
         /** @brief  Selects a position in a vector of floating-point numbers according
@@ -130,7 +449,7 @@ namespace as {
             // There needs to be at least one element in the vector.
             assert(!weights.empty());
 
-            const FloatingPoint sum = std::accumulate(weights.begin(), weights.end(), 0.0f);
+            const FloatingPoint sum = std::accumulate(weights.begin(), weights.end(), FloatingPoint{0});
             std::uniform_real_distribution<FloatingPoint> dist(0, sum);
             const FloatingPoint pivot = dist(prng);
 
@@ -152,8 +471,8 @@ namespace as {
          *
          *          In a roulette-wheel random choice, each position has a probability
          *          to be chosen proportional to the weight at that position.
-         *          A Mersenne Twister pseudo-random number generator is built,
-         *          seeded and used for the selection.
+         *          A thread-local generator, seeded the first time each thread
+         *          uses it, is used for the selection.
          *
          *  @tparam FloatingPoint   A floating-point type (e.g. float, double).
          *  @param  weights         The non-empty vector with weights.
@@ -163,8 +482,278 @@ namespace as {
         inline typename std::vector<FloatingPoint>::size_type roulette_wheel(
                 const std::vector<FloatingPoint>& weights
         ) {
-            return roulette_wheel(weights, get_seeded_mt());
+            return roulette_wheel(weights, detail::thread_prng());
+        }
+
+        /** @brief  Selects many positions in a vector of floating-point numbers according
+         *          to a roulette-wheel criterion.
+         *
+         *          The positions are drawn independently (i.e., with replacement). The
+         *          prefix sums of the weights are computed only once, so that each
+         *          draw takes logarithmic time in the number of weights.
+         *
+         *  @tparam FloatingPoint   A floating-point type (e.g. float, double).
+         *  @tparam Prng            The type of the pseudo-random number generator.
+         *  @param  weights         The non-empty vector with weights.
+         *  @param  how_many        The number of positions to draw.
+         *  @param  prng            The pseudo-random number generator.
+         *  @return                 A vector of \ref how_many indices of the vector of \ref weights.
+         */
+        template<class FloatingPoint, class Prng = std::mt19937>
+        inline std::vector<typename std::vector<FloatingPoint>::size_type> roulette_wheel_batch(
+                const std::vector<FloatingPoint>& weights,
+                typename std::vector<FloatingPoint>::size_type how_many,
+                Prng&& prng
+        ) {
+            static_assert(std::is_floating_point<FloatingPoint>::value, "FloatingPoint needs to be a floating point type");
+
+            using size_type = typename std::vector<FloatingPoint>::size_type;
+
+            // Roulette wheel selection only works if all weights are non-negative.
+            assert(std::all_of(weights.begin(), weights.end(), [](auto w){return w >= 0;}));
+
+            // There needs to be at least one element in the vector.
+            assert(!weights.empty());
+
+            std::vector<FloatingPoint> prefix_sums(weights.size());
+            std::partial_sum(weights.begin(), weights.end(), prefix_sums.begin());
+
+            // Last position with a non-zero weight, used in case rounding errors make
+            // us fall off the end of the vector.
+            size_type last_positive = weights.size() - 1u;
+            while(last_positive > 0u && weights[last_positive] <= 0) { --last_positive; }
+
+            std::uniform_real_distribution<FloatingPoint> dist(0, prefix_sums.back());
+            std::vector<size_type> positions(how_many);
+
+            for(auto& position : positions) {
+                // The first position whose prefix sum exceeds the pivot. Positions
+                // with zero weight have the same prefix sum as their predecessor,
+                // and therefore are never selected.
+                const auto it = std::upper_bound(prefix_sums.begin(), prefix_sums.end(), dist(prng));
+                position = std::min(static_cast<size_type>(std::distance(prefix_sums.begin(), it)), last_positive);
+            }
+
+            return positions;
+        }
+
+        /** @brief  Selects many positions in a vector of floating-point numbers according
+         *          to a roulette-wheel criterion.
+         *
+         *          The positions are drawn independently (i.e., with replacement).
+         *          A thread-local generator, seeded the first time each thread
+         *          uses it, is used for the selection.
+         *
+         *  @tparam FloatingPoint   A floating-point type (e.g. float, double).
+         *  @param  weights         The non-empty vector with weights.
+         *  @param  how_many        The number of positions to draw.
+         *  @return                 A vector of \ref how_many indices of the vector of \ref weights.
+         */
+        template<class FloatingPoint>
+        inline std::vector<typename std::vector<FloatingPoint>::size_type> roulette_wheel_batch(
+                const std::vector<FloatingPoint>& weights,
+                typename std::vector<FloatingPoint>::size_type how_many
+        ) {
+            return roulette_wheel_batch(weights, how_many, detail::thread_prng());
         }
+
+        /** @class  WeightedSampler
+         *  @brief  A collection of non-negative weights, from which positions can be
+         *          repeatedly drawn according to a roulette-wheel criterion, while the
+         *          weights change.
+         *
+         *          Unlike \ref roulette_wheel, which takes linear time in the number of
+         *          weights for each draw, the weights are stored in a Fenwick tree, so that
+         *          both updating a weight and drawing a position take logarithmic time.
+         *          Because weights are updated by adding the difference between the new
+         *          and the old value, floating-point errors accumulate in the tree; to keep
+         *          them bounded, the tree is rebuilt from scratch after a number of updates
+         *          equal to the number of weights, which keeps updates amortised-logarithmic.
+         *
+         *  @tparam FloatingPoint   A floating-point type (e.g. float, double).
+         */
+        template<class FloatingPoint>
+        class WeightedSampler {
+            static_assert(std::is_floating_point<FloatingPoint>::value, "FloatingPoint needs to be a floating point type");
+
+        public:
+            /** @brief The type used for positions.
+             */
+            using size_type = typename std::vector<FloatingPoint>::size_type;
+
+        private:
+            /** @brief The weights.
+             */
+            std::vector<FloatingPoint> weights;
+
+            /** @brief The Fenwick tree, 1-indexed: tree[0] is unused.
+             */
+            std::vector<FloatingPoint> tree;
+
+            /** @brief Largest power of two not larger than the number of weights.
+             */
+            size_type highest_power;
+
+            /** @brief Number of updates since the tree was last rebuilt.
+             */
+            size_type updates_since_rebuild;
+
+        public:
+            /** @brief Builds an empty sampler.
+             */
+            WeightedSampler() : tree(1u, FloatingPoint{0}), highest_power{0u}, updates_since_rebuild{0u} {}
+
+            /** @brief              Builds a sampler with the given weights.
+             *
+             *  @param  weights     The weights. They must all be non-negative.
+             */
+            explicit WeightedSampler(std::vector<FloatingPoint> weights) : weights{std::move(weights)} {
+                rebuild();
+            }
+
+            /** @brief  Gets the number of weights.
+             *
+             *  @return The number of weights.
+             */
+            size_type size() const {
+                return weights.size();
+            }
+
+            /** @brief  Tells whether there are no weights.
+             *
+             *  @return True iff there are no weights.
+             */
+            bool empty() const {
+                return weights.empty();
+            }
+
+            /** @brief  Gets all weights.
+             *
+             *  @return A const reference to the vector of weights.
+             */
+            const std::vector<FloatingPoint>& get_weights() const {
+                return weights;
+            }
+
+            /** @brief              Gets the weight at a position.
+             *
+             *  @param  position    The position.
+             *  @return             The weight.
+             */
+            FloatingPoint get_weight(size_type position) const {
+                assert(position < weights.size());
+                return weights[position];
+            }
+
+            /** @brief  Gets the sum of all weights.
+             *
+             *  @return The sum of the weights.
+             */
+            FloatingPoint total() const {
+                FloatingPoint sum{0};
+
+                for(auto i = weights.size(); i > 0u; i -= (i & (~i + 1u))) {
+                    sum += tree[i];
+                }
+
+                return sum;
+            }
+
+            /** @brief          Appends a new weight. Takes linear time.
+             *
+             *  @param weight   The new weight. Must be non-negative.
+             */
+            void push_back(FloatingPoint weight) {
+                weights.push_back(weight);
+                rebuild();
+            }
+
+            /** @brief              Changes the weight at a position.
+             *
+             *  @param  position    The position.
+             *  @param  weight      The new weight. Must be non-negative.
+             */
+            void set_weight(size_type position, FloatingPoint weight) {
+                assert(position < weights.size());
+                assert(weight >= 0);
+
+                const FloatingPoint delta = weight - weights[position];
+                weights[position] = weight;
+
+                if(++updates_since_rebuild >= weights.size()) {
+                    rebuild();
+                    return;
+                }
+
+                for(auto i = position + 1u; i <= weights.size(); i += (i & (~i + 1u))) {
+                    tree[i] += delta;
+                }
+            }
+
+            /** @brief  Draws a position, with probability proportional to its weight.
+             *
+             *          The sampler must not be empty, and at least one weight must be positive.
+             *
+             *  @tparam Prng    The type of the pseudo-random number generator.
+             *  @param  prng    The pseudo-random number generator.
+             *  @return         The position drawn.
+             */
+            template<class Prng>
+            size_type sample(Prng&& prng) const {
+                assert(!weights.empty());
+
+                const FloatingPoint sum = total();
+                assert(sum > 0);
+
+                std::uniform_real_distribution<FloatingPoint> dist(0, sum);
+                FloatingPoint pivot = dist(prng);
+
+                // Find the largest number of leading weights whose sum does not
+                // exceed the pivot: the next position is the one drawn. Positions
+                // with zero weight never make the sum exceed the pivot, and
+                // therefore are never drawn.
+                size_type position = 0u;
+
+                for(auto step = highest_power; step > 0u; step >>= 1u) {
+                    if(position + step <= weights.size() && tree[position + step] <= pivot) {
+                        position += step;
+                        pivot -= tree[position];
+                    }
+                }
+
+                // Because of rounding errors we might fall off the end: we then
+                // return the last position with non-zero weight.
+                if(position >= weights.size()) {
+                    position = weights.size() - 1u;
+                    while(position > 0u && weights[position] <= 0) { --position; }
+                }
+
+                return position;
+            }
+
+        private:
+
+            void rebuild() {
+                assert(std::all_of(weights.begin(), weights.end(), [](auto w){return w >= 0;}));
+
+                tree.assign(weights.size() + 1u, FloatingPoint{0});
+
+                for(auto i = 1u; i <= weights.size(); ++i) {
+                    tree[i] += weights[i - 1u];
+
+                    const auto parent = i + (i & (~i + 1u));
+                    if(parent <= weights.size()) {
+                        tree[parent] += tree[i];
+                    }
+                }
+
+                highest_power = 1u;
+                while(highest_power * 2u <= weights.size()) { highest_power *= 2u; }
+                if(weights.empty()) { highest_power = 0u; }
+
+                updates_since_rebuild = 0u;
+            }
+        };
     }
 }
 
@@ -0,0 +1,202 @@
+//
+// Created by alberto on 14/10/26.
+//
+
+#ifndef AS_THREAD_POOL_H
+#define AS_THREAD_POOL_H
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <exception>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+namespace as {
+    /** @namespace concurrency
+     *  @brief     This namespace contains utilities to run code concurrently.
+     */
+    namespace concurrency {
+        /** @class  ThreadPool
+         *  @brief  A fixed pool of persistent threads, which run batches of
+         *          independent tasks.
+         *
+         *          Tasks are identified by an index and are handed out to the
+         *          threads one at a time, so that threads which finish early pick
+         *          up the remaining tasks. The thread calling \ref run takes part
+         *          in the work, so that a pool of size 1 has no additional threads
+         *          and simply runs the tasks sequentially.
+         */
+        class ThreadPool {
+            /** @brief The additional threads (the calling thread is not included).
+             */
+            std::vector<std::thread> workers;
+
+            /** @brief Protects the batch description below.
+             */
+            std::mutex mutex;
+
+            /** @brief Signalled when a new batch is available, or when the pool stops.
+             */
+            std::condition_variable batch_available;
+
+            /** @brief Signalled when a worker is done with the current batch.
+             */
+            std::condition_variable batch_done;
+
+            /** @brief The task of the current batch.
+             */
+            const std::function<void(std::size_t)>* task;
+
+            /** @brief Number of tasks in the current batch.
+             */
+            std::size_t n_tasks;
+
+            /** @brief Index of the next task to hand out.
+             */
+            std::atomic<std::size_t> next_task;
+
+            /** @brief Number of workers which are done with the current batch.
+             */
+            std::size_t n_workers_done;
+
+            /** @brief Identifier of the current batch.
+             */
+            std::uint64_t batch_id;
+
+            /** @brief True when the pool is being destroyed.
+             */
+            bool stopping;
+
+            /** @brief The first exception thrown by a task in the current batch, if any.
+             */
+            std::exception_ptr error;
+
+        public:
+            /** @brief              Builds a pool.
+             *
+             *  @param n_threads    The number of threads that will run tasks, including
+             *                      the calling thread. If 0, it uses the number of
+             *                      concurrent threads supported by the hardware.
+             */
+            explicit ThreadPool(std::size_t n_threads = 0u) :
+                task{nullptr}, n_tasks{0u}, next_task{0u}, n_workers_done{0u}, batch_id{0u}, stopping{false}
+            {
+                if(n_threads == 0u) {
+                    n_threads = std::max(1u, std::thread::hardware_concurrency());
+                }
+
+                for(auto i = 1u; i < n_threads; ++i) {
+                    workers.emplace_back([this] () { work(); });
+                }
+            }
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            /** @brief Stops and joins all threads.
+             */
+            ~ThreadPool() {
+                {
+                    std::lock_guard<std::mutex> lock{mutex};
+                    stopping = true;
+                }
+
+                batch_available.notify_all();
+
+                for(auto& worker : workers) {
+                    worker.join();
+                }
+            }
+
+            /** @brief  Gives the number of threads that run tasks, including the
+             *          calling thread.
+             *
+             *  @return The number of threads.
+             */
+            std::size_t size() const {
+                return workers.size() + 1u;
+            }
+
+            /** @brief          Runs a batch of tasks, and waits until all of them are done.
+             *
+             *  If any task throws, the other tasks are still run, and the first exception
+             *  thrown is rethrown to the caller. This method must not be called concurrently,
+             *  nor from within a task.
+             *
+             *  @param n_tasks  The number of tasks.
+             *  @param task     The function called, once, on each task index from 0 to
+             *                  \p n_tasks - 1.
+             */
+            void run(std::size_t n_tasks, const std::function<void(std::size_t)>& task) {
+                {
+                    std::lock_guard<std::mutex> lock{mutex};
+                    this->task = &task;
+                    this->n_tasks = n_tasks;
+                    next_task = 0u;
+                    n_workers_done = 0u;
+                    error = nullptr;
+                    ++batch_id;
+                }
+
+                batch_available.notify_all();
+                run_tasks();
+
+                std::exception_ptr batch_error;
+
+                {
+                    std::unique_lock<std::mutex> lock{mutex};
+                    batch_done.wait(lock, [this] () { return n_workers_done == workers.size(); });
+                    this->task = nullptr;
+                    batch_error = error;
+                }
+
+                if(batch_error) {
+                    std::rethrow_exception(batch_error);
+                }
+            }
+
+        private:
+
+            void run_tasks() {
+                for(auto id = next_task++; id < n_tasks; id = next_task++) {
+                    try {
+                        (*task)(id);
+                    } catch(...) {
+                        std::lock_guard<std::mutex> lock{mutex};
+                        if(!error) { error = std::current_exception(); }
+                    }
+                }
+            }
+
+            void work() {
+                std::uint64_t last_batch_id = 0u;
+
+                while(true) {
+                    {
+                        std::unique_lock<std::mutex> lock{mutex};
+                        batch_available.wait(lock, [&] () { return stopping || batch_id != last_batch_id; });
+
+                        if(stopping) { return; }
+
+                        last_batch_id = batch_id;
+                    }
+
+                    run_tasks();
+
+                    {
+                        std::lock_guard<std::mutex> lock{mutex};
+                        ++n_workers_done;
+                    }
+
+                    batch_done.notify_one();
+                }
+            }
+        };
+    }
+}
+
+#endif //AS_THREAD_POOL_H
@@ -14,6 +14,9 @@
 #include "tsplib.h"
 #include "discorde.h"
 #include "mtz.h"
+#include "thread_pool.h"
+#include "tsp_cache.h"
+#include "tsp_heuristic.h"
 
 namespace as {
     /** @namespace tsp
@@ -36,74 +39,165 @@ namespace as {
                 assert(v < instance.number_of_vertices());
                 assert(w < instance.number_of_vertices());
 
-                cost += instance.get_distance(v, w);
+                cost += instance.get_distance_unchecked(v, w);
             }
 
             return cost;
         }
 
+        /** @brief  Which solvers \ref solve uses.
+         */
+        enum class SolvePolicy {
+            /**
+             * Optimal tours, by Concorde or by an MTZ model via CPLEX.
+             */
+            EXACT,
+
+            /**
+             * Good tours, found quickly with \ref heuristic_solve_tsp, without
+             * calling external solvers. Small subsets are still solved to optimality.
+             */
+            HEURISTIC,
+
+            /**
+             * Optimal tours for subsets of at most \ref SolveOptions::exact_max_nodes
+             * nodes, which Concorde solves quickly, and heuristic tours for larger ones.
+             */
+            EXACT_IF_SMALL
+        };
+
+        /** @brief  Options of \ref solve.
+         */
+        struct SolveOptions {
+            /** @brief  If not null, tours are looked up in, and added to, this cache.
+             *          The cache is not owned, and can be shared by several threads.
+             *          Only optimal tours are added; a cached tour is returned with
+             *          any policy.
+             */
+            SolveCache* cache = nullptr;
+
+            /** @brief  Which solvers to use.
+             */
+            SolvePolicy policy = SolvePolicy::EXACT;
+
+            /** @brief  With the heuristic policies, size up to which subsets are
+             *          solved to optimality.
+             */
+            std::size_t exact_max_nodes = 12u;
+
+            /** @brief  If not null, the Cplex model used when Concorde fails, instead of
+             *          building a new one for each subset. It must be built on the same
+             *          instance; it is not owned, and can be shared by several threads.
+             *          It is given the heuristic tour as a starting solution.
+             */
+            MtzSolver* mtz = nullptr;
+        };
+
+        namespace detail {
+            /** @brief Rotates a tour so that it starts at a given node, if it visits it.
+             */
+            inline void rotate_to_start(std::vector<std::uint32_t>& tour, std::uint32_t first) {
+                const auto it = std::find(tour.begin(), tour.end(), first);
+
+                if(it != tour.end()) {
+                    std::rotate(tour.begin(), it, tour.end());
+                }
+            }
+
+            /** @brief Solves a TSP Instance to optimality, with no cache.
+             */
+            inline std::vector<std::uint32_t> solve_exact(const tsplib::TSPInstance& instance, const std::vector<std::uint32_t>& nodes, MtzSolver* mtz = nullptr) {
+                // Trivial tour.
+                if(nodes.size() < 4u) {
+                    return nodes;
+                }
+
+                // Discorde is known to fail if there aren't at least 5 nodes.
+                // With 4 nodes there are only 3 different tours (up to rotation
+                // and reflection), and we just try them all.
+                if(nodes.size() == 4u) {
+                    const std::array<std::vector<std::uint32_t>, 3> tours{{
+                        { nodes[0u], nodes[1u], nodes[2u], nodes[3u] },
+                        { nodes[0u], nodes[1u], nodes[3u], nodes[2u] },
+                        { nodes[0u], nodes[2u], nodes[1u], nodes[3u] }
+                    }};
+
+                    std::size_t best = 0u;
+                    float best_cost = tour_cost(instance, tours[0u]);
+
+                    for(auto i = 1u; i < tours.size(); ++i) {
+                        const auto cost = tour_cost(instance, tours[i]);
+
+                        if(cost < best_cost) {
+                            best = i;
+                            best_cost = cost;
+                        }
+                    }
+
+                    return tours[best];
+                }
+
+                try {
+                    return discorde_solve_tsp(instance, nodes);
+                } catch(const std::runtime_error& error) {
+                    // If for any other reason discorde/concorde fails, resort back to the MTZ model.
+                    try {
+                        if(mtz != nullptr) {
+                            return mtz->solve(nodes, heuristic_solve_tsp(instance, nodes));
+                        }
+
+                        return mtz_solve_tsp(instance, nodes);
+                    } catch(const std::runtime_error& error) {
+                        throw std::runtime_error("Could not solve the problem with neither Concorde nor Cplex");
+                    }
+                }
+            }
+        }
+
         /** @brief Solves a TSP Instance.
          *
-         *  It can use either Concorde (via the Discorde API) or an MTZ model via CPLEX.
+         *  It can use either Concorde (via the Discorde API) or an MTZ model via CPLEX,
+         *  or a fast heuristic, depending on \ref SolveOptions::policy.
          *  It can throw, in case neither solver provides a solution.
          *
+         *  The tour starts at nodes[0], whether it was just computed or found in the
+         *  cache, where it can have been stored by a caller listing the nodes in a
+         *  different order.
+         *
          *  @param  instance The TSP instance.
          *  @param  nodes    The subset of nodes of the instance to consider.
+         *  @param  options  Solve options.
          *  @return          The optimal tour.
          */
-        inline std::vector<std::uint32_t> solve(const tsplib::TSPInstance& instance, const std::vector<std::uint32_t>& nodes) {
-            // Trivial tour.
-            if(nodes.size() < 4u) {
-                return nodes;
+        inline std::vector<std::uint32_t> solve(const tsplib::TSPInstance& instance, const std::vector<std::uint32_t>& nodes, const SolveOptions& options = SolveOptions{}) {
+            if(options.cache != nullptr) {
+                if(auto tour = options.cache->find(nodes)) {
+                    if(!nodes.empty()) { detail::rotate_to_start(*tour, nodes[0u]); }
+                    return *tour;
+                }
             }
 
-            // Discorde is known to fail if there aren't at least 5 nodes.
-            // So for 4 nodes we use simple enumeration.
-            if(nodes.size() == 4u) {
-                const std::array<std::vector<std::uint32_t>, 24> tours{{
-                    { nodes[0u], nodes[1u], nodes[2u], nodes[3u] },
-                    { nodes[0u], nodes[1u], nodes[3u], nodes[2u] },
-                    { nodes[0u], nodes[2u], nodes[1u], nodes[3u] },
-                    { nodes[0u], nodes[2u], nodes[3u], nodes[1u] },
-                    { nodes[0u], nodes[3u], nodes[1u], nodes[2u] },
-                    { nodes[0u], nodes[3u], nodes[2u], nodes[1u] },
-                    { nodes[1u], nodes[0u], nodes[2u], nodes[3u] },
-                    { nodes[1u], nodes[0u], nodes[3u], nodes[2u] },
-                    { nodes[1u], nodes[2u], nodes[0u], nodes[3u] },
-                    { nodes[1u], nodes[2u], nodes[3u], nodes[0u] },
-                    { nodes[1u], nodes[3u], nodes[0u], nodes[2u] },
-                    { nodes[1u], nodes[3u], nodes[2u], nodes[0u] },
-                    { nodes[2u], nodes[0u], nodes[1u], nodes[3u] },
-                    { nodes[2u], nodes[0u], nodes[3u], nodes[1u] },
-                    { nodes[2u], nodes[1u], nodes[0u], nodes[3u] },
-                    { nodes[2u], nodes[1u], nodes[3u], nodes[0u] },
-                    { nodes[2u], nodes[3u], nodes[0u], nodes[1u] },
-                    { nodes[2u], nodes[3u], nodes[1u], nodes[0u] },
-                    { nodes[3u], nodes[0u], nodes[1u], nodes[2u] },
-                    { nodes[3u], nodes[0u], nodes[2u], nodes[1u] },
-                    { nodes[3u], nodes[1u], nodes[0u], nodes[2u] },
-                    { nodes[3u], nodes[1u], nodes[2u], nodes[0u] },
-                    { nodes[3u], nodes[2u], nodes[0u], nodes[1u] },
-                    { nodes[3u], nodes[2u], nodes[1u], nodes[0u] }
-                }};
-
-                return *std::min_element(tours.begin(), tours.end(),
-                    [&instance] (const auto& tour1, const auto& tour2) -> bool {
-                        return tour_cost(instance, tour1) < tour_cost(instance, tour2);
-                    }
-                );
-            };
+            const bool small = (nodes.size() <= options.exact_max_nodes);
+            std::vector<std::uint32_t> tour;
+            bool optimal = true;
 
-            try {
-                return discorde_solve_tsp(instance, nodes);
-            } catch(const std::runtime_error& error) {
-                // If for any other reason discorde/concorde fails, resort back to the MTZ model.
-                try {
-                    return mtz_solve_tsp(instance, nodes);
-                } catch(const std::runtime_error& error) {
-                    throw std::runtime_error("Could not solve the problem with neither Concorde nor Cplex");
-                }
+            if(options.policy == SolvePolicy::EXACT || (options.policy == SolvePolicy::EXACT_IF_SMALL && small)) {
+                tour = detail::solve_exact(instance, nodes, options.mtz);
+            } else if(small && nodes.size() <= held_karp_max_nodes) {
+                tour = held_karp_solve_tsp(instance, nodes);
+            } else {
+                tour = local_search_solve_tsp(instance, nodes);
+                optimal = false;
             }
+
+            if(!nodes.empty()) { detail::rotate_to_start(tour, nodes[0u]); }
+
+            // Heuristic tours are not cached, so that the cache only returns optimal tours.
+            if(options.cache != nullptr && optimal) {
+                options.cache->insert(nodes, tour);
+            }
+
+            return tour;
         }
 
         /** @brief Solves a TSP Instance.
@@ -114,9 +208,10 @@ namespace as {
         *  @param  instance The TSP instance.
         *  @param  nodes    A boolean mask of the same size as the instance, indicating
          *                  the subset of nodes to consider.
+        *  @param  options  Solve options.
         *  @return          The optimal tour.
         */
-        inline std::vector<std::uint32_t> solve(const tsplib::TSPInstance& instance, const std::vector<bool>& nodes) {
+        inline std::vector<std::uint32_t> solve(const tsplib::TSPInstance& instance, const std::vector<bool>& nodes, const SolveOptions& options = SolveOptions{}) {
             assert(nodes.size() == instance.number_of_vertices());
 
             std::vector<std::uint32_t> explicit_nodes;
@@ -127,7 +222,7 @@ namespace as {
                 }
             }
 
-            return solve(instance, explicit_nodes);
+            return solve(instance, explicit_nodes, options);
         }
 
         /** @brief Solves a TSP Instance where node 0 is assumed to be the depot and is always present.
@@ -140,9 +235,10 @@ namespace as {
          *                   the subset of customers to consider. The depot (indexed by 0) is always
          *                   present and is not part of the mask vector. Therefore element node[i]
          *                   tells wether or not node i-1 should be included.
+         *  @param  options  Solve options.
          *  @return          The optimal tour.
          */
-        inline std::vector<std::uint32_t> solve_with_depot(const tsplib::TSPInstance& instance, const std::vector<bool>& nodes) {
+        inline std::vector<std::uint32_t> solve_with_depot(const tsplib::TSPInstance& instance, const std::vector<bool>& nodes, const SolveOptions& options = SolveOptions{}) {
             assert(nodes.size() == instance.number_of_vertices() - 1u);
 
             std::vector<std::uint32_t> explicit_nodes = { 0u };
@@ -153,7 +249,33 @@ namespace as {
                 }
             }
 
-            return solve(instance, explicit_nodes);
+            return solve(instance, explicit_nodes, options);
+        }
+
+        /** @brief Solves the TSP on several subsets of nodes of an instance, concurrently.
+         *
+         *  Each subset is solved as by \ref solve, by one of the threads of the pool.
+         *  It can throw, in case neither solver provides a solution for some subset.
+         *
+         *  @param  instance The TSP instance.
+         *  @param  subsets  The subsets of nodes of the instance to consider.
+         *  @param  pool     The threads to use.
+         *  @param  options  Solve options, shared by all threads.
+         *  @return          The optimal tour of each subset.
+         */
+        inline std::vector<std::vector<std::uint32_t>> solve_all(
+            const tsplib::TSPInstance& instance,
+            const std::vector<std::vector<std::uint32_t>>& subsets,
+            concurrency::ThreadPool& pool,
+            const SolveOptions& options = SolveOptions{}
+        ) {
+            std::vector<std::vector<std::uint32_t>> tours(subsets.size());
+
+            pool.run(subsets.size(), [&] (std::size_t i) {
+                tours[i] = solve(instance, subsets[i], options);
+            });
+
+            return tours;
         }
 
         /** @brief Solves a TSP Instance.
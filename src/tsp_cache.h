@@ -0,0 +1,187 @@
+//
+// Created by alberto on 14/10/26.
+//
+
+#ifndef AS_TSP_CACHE_H
+#define AS_TSP_CACHE_H
+
+#include <list>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <algorithm>
+#include <unordered_map>
+
+namespace as {
+    namespace tsp {
+        /** @brief  Hit and miss counters of a \ref SolveCache.
+         */
+        struct SolveCacheStatistics {
+            /** @brief Number of lookups which found a tour.
+             */
+            std::size_t hits = 0u;
+
+            /** @brief Number of lookups which did not find a tour.
+             */
+            std::size_t misses = 0u;
+
+            /** @brief Number of tours removed to make room for newer ones.
+             */
+            std::size_t evictions = 0u;
+        };
+
+        /** @class  SolveCache
+         *  @brief  A bounded cache of solved tours, keyed by the set of nodes visited.
+         *
+         *          When the cache is full, inserting a new tour evicts the least
+         *          recently used one. The order in which the nodes are given does not
+         *          matter: the key is the sorted node set. All methods can be called
+         *          concurrently.
+         */
+        class SolveCache {
+            /** @brief  A sorted set of nodes.
+             */
+            using Key = std::vector<std::uint32_t>;
+
+            /** @brief  Hashes a sorted set of nodes.
+             */
+            struct KeyHash {
+                std::size_t operator()(const Key& key) const {
+                    std::uint64_t hash = 0xcbf29ce484222325u;
+
+                    for(const auto node : key) {
+                        hash = (hash ^ node) * 0x100000001b3u;
+                    }
+
+                    return static_cast<std::size_t>(hash ^ (hash >> 32u));
+                }
+            };
+
+            /** @brief  A cached tour, with its key.
+             */
+            using Entry = std::pair<Key, std::vector<std::uint32_t>>;
+
+            /** @brief Maximum number of tours.
+             */
+            std::size_t max_size;
+
+            /** @brief The tours, from the most to the least recently used.
+             */
+            std::list<Entry> entries;
+
+            /** @brief Where each key is in \ref entries.
+             */
+            std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+
+            /** @brief Hit and miss counters.
+             */
+            SolveCacheStatistics statistics;
+
+            /** @brief Protects all the above.
+             */
+            mutable std::mutex mutex;
+
+        public:
+            /** @brief              Builds an empty cache.
+             *
+             *  @param max_size     The maximum number of tours to keep.
+             */
+            explicit SolveCache(std::size_t max_size = 4096u) : max_size{max_size} {}
+
+            SolveCache(const SolveCache&) = delete;
+            SolveCache& operator=(const SolveCache&) = delete;
+
+            /** @brief          Looks for the tour of a set of nodes.
+             *
+             *  @param nodes    The nodes, in any order.
+             *  @return         The tour, if it is in the cache.
+             */
+            std::optional<std::vector<std::uint32_t>> find(const std::vector<std::uint32_t>& nodes) {
+                const auto key = make_key(nodes);
+                std::lock_guard<std::mutex> lock{mutex};
+
+                const auto it = index.find(key);
+
+                if(it == index.end()) {
+                    ++statistics.misses;
+                    return std::nullopt;
+                }
+
+                ++statistics.hits;
+                entries.splice(entries.begin(), entries, it->second);
+                return it->second->second;
+            }
+
+            /** @brief          Stores the tour of a set of nodes, replacing any tour
+             *                  already stored for the same set.
+             *
+             *  @param nodes    The nodes, in any order.
+             *  @param tour     The tour visiting them.
+             */
+            void insert(const std::vector<std::uint32_t>& nodes, std::vector<std::uint32_t> tour) {
+                if(max_size == 0u) { return; }
+
+                auto key = make_key(nodes);
+                std::lock_guard<std::mutex> lock{mutex};
+
+                const auto it = index.find(key);
+
+                if(it != index.end()) {
+                    it->second->second = std::move(tour);
+                    entries.splice(entries.begin(), entries, it->second);
+                    return;
+                }
+
+                if(entries.size() == max_size) {
+                    index.erase(entries.back().first);
+                    entries.pop_back();
+                    ++statistics.evictions;
+                }
+
+                entries.emplace_front(std::move(key), std::move(tour));
+                index.emplace(entries.front().first, entries.begin());
+            }
+
+            /** @brief  Gives the hit and miss counters.
+             */
+            SolveCacheStatistics get_statistics() const {
+                std::lock_guard<std::mutex> lock{mutex};
+                return statistics;
+            }
+
+            /** @brief  Gives the number of tours in the cache.
+             */
+            std::size_t size() const {
+                std::lock_guard<std::mutex> lock{mutex};
+                return entries.size();
+            }
+
+            /** @brief  Gives the maximum number of tours in the cache.
+             */
+            std::size_t capacity() const {
+                return max_size;
+            }
+
+            /** @brief  Removes all tours, and resets the counters.
+             */
+            void clear() {
+                std::lock_guard<std::mutex> lock{mutex};
+                entries.clear();
+                index.clear();
+                statistics = SolveCacheStatistics{};
+            }
+
+        private:
+
+            static Key make_key(const std::vector<std::uint32_t>& nodes) {
+                Key key = nodes;
+                std::sort(key.begin(), key.end());
+                return key;
+            }
+        };
+    }
+}
+
+#endif //AS_TSP_CACHE_H
@@ -0,0 +1,355 @@
+//
+// Created by alberto on 14/10/26.
+//
+
+#ifndef AS_TSP_HEURISTIC_H
+#define AS_TSP_HEURISTIC_H
+
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+#include "tsplib.h"
+
+namespace as {
+    namespace tsp {
+        namespace detail {
+            /** @brief  Tolerance below which a change in cost is not considered
+             *          an improvement, to avoid cycling on rounding errors.
+             */
+            static constexpr float improvement_tolerance = 1e-4f;
+
+            /** @brief  A subset of nodes of an instance, renumbered from 0, which
+             *          the heuristics work on.
+             */
+            struct Subproblem {
+                const tsplib::TSPInstance& instance;
+                const std::vector<std::uint32_t>& nodes;
+
+                std::size_t size() const { return nodes.size(); }
+
+                float distance(std::size_t i, std::size_t j) const {
+                    return instance.get_distance_unchecked(nodes[i], nodes[j]);
+                }
+
+                std::vector<std::uint32_t> to_nodes(const std::vector<std::size_t>& local_tour) const {
+                    std::vector<std::uint32_t> tour(local_tour.size());
+
+                    for(auto i = 0u; i < local_tour.size(); ++i) {
+                        tour[i] = nodes[local_tour[i]];
+                    }
+
+                    return tour;
+                }
+            };
+
+            inline void check_nodes(const tsplib::TSPInstance& instance, const std::vector<std::uint32_t>& nodes) {
+                for(const auto node : nodes) {
+                    if(node >= instance.number_of_vertices()) {
+                        throw std::out_of_range("No such vertex: " + std::to_string(node));
+                    }
+                }
+            }
+        }
+
+        /** @brief  Maximum number of nodes \ref held_karp_solve_tsp accepts.
+         */
+        static constexpr std::size_t held_karp_max_nodes = 16u;
+
+        /** @brief Solves a TSP Instance to optimality with the Held-Karp dynamic program.
+         *
+         *  It takes O(2^n n^2) time and O(2^n n) memory, which makes it the fastest exact
+         *  method for up to a dozen nodes or so.
+         *
+         *  @param  instance The TSP instance.
+         *  @param  nodes    The subset of nodes of the instance to consider. There can be at
+         *                   most \ref held_karp_max_nodes.
+         *  @return          The optimal tour.
+         */
+        inline std::vector<std::uint32_t> held_karp_solve_tsp(const tsplib::TSPInstance& instance, const std::vector<std::uint32_t>& nodes) {
+            detail::check_nodes(instance, nodes);
+
+            if(nodes.size() > held_karp_max_nodes) {
+                throw std::invalid_argument("Too many nodes for the Held-Karp algorithm: " + std::to_string(nodes.size()));
+            }
+
+            if(nodes.size() < 4u) {
+                return nodes;
+            }
+
+            const detail::Subproblem sub{instance, nodes};
+
+            // Paths start at local node 0; bit j of a mask is for local node j + 1.
+            const auto m = nodes.size() - 1u;
+            const std::size_t n_masks = std::size_t{1u} << m;
+            const auto infinity = std::numeric_limits<float>::infinity();
+
+            // cost[mask * m + j] is the cost of the cheapest path from node 0 visiting
+            // exactly the nodes in mask, and ending at node j + 1 (which is in mask).
+            std::vector<float> cost(n_masks * m, infinity);
+            std::vector<std::uint8_t> parent(n_masks * m, 0u);
+
+            for(auto j = 0u; j < m; ++j) {
+                cost[(std::size_t{1u} << j) * m + j] = sub.distance(0u, j + 1u);
+            }
+
+            for(std::size_t mask = 1u; mask < n_masks; ++mask) {
+                for(auto j = 0u; j < m; ++j) {
+                    const auto current = cost[mask * m + j];
+
+                    if(!(mask & (std::size_t{1u} << j)) || current == infinity) { continue; }
+
+                    for(auto k = 0u; k < m; ++k) {
+                        if(mask & (std::size_t{1u} << k)) { continue; }
+
+                        const auto next_mask = mask | (std::size_t{1u} << k);
+                        const auto next = current + sub.distance(j + 1u, k + 1u);
+
+                        if(next < cost[next_mask * m + k]) {
+                            cost[next_mask * m + k] = next;
+                            parent[next_mask * m + k] = static_cast<std::uint8_t>(j);
+                        }
+                    }
+                }
+            }
+
+            const auto full = n_masks - 1u;
+            std::size_t last = 0u;
+
+            for(auto j = 1u; j < m; ++j) {
+                if(cost[full * m + j] + sub.distance(j + 1u, 0u) < cost[full * m + last] + sub.distance(last + 1u, 0u)) {
+                    last = j;
+                }
+            }
+
+            std::vector<std::size_t> local_tour(nodes.size());
+            auto mask = full;
+
+            for(auto position = nodes.size() - 1u; position > 0u; --position) {
+                local_tour[position] = last + 1u;
+
+                const auto previous = parent[mask * m + last];
+                mask &= ~(std::size_t{1u} << last);
+                last = previous;
+            }
+
+            local_tour[0u] = 0u;
+            return sub.to_nodes(local_tour);
+        }
+
+        /** @brief Finds a good tour with a local search.
+         *
+         *  It builds a tour with the nearest neighbour heuristic, and then improves it
+         *  with 2-opt and Or-opt moves until no move improves it. Moves are only tried
+         *  between each node and its nearest neighbours within the subset, so that each
+         *  pass over the tour takes O(n k) time; computing the neighbour lists takes
+         *  O(n^2 log k) time.
+         *
+         *  @param  instance        The TSP instance.
+         *  @param  nodes           The subset of nodes of the instance to consider.
+         *  @param  n_neighbours    Number of neighbours of each node considered by the moves.
+         *  @return                 A locally optimal tour.
+         */
+        inline std::vector<std::uint32_t> local_search_solve_tsp(const tsplib::TSPInstance& instance, const std::vector<std::uint32_t>& nodes, std::size_t n_neighbours = 8u) {
+            detail::check_nodes(instance, nodes);
+
+            if(nodes.size() < 4u) {
+                return nodes;
+            }
+
+            const detail::Subproblem sub{instance, nodes};
+            const auto n = sub.size();
+            const auto k = std::min(n_neighbours, n - 1u);
+
+            // Neighbour lists, sorted by increasing distance.
+            std::vector<std::size_t> neighbours(n * k);
+            std::vector<std::size_t> others(n - 1u);
+
+            for(std::size_t i = 0u; i < n; ++i) {
+                std::iota(others.begin(), others.begin() + i, 0u);
+                std::iota(others.begin() + i, others.end(), i + 1u);
+                std::partial_sort(others.begin(), others.begin() + k, others.end(), [&] (std::size_t a, std::size_t b) {
+                    return sub.distance(i, a) < sub.distance(i, b);
+                });
+                std::copy_n(others.begin(), k, neighbours.begin() + i * k);
+            }
+
+            // Nearest neighbour construction.
+            std::vector<std::size_t> tour{0u};
+            std::vector<bool> visited(n, false);
+            visited[0u] = true;
+
+            while(tour.size() < n) {
+                const auto current = tour.back();
+                std::size_t best = n;
+
+                for(std::size_t i = 0u; i < n; ++i) {
+                    if(!visited[i] && (best == n || sub.distance(current, i) < sub.distance(current, best))) {
+                        best = i;
+                    }
+                }
+
+                visited[best] = true;
+                tour.push_back(best);
+            }
+
+            std::vector<std::size_t> position(n);
+
+            auto update_positions = [&] () {
+                for(std::size_t p = 0u; p < n; ++p) { position[tour[p]] = p; }
+            };
+
+            auto succ = [&] (std::size_t v) { return tour[(position[v] + 1u) % n]; };
+            auto pred = [&] (std::size_t v) { return tour[(position[v] + n - 1u) % n]; };
+
+            // Reverses the part of the tour from position i to position j, going forward
+            // and possibly wrapping around. Reversing a part of a cycle gives the same cycle
+            // as reversing its complement, so we reverse the shorter one.
+            auto reverse = [&] (std::size_t i, std::size_t j) {
+                auto length = (j + n - i) % n + 1u;
+
+                if(2u * length > n) {
+                    const auto new_i = (j + 1u) % n;
+                    j = (i + n - 1u) % n;
+                    i = new_i;
+                    length = n - length;
+                }
+
+                for(std::size_t s = 0u; s < length / 2u; ++s) {
+                    const auto a = (i + s) % n, b = (j + n - s) % n;
+                    std::swap(tour[a], tour[b]);
+                    position[tour[a]] = a;
+                    position[tour[b]] = b;
+                }
+            };
+
+            update_positions();
+
+            auto two_opt = [&] () -> bool {
+                bool improved = false;
+
+                for(std::size_t a = 0u; a < n; ++a) {
+                    // Replace edges (a, succ a) and (c, succ c) with (a, c) and (succ a, succ c).
+                    const auto b = succ(a);
+
+                    for(auto idx = 0u; idx < k; ++idx) {
+                        const auto c = neighbours[a * k + idx];
+                        const auto gain_ab = sub.distance(a, b) - sub.distance(a, c);
+
+                        if(gain_ab <= 0.0f) { break; }
+                        if(c == b) { continue; }
+
+                        const auto d = succ(c);
+
+                        if(d == a) { continue; }
+
+                        if(gain_ab + sub.distance(c, d) - sub.distance(b, d) > detail::improvement_tolerance) {
+                            reverse(position[b], position[c]);
+                            improved = true;
+                            break;
+                        }
+                    }
+                }
+
+                return improved;
+            };
+
+            auto or_opt = [&] () -> bool {
+                bool improved = false;
+
+                for(std::size_t length = 1u; length <= 3u && length + 2u <= n; ++length) {
+                    for(std::size_t start = 0u; start < n; ++start) {
+                        // The segment is s1 ... s2, between p and q.
+                        const auto s1 = tour[start];
+                        const auto s2 = tour[(start + length - 1u) % n];
+                        const auto p = pred(s1), q = succ(s2);
+                        const auto removal_gain = sub.distance(p, s1) + sub.distance(s2, q) - sub.distance(p, q);
+
+                        if(removal_gain <= detail::improvement_tolerance) { continue; }
+
+                        auto in_segment = [&] (std::size_t v) { return (position[v] + n - start) % n < length; };
+
+                        // Try to insert the segment next to a neighbour c of either of its endpoints,
+                        // between c and succ c, in either orientation.
+                        for(const auto endpoint : {s1, s2}) {
+                            for(auto idx = 0u; idx < k; ++idx) {
+                                const auto c = neighbours[endpoint * k + idx];
+
+                                if(in_segment(c)) { continue; }
+
+                                const auto d = succ(c);
+
+                                if(in_segment(d) || c == p) { continue; }
+
+                                const auto base = sub.distance(c, d);
+                                const auto forward = sub.distance(c, s1) + sub.distance(s2, d) - base;
+                                const auto backward = sub.distance(c, s2) + sub.distance(s1, d) - base;
+
+                                if(removal_gain - std::min(forward, backward) > detail::improvement_tolerance) {
+                                    std::vector<std::size_t> segment(length);
+
+                                    for(std::size_t s = 0u; s < length; ++s) { segment[s] = tour[(start + s) % n]; }
+                                    if(backward < forward) { std::reverse(segment.begin(), segment.end()); }
+
+                                    std::vector<std::size_t> new_tour;
+                                    new_tour.reserve(n);
+
+                                    for(std::size_t s = 0u; s < n; ++s) {
+                                        const auto v = tour[(start + length + s) % n];
+
+                                        if(in_segment(v)) { continue; }
+
+                                        new_tour.push_back(v);
+
+                                        if(v == c) { new_tour.insert(new_tour.end(), segment.begin(), segment.end()); }
+                                    }
+
+                                    tour = std::move(new_tour);
+                                    update_positions();
+                                    improved = true;
+                                    break;
+                                }
+                            }
+
+                            if(improved) { break; }
+                        }
+
+                        if(improved) { break; }
+                    }
+
+                    if(improved) { break; }
+                }
+
+                return improved;
+            };
+
+            while(two_opt() || or_opt()) {}
+
+            return sub.to_nodes(tour);
+        }
+
+        /** @brief Finds a good tour quickly, without calling external solvers.
+         *
+         *  Subsets of at most \p exact_max_nodes nodes are solved to optimality with
+         *  \ref held_karp_solve_tsp; larger ones with \ref local_search_solve_tsp.
+         *
+         *  @param  instance        The TSP instance.
+         *  @param  nodes           The subset of nodes of the instance to consider.
+         *  @param  exact_max_nodes Size up to which the subset is solved to optimality.
+         *  @return                 The tour.
+         */
+        inline std::vector<std::uint32_t> heuristic_solve_tsp(const tsplib::TSPInstance& instance, const std::vector<std::uint32_t>& nodes, std::size_t exact_max_nodes = 12u) {
+            if(nodes.size() <= std::min(exact_max_nodes, held_karp_max_nodes)) {
+                return held_karp_solve_tsp(instance, nodes);
+            }
+
+            return local_search_solve_tsp(instance, nodes);
+        }
+    }
+}
+
+#endif //AS_TSP_HEURISTIC_H
@@ -6,19 +6,41 @@
 #define AS_TSPLIB_H
 
 #include <map>
-#include <regex>
+#include <new>
+#include <algorithm>
 #include <cmath>
 #include <string>
 #include <vector>
+#include <charconv>
+#include <string_view>
+#include <atomic>
+#include <cctype>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <stdexcept>
+#include <type_traits>
 #include <experimental/filesystem>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 #include "geometry.h"
 #include "console.h"
 #include "string.h"
+#include "iterator_pair.h"
 
 namespace as {
     /** @namespace  tsplib
@@ -76,15 +98,17 @@ namespace as {
                 /** @brief      Adds a new, empty data bloack to the data part.
                  *
                  *  @param label The label.
+                 *  @return      The new data block, so that values can be appended
+                 *               to it without looking up the label again.
                  */
-                void add_data_block(std::string label) {
+                std::vector<float>& add_data_block(std::string label) {
                     string::trim(label);
 
                     if(data.find(label) != data.end()) {
                         std::cerr << console::error << "Duplicate data label: " << label << "\n";
                         throw std::logic_error("Duplicate data label");
                     }
-                    data[label] = std::vector<float>();
+                    return data[label];
                 }
 
                 /** @brief          Adds a single value to a data block.
@@ -114,14 +138,34 @@ namespace as {
                         throw std::out_of_range("There is no such data label: " + label);
                     }
 
-                    std::stringstream ss(elements);
-                    float element;
+                    return parse_values(elements, data[label]);
+                }
+
+                /** @brief          Appends a whitespace-separated list of values to a vector.
+                 *
+                 *                  Parsing stops at the first token which is not a number.
+                 *
+                 *  @param elements The values to parse.
+                 *  @param values   The vector to append them to.
+                 *  @return         The number of elements added.
+                 */
+                static std::size_t parse_values(std::string_view elements, std::vector<float>& values) {
+                    const char* it = elements.data();
+                    const char* const end = elements.data() + elements.size();
                     std::size_t n_added = 0u;
 
-                    while(ss >> element) {
-                        // We do not to use add_data_block_element to avoid
-                        // the check on the label at each iteration.
-                        data[label].push_back(element);
+                    while(true) {
+                        while(it != end && std::isspace(static_cast<unsigned char>(*it))) { ++it; }
+                        if(it != end && *it == '+') { ++it; }
+                        if(it == end) { break; }
+
+                        float element;
+                        const auto result = std::from_chars(it, end, element);
+
+                        if(result.ec != std::errc{}) { break; }
+
+                        values.push_back(element);
+                        it = result.ptr;
                         ++n_added;
                     }
 
@@ -146,6 +190,18 @@ namespace as {
                     return data.find(label) != data.end();
                 }
 
+                /** @brief  Gives the whole specification part.
+                 */
+                const std::map<std::string, std::string>& get_specifications() const {
+                    return specification;
+                }
+
+                /** @brief  Gives the whole data part.
+                 */
+                const std::map<std::string, std::vector<float>>& get_data_blocks() const {
+                    return data;
+                }
+
                 /** @brief      Deleted function, as the user can only use the
                  *              specialised versions.
                  */
@@ -157,7 +213,7 @@ namespace as {
                  *  @param label The data label.
                  *  @return      The values.
                  */
-                std::vector<float> get_data(std::string label) const {
+                const std::vector<float>& get_data(const std::string& label) const {
                     if(data.find(label) == data.end()) {
                         throw std::out_of_range("There is no such data label: " + label);
                     }
@@ -218,93 +274,339 @@ namespace as {
                 return specification.at(key);
             }
 
-            /** @brief              Reads the syntax of a TSPLIB file and makes sure it is correct,
-             *                      without delving into the semantics of what is being read.
+            /** @class  MappedFile
+             *  @brief  A read-only memory mapping of a whole file.
+             */
+            class MappedFile {
+                const char* mapping;
+                std::size_t size;
+
+            public:
+                /** @brief          Maps a file in memory.
+                 *
+                 *  @param file     The file path.
+                 */
+                explicit MappedFile(const std::string& file) : mapping{nullptr}, size{0u} {
+                    const int fd = ::open(file.c_str(), O_RDONLY);
+
+                    if(fd < 0) {
+                        throw std::runtime_error("Cannot read from file: " + file);
+                    }
+
+                    struct stat st;
+
+                    if(::fstat(fd, &st) != 0) {
+                        ::close(fd);
+                        throw std::runtime_error("Cannot read from file: " + file);
+                    }
+
+                    size = static_cast<std::size_t>(st.st_size);
+
+                    // Empty files cannot be mapped, but there is nothing to map anyway.
+                    if(size > 0u) {
+                        void* ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+                        if(ptr == MAP_FAILED) {
+                            ::close(fd);
+                            throw std::runtime_error("Cannot map file: " + file);
+                        }
+
+                        ::madvise(ptr, size, MADV_SEQUENTIAL);
+                        mapping = static_cast<const char*>(ptr);
+                    }
+
+                    ::close(fd);
+                }
+
+                MappedFile(const MappedFile&) = delete;
+                MappedFile& operator=(const MappedFile&) = delete;
+
+                ~MappedFile() {
+                    if(mapping != nullptr) {
+                        ::munmap(const_cast<char*>(mapping), size);
+                    }
+                }
+
+                /** @brief  Gives the contents of the file.
+                 */
+                std::string_view contents() const {
+                    return std::string_view{mapping, size};
+                }
+            };
+
+            /** @brief  Removes initial and final whitespace from a string view.
+             */
+            inline std::string_view trimmed(std::string_view s) {
+                while(!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) { s.remove_prefix(1u); }
+                while(!s.empty() && std::isspace(static_cast<unsigned char>(s.back()))) { s.remove_suffix(1u); }
+                return s;
+            }
+
+            /** @brief  Tells whether a string is a specification keyword or a data
+             *          label, i.e. a non-empty sequence of capital letters and underscores.
+             */
+            inline bool is_keyword(std::string_view s) {
+                return !s.empty() && std::all_of(s.begin(), s.end(), [] (char c) { return (c >= 'A' && c <= 'Z') || c == '_'; });
+            }
+
+            /** @brief          Gives the number of values we expect in a data block, so
+             *                  that we can allocate them in one go.
              *
-             *  @param tsplib_file  The path of the file with the TSPLIB instance specs.
-             *  @return             A structure with the syntactic components of the instance.
+             *  @param tsp      The specification part read so far.
+             *  @param label    The data block label.
+             *  @return         The number of values, or 0 if it is not known.
              */
-            inline TSPLIBInput read_tsplib_file(std::string tsplib_file) {
-                std::ifstream ifs(tsplib_file);
+            inline std::size_t expected_data_size(const TSPLIBInput& tsp, const std::string& label) {
+                if(!tsp.has_specification("DIMENSION")) { return 0u; }
+
+                std::size_t n;
 
-                if(ifs.fail()) {
-                    throw std::runtime_error("Cannot read from file: " + tsplib_file);
+                try {
+                    n = tsp.get_specification<std::size_t>("DIMENSION");
+                } catch(...) {
+                    return 0u;
+                }
+
+                if(label == "NODE_COORD_SECTION") {
+                    return 3u * n;
+                } else if(label == "EDGE_WEIGHT_SECTION" && tsp.has_specification("EDGE_WEIGHT_FORMAT")) {
+                    const auto format = tsp.get_specification<std::string>("EDGE_WEIGHT_FORMAT");
+
+                    if(format == "UPPER_ROW") {
+                        return n * (n - 1u) / 2u;
+                    } else if(format == "LOWER_DIAG_ROW") {
+                        return n * (n + 1u) / 2u;
+                    }
                 }
 
+                return 0u;
+            }
+
+            /** @brief              Reads the syntax of a TSPLIB instance and makes sure it is correct,
+             *                      without delving into the semantics of what is being read.
+             *
+             *  @param contents     The contents of a TSPLIB instance file.
+             *  @return             A structure with the syntactic components of the instance.
+             */
+            inline TSPLIBInput parse_tsplib(std::string_view contents) {
                 TSPLIBInput tsp;
 
-                const std::regex specification_regex("([A-Z_]+)\\s*:\\s*(.+)");
-                std::string line;
                 std::size_t line_number = 0u;
+                std::string_view line;
+                bool has_line = false;
+
+                auto next_line = [&] () -> bool {
+                    if(contents.empty()) { return false; }
+
+                    const auto newline = contents.find('\n');
+                    line = contents.substr(0u, newline);
+                    contents.remove_prefix(newline == std::string_view::npos ? contents.size() : newline + 1u);
+
+                    if(!line.empty() && line.back() == '\r') { line.remove_suffix(1u); }
 
-                // We start reading the specification part, which must come first and
-                // before the data part. Data in the specification part must be in the
-                // format specified by specification_regex.
-                while(std::getline(ifs, line)) {
                     ++line_number;
+                    return true;
+                };
+
+                // We start reading the specification part, which must come first and
+                // before the data part. Each line in the specification part is a keyword,
+                // a colon, and a non-empty value.
+                while((has_line = next_line())) {
+                    const auto colon = line.find(':');
 
-                    std::smatch match;
+                    if(colon == std::string_view::npos) { break; }
 
-                    if(std::regex_match(line, match, specification_regex)) {
-                        // We want the regex to match fully.
-                        // match[0] will contain the whole string;
-                        // match[1] will contain the first parenthesised match;
-                        // match[2] will contain the second parenthesised match.
-                        if(match.size() != 3u) {
-                            std::cerr << console::error << "Invalid format for a specification line. The line is:\n";
-                            std::cerr << "\t" << line << "\n";
-                            throw std::runtime_error("Invalid specification line on line number " + std::to_string(line_number));
-                        }
+                    const auto key = line.substr(0u, colon);
+                    const auto key_end = key.find_last_not_of(" \t\f\v");
+                    const auto value = trimmed(line.substr(colon + 1u));
 
-                        tsp.add_specification(match[1].str(), match[2].str());
-                    } else {
+                    if(key_end == std::string_view::npos || !is_keyword(key.substr(0u, key_end + 1u)) || value.empty()) {
                         // The specification part is probably over, we break and
                         // move to the data part.
                         break;
                     }
+
+                    tsp.add_specification(std::string{key.substr(0u, key_end + 1u)}, std::string{value});
                 }
 
-                const std::regex data_label_regex("^\\s*([A-Z_]+)\\s*$");
-                const std::string eof_marker = "EOF";
-                std::string current_label = "";
+                const std::string_view eof_marker = "EOF";
+                std::vector<float>* current_block = nullptr;
 
                 // We start the data part. The first line of it has already been read,
-                // and used to break the previous loop. Therefore, we now switch the
-                // loop structure from a while-do to a do-while. The labels for the data
-                // part must be in the format specified by data_label_regex.
-                do {
+                // and used to break the previous loop. Each data block starts with a
+                // line with just its label.
+                while(has_line) {
                     if(line == eof_marker) { break; }
 
-                    std::smatch match;
-
-                    if(std::regex_match(line, match, data_label_regex)) {
-                        // We want the regex to match fully.
-                        // match[0] will contain the whole string;
-                        // match[1] will contain the first parenthesised match.
-                        if(match.size() != 2u) {
-                            std::cerr << console::error << "Invalid format for a data label line. The line is:\n";
-                            std::cerr << "\t" << line << "\n";
-                            throw std::runtime_error("Invalid data label line on line number " + std::to_string(line_number));
-                        }
+                    const auto label = trimmed(line);
 
-                        current_label = match[1].str();
-                        tsp.add_data_block(current_label);
+                    if(is_keyword(label)) {
+                        const std::string label_str{label};
+                        current_block = &tsp.add_data_block(label_str);
+                        current_block->reserve(expected_data_size(tsp, label_str));
                     } else {
-                        if(current_label == "") {
+                        if(current_block == nullptr) {
                             std::cerr << console::error << "Data line without a parent label. The line is:\n";
                             std::cerr << "\t" << line << "\n";
                             throw std::runtime_error("Invalid data line on line number " + std::to_string(line_number));
                         }
 
-                        tsp.add_data_block_elements(current_label, line);
+                        TSPLIBInput::parse_values(line, *current_block);
                     }
 
-                    ++line_number;
-                } while(std::getline(ifs, line));
+                    has_line = next_line();
+                }
 
                 return tsp;
             }
 
+            /** @brief              Reads the syntax of a TSPLIB file and makes sure it is correct,
+             *                      without delving into the semantics of what is being read.
+             *
+             *                      The file is mapped in memory and parsed in place.
+             *
+             *  @param tsplib_file  The path of the file with the TSPLIB instance specs.
+             *  @return             A structure with the syntactic components of the instance.
+             */
+            inline TSPLIBInput read_tsplib_file(std::string tsplib_file) {
+                const MappedFile file{tsplib_file};
+                return parse_tsplib(file.contents());
+            }
+
+            /** @brief  Magic bytes at the start of binary instance files.
+             */
+            static constexpr char binary_magic[8] = {'A', 'S', 'T', 'S', 'P', 'B', 'I', 'N'};
+
+            /** @brief  Version of the binary instance format. Files with a different
+             *          version are rejected.
+             */
+            static constexpr std::uint32_t binary_version = 1u;
+
+            /** @brief  Marker used to detect files written on machines with a different
+             *          byte order.
+             */
+            static constexpr std::uint32_t binary_byte_order = 0x01020304u;
+
+            /** @brief  Header of binary instance files.
+             *
+             *          The header is followed by the sections it points to. Offsets are
+             *          from the start of the file, and the distances section is aligned
+             *          to 64 bytes, so that it can be used in place once the file is
+             *          mapped in memory. Coordinates are (x, y) pairs of floats.
+             */
+            struct BinaryInstanceHeader {
+                char magic[8];
+                std::uint32_t version;
+                std::uint32_t byte_order;
+                std::uint64_t n_vertices;
+                std::uint32_t storage;
+                std::uint32_t distance_type;
+                std::uint64_t row_stride;
+                std::uint64_t distances_offset;
+                std::uint64_t distances_count;
+                std::uint64_t coordinates_offset;
+                std::uint64_t coordinates_count;
+                std::uint64_t original_coordinates_offset;
+                std::uint64_t original_coordinates_count;
+                std::uint64_t input_offset;
+                std::uint64_t input_size;
+            };
+
+            /** @brief  Tells whether some file contents are a binary instance.
+             */
+            inline bool is_binary_instance(std::string_view contents) {
+                return contents.size() >= sizeof(binary_magic) &&
+                       std::memcmp(contents.data(), binary_magic, sizeof(binary_magic)) == 0;
+            }
+
+            /** @brief          Serialises the specification and data parts of an instance.
+             *
+             *  @param input    The instance input.
+             *  @param skip     Label of a data block not to serialise, or empty.
+             *  @return         The serialised bytes.
+             */
+            inline std::string serialise_input(const TSPLIBInput& input, const std::string& skip) {
+                std::string out;
+
+                auto put_size = [&] (std::uint64_t size) {
+                    out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+                };
+
+                auto put_string = [&] (const std::string& str) {
+                    put_size(str.size());
+                    out.append(str);
+                };
+
+                put_size(input.get_specifications().size());
+
+                for(const auto& [key, value] : input.get_specifications()) {
+                    put_string(key);
+                    put_string(value);
+                }
+
+                put_size(input.get_data_blocks().size() - (input.has_data(skip) ? 1u : 0u));
+
+                for(const auto& [label, values] : input.get_data_blocks()) {
+                    if(label == skip) { continue; }
+
+                    put_string(label);
+                    put_size(values.size());
+                    out.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+                }
+
+                return out;
+            }
+
+            /** @brief          Reads back the output of \ref serialise_input.
+             *
+             *  @param bytes    The serialised bytes.
+             *  @return         The instance input.
+             */
+            inline TSPLIBInput deserialise_input(std::string_view bytes) {
+                TSPLIBInput input;
+
+                auto get_bytes = [&] (std::size_t size) -> std::string_view {
+                    if(bytes.size() < size) {
+                        throw std::runtime_error("Truncated binary instance file");
+                    }
+
+                    const auto result = bytes.substr(0u, size);
+                    bytes.remove_prefix(size);
+                    return result;
+                };
+
+                auto get_size = [&] () -> std::uint64_t {
+                    std::uint64_t size;
+                    std::memcpy(&size, get_bytes(sizeof(size)).data(), sizeof(size));
+                    return size;
+                };
+
+                auto get_string = [&] () -> std::string {
+                    const auto size = get_size();
+                    return std::string{get_bytes(size)};
+                };
+
+                const auto n_specifications = get_size();
+
+                for(auto i = 0u; i < n_specifications; ++i) {
+                    auto key = get_string();
+                    input.add_specification(std::move(key), get_string());
+                }
+
+                const auto n_blocks = get_size();
+
+                for(auto i = 0u; i < n_blocks; ++i) {
+                    auto& values = input.add_data_block(get_string());
+                    const auto count = get_size();
+                    const auto raw = get_bytes(count * sizeof(float));
+
+                    values.resize(count);
+                    std::memcpy(values.data(), raw.data(), raw.size());
+                }
+
+                return input;
+            }
+
             /** @brief  Constant to use for TSPLIB instances distance calculations.
              *          Similar enough to pi.
              */
@@ -328,6 +630,234 @@ namespace as {
                 return tsp_pi * (deg + 5.0f * rem / 3.0f) / 180.0f;
             }
 
+            /** @brief  The distance functions supported for coordinate-based instances.
+             */
+            enum class DistanceType {
+                EUC_2D,
+                CEIL_2D,
+                GEO,
+                ATT
+            };
+
+            /** @brief          Gets the distance type from its name, as it appears in TSPLIB files.
+             *
+             *  @param f_name   The function name.
+             *  @return         The distance type.
+             */
+            inline DistanceType get_distance_type(const std::string& f_name) {
+                if(f_name == "EUC_2D") {
+                    return DistanceType::EUC_2D;
+                } else if(f_name == "CEIL_2D") {
+                    return DistanceType::CEIL_2D;
+                } else if(f_name == "GEO") {
+                    return DistanceType::GEO;
+                } else if(f_name == "ATT") {
+                    return DistanceType::ATT;
+                } else {
+                    throw std::domain_error("Distance function not supported: " + f_name);
+                }
+            }
+
+            /** @brief  Distance kernel for a given distance type.
+             *
+             *          Each specialisation provides a scalar \ref distance and a one-to-many
+             *          \ref distances_to, which computes the distances from one point to a
+             *          batch of points given in structure-of-arrays layout. The batched
+             *          version gives exactly the same results as the scalar one.
+             *
+             *          Distances must be computed according to a specific formula
+             *          for the results to be comparable with other methods in the
+             *          literature. These formulas might not always seem the most
+             *          intuitive...
+             *
+             *  @tparam Type    The distance type.
+             */
+            template<DistanceType Type>
+            struct DistanceKernel;
+
+#ifdef __AVX2__
+            // Rounds non-negative values half away from zero, as std::round does.
+            // The difference between a value and its truncation is exact.
+            inline __m256 avx2_round_non_negative(__m256 d) {
+                const auto t = _mm256_round_ps(d, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+                const auto up = _mm256_cmp_ps(_mm256_sub_ps(d, t), _mm256_set1_ps(0.5f), _CMP_GE_OQ);
+                return _mm256_add_ps(t, _mm256_and_ps(up, _mm256_set1_ps(1.0f)));
+            }
+
+            // Computes the squared euclidean distances from (x, y) to 8 points, with
+            // the same operations as squared_norm.
+            inline __m256 avx2_squared_norm(float x, float y, const float* xs, const float* ys) {
+                const auto xd = _mm256_sub_ps(_mm256_set1_ps(x), _mm256_loadu_ps(xs));
+                const auto yd = _mm256_sub_ps(_mm256_set1_ps(y), _mm256_loadu_ps(ys));
+#ifdef __FMA__
+                return _mm256_fmadd_ps(xd, xd, _mm256_mul_ps(yd, yd));
+#else
+                return _mm256_add_ps(_mm256_mul_ps(xd, xd), _mm256_mul_ps(yd, yd));
+#endif
+            }
+#endif
+
+            /** @brief  Computes xd * xd + yd * yd.
+             *
+             *          When FMA instructions are available, the compiler may contract the
+             *          expression into a fused multiply-add, which rounds differently; so we
+             *          ask for the fused multiply-add explicitly, and the batched kernels
+             *          do the same, to give the same results.
+             */
+            inline float squared_norm(float xd, float yd) {
+#ifdef __FMA__
+                return std::fma(xd, xd, yd * yd);
+#else
+                return xd * xd + yd * yd;
+#endif
+            }
+
+            /** @brief  Shared implementation of the kernels of planar distance types,
+             *          which are a function of the squared euclidean distance.
+             */
+            template<class Kernel>
+            struct PlanarDistanceKernel {
+                static float distance(float x1, float y1, float x2, float y2) {
+                    const auto xd = x1 - x2;
+                    const auto yd = y1 - y2;
+                    return Kernel::from_squared_norm(squared_norm(xd, yd));
+                }
+
+                static void distances_to(float x, float y, const float* xs, const float* ys, std::size_t n, float* out) {
+                    std::size_t i = 0u;
+
+#ifdef __AVX2__
+                    for(; i + 8u <= n; i += 8u) {
+                        _mm256_storeu_ps(out + i, Kernel::from_squared_norm(avx2_squared_norm(x, y, xs + i, ys + i)));
+                    }
+#endif
+
+                    for(; i < n; ++i) {
+                        out[i] = distance(x, y, xs[i], ys[i]);
+                    }
+                }
+            };
+
+            template<>
+            struct DistanceKernel<DistanceType::EUC_2D> : PlanarDistanceKernel<DistanceKernel<DistanceType::EUC_2D>> {
+                static float from_squared_norm(float sq) {
+                    return std::round(std::sqrt(sq)); // Notice the rounding here!
+                }
+
+#ifdef __AVX2__
+                static __m256 from_squared_norm(__m256 sq) {
+                    return avx2_round_non_negative(_mm256_sqrt_ps(sq));
+                }
+#endif
+            };
+
+            template<>
+            struct DistanceKernel<DistanceType::CEIL_2D> : PlanarDistanceKernel<DistanceKernel<DistanceType::CEIL_2D>> {
+                static float from_squared_norm(float sq) {
+                    return std::ceil(std::sqrt(sq)); // Notice the ceiling here!
+                }
+
+#ifdef __AVX2__
+                static __m256 from_squared_norm(__m256 sq) {
+                    return _mm256_round_ps(_mm256_sqrt_ps(sq), _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+                }
+#endif
+            };
+
+            template<>
+            struct DistanceKernel<DistanceType::ATT> : PlanarDistanceKernel<DistanceKernel<DistanceType::ATT>> {
+                static float from_squared_norm(float sq) {
+                    const auto r = std::sqrt(sq / 10.0f);
+                    const auto t = std::trunc(r);
+
+                    if(t < r) {
+                        return t + 1;
+                    } else {
+                        return t;
+                    }
+                }
+
+#ifdef __AVX2__
+                // Rounding up the truncation of a non-negative value is the ceiling.
+                static __m256 from_squared_norm(__m256 sq) {
+                    const auto r = _mm256_sqrt_ps(_mm256_div_ps(sq, _mm256_set1_ps(10.0f)));
+                    return _mm256_round_ps(r, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC);
+                }
+#endif
+            };
+
+            /** @brief  Kernel of GEO distances.
+             *
+             *          There are no vector intrinsics for acos and cos, so the batched
+             *          version is scalar, but it converts the source point to latitude
+             *          and longitude only once.
+             */
+            template<>
+            struct DistanceKernel<DistanceType::GEO> {
+                static float distance(float x1, float y1, float x2, float y2) {
+                    return from_latlon(latlon(x1), latlon(y1), x2, y2);
+                }
+
+                static void distances_to(float x, float y, const float* xs, const float* ys, std::size_t n, float* out) {
+                    const auto lat1 = latlon(x), lon1 = latlon(y);
+
+                    for(std::size_t i = 0u; i < n; ++i) {
+                        out[i] = from_latlon(lat1, lon1, xs[i], ys[i]);
+                    }
+                }
+
+            private:
+
+                static float from_latlon(float lat1, float lon1, float x2, float y2) {
+                    const auto lat2 = latlon(x2), lon2 = latlon(y2);
+                    const auto q1 = std::cos(lon1 - lon2);
+                    const auto q2 = std::cos(lat1 - lat2);
+                    const auto q3 = std::cos(lat1 + lat2);
+                    const auto q = (1.0f + q1) * q2 - (1.0f - q1) * q3;
+                    const auto qa = std::acos(0.5f * q);
+                    const auto dist = tsp_earth_radius * qa + 1.0f;
+
+                    return std::trunc(dist);
+                }
+            };
+
+            /** @brief      Calls a function with the distance type as a compile-time constant,
+             *              so that the function can use the right kernel without any dispatch
+             *              in its inner loops.
+             *
+             *  @param type The distance type.
+             *  @param f    A function taking a std::integral_constant<DistanceType, T>.
+             *  @return     What the function returns.
+             */
+            template<class F>
+            decltype(auto) dispatch_distance_type(DistanceType type, F&& f) {
+                switch(type) {
+                    case DistanceType::EUC_2D: return f(std::integral_constant<DistanceType, DistanceType::EUC_2D>{});
+                    case DistanceType::CEIL_2D: return f(std::integral_constant<DistanceType, DistanceType::CEIL_2D>{});
+                    case DistanceType::GEO: return f(std::integral_constant<DistanceType, DistanceType::GEO>{});
+                    case DistanceType::ATT: return f(std::integral_constant<DistanceType, DistanceType::ATT>{});
+                }
+
+                throw std::domain_error("Distance type not supported");
+            }
+
+            /** @brief  Computes the distance between points (x1, y1) and (x2, y2).
+             */
+            inline float compute_distance(DistanceType type, float x1, float y1, float x2, float y2) {
+                return dispatch_distance_type(type, [&] (auto t) {
+                    return DistanceKernel<decltype(t)::value>::distance(x1, y1, x2, y2);
+                });
+            }
+
+            /** @brief  Computes the distances from point (x, y) to the n points
+             *          (xs[i], ys[i]), and writes them into \p out.
+             */
+            inline void compute_distances_to(DistanceType type, float x, float y, const float* xs, const float* ys, std::size_t n, float* out) {
+                dispatch_distance_type(type, [&] (auto t) {
+                    DistanceKernel<decltype(t)::value>::distances_to(x, y, xs, ys, n, out);
+                });
+            }
+
             /** @brief          Gets the distance function to use to compute TSPLIB
              *                  distances from vertex coordinates.
              *
@@ -336,56 +866,87 @@ namespace as {
              *                  returns the distance between points (x1, y1) and (x2, y2).
              */
             inline std::function<float(float,float,float,float)> get_distance_function(std::string f_name) {
-                // Distances must be computed according to a specific formula
-                // for the results to be comparable with other methods in the
-                // literature. These formulas might not always seem the most
-                // intuitive...
-                if(f_name == "EUC_2D") {
-                    return [] (float x1, float y1, float x2, float y2) -> float {
-                        const auto xd = x1 - x2;
-                        const auto yd = y1 - y2;
-                        const auto d = std::sqrt(std::pow(xd, 2.0f) + std::pow(yd, 2.0f));
+                return dispatch_distance_type(get_distance_type(f_name), [] (auto t) -> std::function<float(float,float,float,float)> {
+                    return DistanceKernel<decltype(t)::value>::distance;
+                });
+            }
 
-                        return std::round(d); // Notice the rounding here!
-                    };
-                } else if(f_name == "CEIL_2D") {
-                    return [] (float x1, float y1, float x2, float y2) -> float {
-                        const auto xd = x1 - x2;
-                        const auto yd = y1 - y2;
-                        const auto d = std::sqrt(std::pow(xd, 2.0f) + std::pow(yd, 2.0f));
+            /** @brief  A bounded, thread-safe cache of distances, used by instances
+             *          whose distances are computed lazily.
+             *
+             *          The cache is direct-mapped: each pair of vertices can only be
+             *          stored in one slot, and newer pairs overwrite older ones. Each
+             *          slot is a single 64-bit atomic word holding both the distance
+             *          and a tag identifying the pair, so that lookups and insertions
+             *          are lock-free and never return a torn value.
+             */
+            class DistanceCache {
+                std::uint64_t n_vertices;
+                std::uint64_t mask;
+                unsigned int shift;
+                std::vector<std::atomic<std::uint64_t>> slots;
 
-                        return std::ceil(d); // Notice the ceiling here!
-                    };
-                } else if(f_name == "GEO") {
-                    return [] (float x1, float y1, float x2, float y2) -> float {
-                        const auto lat1 = latlon(x1), lon1 = latlon(y1);
-                        const auto lat2 = latlon(x2), lon2 = latlon(y2);
-                        const auto q1 = std::cos(lon1 - lon2);
-                        const auto q2 = std::cos(lat1 - lat2);
-                        const auto q3 = std::cos(lat1 + lat2);
-                        const auto q = (1.0f + q1) * q2 - (1.0f - q1) * q3;
-                        const auto qa = std::acos(0.5f * q);
-                        const auto dist = tsp_earth_radius * qa + 1.0f;
-
-                        return std::trunc(dist);
-                    };
-                } else if(f_name == "ATT") {
-                    return [] (float x1, float y1, float x2, float y2) -> float {
-                        const auto xd = x1 - x2;
-                        const auto yd = y1 - y2;
-                        const auto r = std::sqrt((std::pow(xd, 2.0f) + std::pow(yd, 2.0f)) / 10.0f);
-                        const auto t = std::trunc(r);
-
-                        if(t < r) {
-                            return t + 1;
-                        } else {
-                            return t;
-                        }
-                    };
-                } else {
-                    throw std::domain_error("Distance function not supported: " + f_name);
+            public:
+                /** @brief              Builds an empty cache.
+                 *
+                 *  @param n_vertices   Number of vertices of the instance.
+                 *  @param n_slots      Minimum number of slots. It is rounded up to a power of two,
+                 *                      and increased if needed for the tags to fit in 32 bits.
+                 */
+                DistanceCache(std::size_t n_vertices, std::size_t n_slots) : n_vertices{n_vertices}, shift{0u} {
+                    const std::uint64_t n_pairs = static_cast<std::uint64_t>(n_vertices) * n_vertices;
+
+                    while((std::uint64_t{1u} << shift) < n_slots || (n_pairs >> shift) >= 0xFFFFFFFFu) {
+                        ++shift;
+                    }
+
+                    mask = (std::uint64_t{1u} << shift) - 1u;
+                    slots = std::vector<std::atomic<std::uint64_t>>(std::size_t{1u} << shift);
+
+                    for(auto& slot : slots) {
+                        slot.store(0u, std::memory_order_relaxed);
+                    }
+                }
+
+                /** @brief  Looks up the distance between two vertices.
+                 *
+                 *  @return True iff the pair was in the cache, in which case its
+                 *          distance is written into \p distance.
+                 */
+                bool find(std::size_t v1, std::size_t v2, float& distance) const {
+                    const auto pair = pair_index(v1, v2);
+                    const auto word = slots[pair & mask].load(std::memory_order_relaxed);
+
+                    if((word >> 32u) != tag(pair)) {
+                        return false;
+                    }
+
+                    const auto bits = static_cast<std::uint32_t>(word);
+                    std::memcpy(&distance, &bits, sizeof(float));
+                    return true;
+                }
+
+                /** @brief  Stores the distance between two vertices.
+                 */
+                void insert(std::size_t v1, std::size_t v2, float distance) {
+                    const auto pair = pair_index(v1, v2);
+                    std::uint32_t bits;
+                    std::memcpy(&bits, &distance, sizeof(float));
+                    slots[pair & mask].store((tag(pair) << 32u) | bits, std::memory_order_relaxed);
+                }
+
+            private:
+
+                std::uint64_t pair_index(std::size_t v1, std::size_t v2) const {
+                    if(v1 > v2) { std::swap(v1, v2); }
+                    return static_cast<std::uint64_t>(v1) * n_vertices + v2;
                 }
-            }
+
+                // Tag 0 marks empty slots.
+                std::uint64_t tag(std::uint64_t pair) const {
+                    return (pair >> shift) + 1u;
+                }
+            };
 
             /** @brief  Returns the two intersection points between two circles.
              *
@@ -443,7 +1004,387 @@ namespace as {
                     std::pow(pt1.y - pt2.y, 2.0f)
                 );
             }
-        }
+
+            /** @brief  A standard-library allocator returning memory aligned to
+             *          \p Alignment bytes.
+             */
+            template<class T, std::size_t Alignment>
+            struct AlignedAllocator {
+                using value_type = T;
+
+                template<class U>
+                struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+                AlignedAllocator() = default;
+
+                template<class U>
+                AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+                T* allocate(std::size_t n) {
+                    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+                }
+
+                void deallocate(T* ptr, std::size_t) noexcept {
+                    ::operator delete(ptr, std::align_val_t{Alignment});
+                }
+
+                template<class U>
+                bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+
+                template<class U>
+                bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+            };
+        }
+
+        /** @brief  How \ref TSPInstance::build_neighbour_lists chooses the neighbours of a vertex.
+         */
+        enum class NeighbourSelection {
+            /**
+             * The k vertices nearest to the vertex.
+             */
+            NEAREST,
+
+            /**
+             * The k / 4 nearest vertices in each of the four quadrants around the
+             * vertex, completed with the nearest vertices overall if some quadrants
+             * have fewer vertices. It avoids lists made of a single dense cluster.
+             */
+            QUADRANT
+        };
+
+        namespace detail {
+            /** @class  SpatialGrid
+             *  @brief  A uniform grid over a set of points in the plane, used to find
+             *          the nearest neighbours of a point without scanning all points.
+             *
+             *          Cells are sized to contain about two points each, and points are
+             *          stored sorted by cell in a flat array.
+             */
+            class SpatialGrid {
+                const float* xs;
+                const float* ys;
+                float min_x, min_y, cell_size;
+                std::size_t nx, ny;
+                std::vector<std::size_t> cell_start;
+                std::vector<std::size_t> points;
+
+            public:
+                /** @brief      Builds the grid over points (xs[i], ys[i]), which must
+                 *              outlive the grid.
+                 */
+                SpatialGrid(const float* xs, const float* ys, std::size_t n) : xs{xs}, ys{ys} {
+                    assert(n > 0u);
+
+                    const auto [x_lo, x_hi] = std::minmax_element(xs, xs + n);
+                    const auto [y_lo, y_hi] = std::minmax_element(ys, ys + n);
+                    const auto width = *x_hi - *x_lo, height = *y_hi - *y_lo;
+                    const auto n_cells = std::max<float>(1.0f, n / 2.0f);
+
+                    min_x = *x_lo;
+                    min_y = *y_lo;
+                    cell_size = (width > 0.0f && height > 0.0f) ? std::sqrt(width * height / n_cells) : std::max(width, height) / n_cells;
+
+                    if(!(cell_size > 0.0f)) { cell_size = 1.0f; }
+
+                    nx = std::min<std::size_t>(n, static_cast<std::size_t>(width / cell_size) + 1u);
+                    ny = std::min<std::size_t>(n, static_cast<std::size_t>(height / cell_size) + 1u);
+
+                    // Counting sort of the points by cell.
+                    cell_start.assign(nx * ny + 1u, 0u);
+
+                    for(std::size_t i = 0u; i < n; ++i) {
+                        ++cell_start[cell_of(xs[i], ys[i]) + 1u];
+                    }
+
+                    for(std::size_t c = 0u; c < nx * ny; ++c) {
+                        cell_start[c + 1u] += cell_start[c];
+                    }
+
+                    auto next = cell_start;
+                    points.resize(n);
+
+                    for(std::size_t i = 0u; i < n; ++i) {
+                        points[next[cell_of(xs[i], ys[i])]++] = i;
+                    }
+                }
+
+                /** @brief          Finds the k points nearest to point v, among those
+                 *                  satisfying a filter, and different from v.
+                 *
+                 *  @param v        The point.
+                 *  @param k        The number of neighbours.
+                 *  @param filter   A predicate on point indices.
+                 *  @param out      Where to write the (squared distance, point) pairs found,
+                 *                  sorted by increasing distance and then index.
+                 */
+                template<class Filter>
+                void nearest(std::size_t v, std::size_t k, Filter&& filter, std::vector<std::pair<float, std::size_t>>& out) const {
+                    out.clear();
+                    if(k == 0u) { return; }
+
+                    const auto x = xs[v], y = ys[v];
+                    const auto cx = column_of(x), cy = row_of(y);
+                    const auto max_ring = std::max(nx, ny);
+
+                    // out is kept as a max-heap of the best candidates so far.
+                    for(std::size_t r = 0u; r <= max_ring; ++r) {
+                        for_each_cell_in_ring(cx, cy, r, [&] (std::size_t cell) {
+                            for(auto p = cell_start[cell]; p < cell_start[cell + 1u]; ++p) {
+                                const auto j = points[p];
+
+                                if(j == v || !filter(j)) { continue; }
+
+                                const auto xd = x - xs[j];
+                                const auto yd = y - ys[j];
+                                const std::pair<float, std::size_t> candidate{xd * xd + yd * yd, j};
+
+                                if(out.size() < k) {
+                                    out.push_back(candidate);
+                                    std::push_heap(out.begin(), out.end());
+                                } else if(candidate < out.front()) {
+                                    std::pop_heap(out.begin(), out.end());
+                                    out.back() = candidate;
+                                    std::push_heap(out.begin(), out.end());
+                                }
+                            }
+                        });
+
+                        // Points outside rings 0, ..., r are at least as far as the sides of these
+                        // rings which are inside the grid (there are no points beyond the others).
+                        if(out.size() == k) {
+                            auto border = std::numeric_limits<float>::infinity();
+
+                            if(cx > r) { border = std::min(border, x - (min_x + (cx - r) * cell_size)); }
+                            if(cx + r + 1u < nx) { border = std::min(border, min_x + (cx + r + 1u) * cell_size - x); }
+                            if(cy > r) { border = std::min(border, y - (min_y + (cy - r) * cell_size)); }
+                            if(cy + r + 1u < ny) { border = std::min(border, min_y + (cy + r + 1u) * cell_size - y); }
+
+                            if(border * border > out.front().first) { break; }
+                        }
+                    }
+
+                    std::sort_heap(out.begin(), out.end());
+                }
+
+            private:
+
+                std::size_t column_of(float x) const {
+                    return std::min(nx - 1u, static_cast<std::size_t>((x - min_x) / cell_size));
+                }
+
+                std::size_t row_of(float y) const {
+                    return std::min(ny - 1u, static_cast<std::size_t>((y - min_y) / cell_size));
+                }
+
+                std::size_t cell_of(float x, float y) const {
+                    return row_of(y) * nx + column_of(x);
+                }
+
+                template<class F>
+                void for_each_cell_in_ring(std::size_t cx, std::size_t cy, std::size_t r, F&& f) const {
+                    const auto x_lo = (cx >= r) ? cx - r : 0u, x_hi = std::min(nx - 1u, cx + r);
+                    const auto y_lo = (cy >= r) ? cy - r : 0u, y_hi = std::min(ny - 1u, cy + r);
+
+                    for(auto row = y_lo; row <= y_hi; ++row) {
+                        const bool border_row = (row + r == cy) || (row == cy + r);
+
+                        for(auto col = x_lo; col <= x_hi; ++col) {
+                            if(border_row || col + r == cx || col == cx + r) {
+                                f(row * nx + col);
+                            }
+                        }
+                    }
+                }
+            };
+
+            /** @brief  Gives the quadrant (0 to 3) of point (x, y) with respect to (cx, cy).
+             */
+            inline unsigned int quadrant(float cx, float cy, float x, float y) {
+                return (x >= cx ? 0u : 1u) + (y >= cy ? 0u : 2u);
+            }
+        }
+
+        /** @brief  How a \ref DistanceMatrix stores its values.
+         */
+        enum class DistanceStorage {
+            /**
+             * All n x n values, row-major, with each row padded to a multiple of
+             * 64 bytes.
+             */
+            FULL,
+
+            /**
+             * Only the n (n + 1) / 2 values on and above the diagonal, packed
+             * row-major. It halves the memory, but can only store symmetric
+             * distances, and rows are not aligned.
+             */
+            UPPER_TRIANGULAR,
+
+            /**
+             * No values are stored: distances are computed from the vertex
+             * coordinates at each access, optionally with a bounded cache. Only
+             * used by \ref TSPInstance, for coordinate-based instances.
+             */
+            LAZY
+        };
+
+        /** @class  DistanceMatrix
+         *  @brief  A square matrix of distances, stored in a single contiguous
+         *          block of memory aligned to 64 bytes.
+         *
+         *          The matrix either owns its values, or is a read-only view on a
+         *          memory-mapped binary instance file (see \ref TSPInstance::write_binary).
+         */
+        class DistanceMatrix {
+        public:
+            /** @brief  Alignment, in bytes, of the values and, in full storage, of each row.
+             */
+            static constexpr std::size_t alignment = 64u;
+
+        private:
+            /** @brief  Number of rows (and columns).
+             */
+            std::size_t n;
+
+            /** @brief  Distance, in number of values, between the starts of two
+             *          consecutive rows, in full storage.
+             */
+            std::size_t row_stride;
+
+            /** @brief  Storage mode.
+             */
+            DistanceStorage storage;
+
+            /** @brief  The values, if the matrix owns them.
+             */
+            std::vector<float, detail::AlignedAllocator<float, alignment>> values;
+
+            /** @brief  The mapped file holding the values, if the matrix is a view.
+             */
+            std::shared_ptr<const detail::MappedFile> mapping;
+
+            /** @brief  The start of the values, either owned or mapped.
+             */
+            const float* base;
+
+        public:
+            /** @brief  Builds an empty matrix.
+             */
+            DistanceMatrix() : n{0u}, row_stride{0u}, storage{DistanceStorage::FULL}, base{nullptr} {}
+
+            /** @brief          Builds an n x n matrix of zeroes.
+             *
+             *  @param n        Number of rows (and columns).
+             *  @param storage  Storage mode.
+             */
+            DistanceMatrix(std::size_t n, DistanceStorage storage = DistanceStorage::FULL) :
+                n{n}, storage{storage}
+            {
+                constexpr std::size_t values_per_line = alignment / sizeof(float);
+
+                if(storage == DistanceStorage::FULL) {
+                    row_stride = (n + values_per_line - 1u) / values_per_line * values_per_line;
+                    values.assign(n * row_stride, 0.0f);
+                } else {
+                    row_stride = 0u;
+                    values.assign(n * (n + 1u) / 2u, 0.0f);
+                }
+
+                base = values.data();
+            }
+
+            /** @brief              Builds a read-only view on values stored in a mapped file.
+             *
+             *  @param n            Number of rows (and columns).
+             *  @param storage      Storage mode.
+             *  @param row_stride   Distance between the starts of two consecutive rows, in full storage.
+             *  @param mapping      The mapped file, which the matrix keeps alive.
+             *  @param mapped       The start of the values, inside the mapping. It must be
+             *                      aligned to \ref alignment bytes.
+             */
+            DistanceMatrix(std::size_t n, DistanceStorage storage, std::size_t row_stride,
+                           std::shared_ptr<const detail::MappedFile> mapping, const float* mapped) :
+                n{n}, row_stride{row_stride}, storage{storage}, mapping{std::move(mapping)}, base{mapped}
+            {
+                assert(reinterpret_cast<std::uintptr_t>(mapped) % alignment == 0u);
+            }
+
+            DistanceMatrix(const DistanceMatrix& other) :
+                n{other.n}, row_stride{other.row_stride}, storage{other.storage},
+                values{other.values}, mapping{other.mapping},
+                base{other.mapping ? other.base : values.data()} {}
+
+            // Moving the vector keeps its buffer, and thus base, valid.
+            DistanceMatrix(DistanceMatrix&&) noexcept = default;
+            DistanceMatrix& operator=(DistanceMatrix&&) noexcept = default;
+
+            DistanceMatrix& operator=(const DistanceMatrix& other) {
+                return *this = DistanceMatrix{other};
+            }
+
+            /** @brief  Gives the number of values in \ref data.
+             */
+            std::size_t number_of_values() const {
+                if(storage == DistanceStorage::FULL) {
+                    return n * row_stride;
+                }
+
+                return n * (n + 1u) / 2u;
+            }
+
+            /** @brief  Tells whether the matrix is a read-only view on a mapped file.
+             */
+            bool is_mapped() const { return static_cast<bool>(mapping); }
+
+            /** @brief  Gives the number of rows (and columns).
+             */
+            std::size_t size() const { return n; }
+
+            /** @brief  Gives the storage mode.
+             */
+            DistanceStorage get_storage() const { return storage; }
+
+            /** @brief  Gives the distance, in number of values, between the starts of
+             *          two consecutive rows of \ref data, in full storage.
+             */
+            std::size_t stride() const { return row_stride; }
+
+            /** @brief  Gives the raw values, laid out according to the storage mode.
+             */
+            const float* data() const { return base; }
+
+            /** @brief  Gives the position of element (i, j) in \ref data.
+             */
+            std::size_t index(std::size_t i, std::size_t j) const {
+                assert(i < n && j < n);
+
+                if(storage == DistanceStorage::FULL) {
+                    return i * row_stride + j;
+                }
+
+                if(i > j) { std::swap(i, j); }
+
+                // Row i starts after rows 0, ..., i-1, which have n, n-1, ..., n-i+1 values.
+                return i * n - i * (i - 1u) / 2u + (j - i);
+            }
+
+            /** @brief  Gives element (i, j), without checking the bounds.
+             */
+            float operator()(std::size_t i, std::size_t j) const {
+                return base[index(i, j)];
+            }
+
+            /** @brief  Sets element (i, j) and, in full storage, element (j, i).
+             */
+            void set_symmetric(std::size_t i, std::size_t j, float value) {
+                assert(!is_mapped());
+                values[index(i, j)] = value;
+
+                if(storage == DistanceStorage::FULL) {
+                    values[index(j, i)] = value;
+                }
+            }
+        };
 
         /** @class TSPInstance
          *  @brief This class represents a valid instance of the TSP.
@@ -474,19 +1415,74 @@ namespace as {
 
             /** @brief Distance matrix.
              */
-            std::vector<std::vector<float>> distances;
+            DistanceMatrix distances;
+
+            /** @brief Storage mode of the distance matrix.
+             */
+            DistanceStorage storage;
+
+            /** @brief Distance function, used in lazy mode.
+             */
+            detail::DistanceType distance_type;
+
+            /** @brief Cache of lazily computed distances, if any. It is shared, and
+             *         thus can be used concurrently, by copies of the instance.
+             */
+            std::shared_ptr<detail::DistanceCache> distance_cache;
+
+            /** @brief The original x and y coordinates, in the layout used by the
+             *         batched distance kernels. Used to compute distances.
+             */
+            std::vector<float> kernel_xs, kernel_ys;
+
+            /** @brief Number of neighbours of each vertex in \ref neighbours.
+             */
+            std::size_t n_neighbours = 0u;
+
+            /** @brief Neighbour lists, one after the other: the neighbours of vertex
+             *         v are at positions v * n_neighbours, ..., (v + 1) * n_neighbours - 1.
+             */
+            std::vector<std::size_t> neighbours;
 
         public:
 
             /** @brief              Builds an instance from a TSPLIB file.
              *
              *  @param tsplib_file  The file containing the instance data.
+             *  @param storage      How to store the distance matrix. Triangular
+             *                      storage halves the memory, at the price of some
+             *                      index arithmetic on each access. Lazy storage
+             *                      makes loading and memory linear in the number of
+             *                      vertices, at the price of computing distances on
+             *                      each access; instances with explicit weights
+             *                      ignore it, and use full storage.
+             *  @param cache_slots  In lazy storage, the number of slots of the cache
+             *                      of computed distances. If 0, there is no cache.
+             *
+             *  The file can also be a binary instance file written by \ref write_binary,
+             *  which is recognised by its first bytes. In this case, the storage mode is
+             *  the one the file was written with, and \p storage is ignored.
              */
-            TSPInstance(std::string tsplib_file) : tsplib_file{tsplib_file} {
-                tsp = detail::read_tsplib_file(tsplib_file);
+            TSPInstance(std::string tsplib_file, DistanceStorage storage = DistanceStorage::FULL, std::size_t cache_slots = 0u) :
+                tsplib_file{tsplib_file}, storage{storage}, distance_type{detail::DistanceType::EUC_2D}
+            {
+                auto file = std::make_shared<const detail::MappedFile>(tsplib_file);
+
+                if(detail::is_binary_instance(file->contents())) {
+                    read_binary(std::move(file), cache_slots);
+                    return;
+                }
+
+                tsp = detail::parse_tsplib(file->contents());
+                file.reset();
+
                 n_vertices = tsp.get_specification<std::size_t>("DIMENSION");
 
                 if(tsp.get_specification<std::string>("EDGE_WEIGHT_TYPE") == "EXPLICIT") {
+                    if(this->storage == DistanceStorage::LAZY) {
+                        this->storage = DistanceStorage::FULL;
+                    }
+
                     set_explicit_weights();
 
                     if(tsp.has_data("NODE_COORD_SECTION")) {
@@ -495,6 +1491,12 @@ namespace as {
                         reverse_engineer_coordinates();
                     }
                 } else {
+                    distance_type = detail::get_distance_type(tsp.get_specification<std::string>("EDGE_WEIGHT_TYPE"));
+
+                    if(this->storage == DistanceStorage::LAZY && cache_slots > 0u) {
+                        distance_cache = std::make_shared<detail::DistanceCache>(n_vertices, cache_slots);
+                    }
+
                     set_coordinates_and_weights();
                 }
             }
@@ -555,7 +1557,245 @@ namespace as {
                 if(v2 >= n_vertices) {
                     throw std::out_of_range("No such vertex: " + std::to_string(v2));
                 }
-                return distances[v1][v2];
+                return get_distance_unchecked(v1, v2);
+            }
+
+            /** @brief          Gives the distance between two vertices in the graph,
+             *                  without checking that they exist.
+             *
+             * @param v1        The first vertex.
+             * @param v2        The second vertex.
+             * @return          The distance between the vertices.
+             */
+            float get_distance_unchecked(std::size_t v1, std::size_t v2) const {
+                if(storage == DistanceStorage::LAZY) {
+                    return get_lazy_distance(v1, v2);
+                }
+
+                return distances(v1, v2);
+            }
+
+            /** @brief              Builds the lists of neighbours of each vertex, which can then be
+             *                      accessed with \ref get_neighbours.
+             *
+             *  Each list is sorted by increasing distance. For instances with planar
+             *  distances (EUC_2D, CEIL_2D, ATT), the lists are built in about O(n k log k)
+             *  time with a spatial grid over the coordinates; ties are broken by the
+             *  unrounded distance, and then by index. For other instances, they are built
+             *  by scanning each row of distances, in O(n^2) time, and ties are broken
+             *  by index. Quadrants are computed on the vertex coordinates.
+             *
+             *  @param k            Number of neighbours per vertex. It is capped to the number
+             *                      of vertices minus one.
+             *  @param selection    How to choose the neighbours.
+             */
+            void build_neighbour_lists(std::size_t k, NeighbourSelection selection = NeighbourSelection::NEAREST) {
+                n_neighbours = std::min(k, n_vertices > 0u ? n_vertices - 1u : 0u);
+                neighbours.assign(n_vertices * n_neighbours, 0u);
+
+                if(n_neighbours == 0u) { return; }
+
+                std::vector<std::pair<float, std::size_t>> found, selected;
+
+                if(has_planar_distances()) {
+                    const detail::SpatialGrid grid{kernel_xs.data(), kernel_ys.data(), n_vertices};
+
+                    for(std::size_t v = 0u; v < n_vertices; ++v) {
+                        if(selection == NeighbourSelection::NEAREST) {
+                            grid.nearest(v, n_neighbours, [] (std::size_t) { return true; }, selected);
+                        } else {
+                            selected.clear();
+
+                            for(auto q = 0u; q < 4u; ++q) {
+                                grid.nearest(v, std::max<std::size_t>(1u, n_neighbours / 4u), [&] (std::size_t w) {
+                                    return detail::quadrant(kernel_xs[v], kernel_ys[v], kernel_xs[w], kernel_ys[w]) == q;
+                                }, found);
+                                selected.insert(selected.end(), found.begin(), found.end());
+                            }
+
+                            complete_selection(selected, [&] (std::vector<std::pair<float, std::size_t>>& out) {
+                                grid.nearest(v, n_neighbours, [] (std::size_t) { return true; }, out);
+                            });
+                        }
+
+                        store_neighbours(v, selected);
+                    }
+                } else {
+                    std::vector<float> row(n_vertices);
+
+                    for(std::size_t v = 0u; v < n_vertices; ++v) {
+                        get_distances_from(v, row.data());
+
+                        auto nearest = [&] (std::size_t k, auto&& filter, std::vector<std::pair<float, std::size_t>>& out) {
+                            out.clear();
+
+                            for(std::size_t w = 0u; w < n_vertices; ++w) {
+                                if(w != v && filter(w)) { out.emplace_back(row[w], w); }
+                            }
+
+                            const auto n_kept = std::min(k, out.size());
+                            std::partial_sort(out.begin(), out.begin() + n_kept, out.end());
+                            out.resize(n_kept);
+                        };
+
+                        if(selection == NeighbourSelection::NEAREST) {
+                            nearest(n_neighbours, [] (std::size_t) { return true; }, selected);
+                        } else {
+                            selected.clear();
+
+                            for(auto q = 0u; q < 4u; ++q) {
+                                nearest(std::max<std::size_t>(1u, n_neighbours / 4u), [&] (std::size_t w) {
+                                    return detail::quadrant(coordinates[v].x, coordinates[v].y, coordinates[w].x, coordinates[w].y) == q;
+                                }, found);
+                                selected.insert(selected.end(), found.begin(), found.end());
+                            }
+
+                            complete_selection(selected, [&] (std::vector<std::pair<float, std::size_t>>& out) {
+                                nearest(n_neighbours, [] (std::size_t) { return true; }, out);
+                            });
+                        }
+
+                        store_neighbours(v, selected);
+                    }
+                }
+            }
+
+            /** @brief          Gives the neighbours of a vertex, sorted by increasing
+             *                  distance. \ref build_neighbour_lists must have been called.
+             *
+             * @param v         The vertex.
+             * @return          An iterator_pair over the neighbours.
+             */
+            iterators::iterator_pair<const std::size_t*> get_neighbours(std::size_t v) const {
+                if(v >= n_vertices) {
+                    throw std::out_of_range("No such vertex: " + std::to_string(v));
+                }
+
+                const auto begin = neighbours.data() + v * n_neighbours;
+                return iterators::iterator_pair<const std::size_t*>{begin, begin + n_neighbours};
+            }
+
+            /** @brief  Gives the number of neighbours of each vertex, or 0 if
+             *          \ref build_neighbour_lists was not called.
+             */
+            std::size_t number_of_neighbours() const {
+                return n_neighbours;
+            }
+
+            /** @brief          Gives the distances from a vertex to all vertices in the
+             *                  graph, e.g. to evaluate all insertion positions at once.
+             *
+             *  In lazy storage, it computes the distances with the batched kernels,
+             *  bypassing the cache.
+             *
+             * @param v         The vertex.
+             * @param out       Where to write the distances: must have room for
+             *                  \ref number_of_vertices values.
+             */
+            void get_distances_from(std::size_t v, float* out) const {
+                if(v >= n_vertices) {
+                    throw std::out_of_range("No such vertex: " + std::to_string(v));
+                }
+
+                if(storage == DistanceStorage::LAZY) {
+                    detail::compute_distances_to(distance_type, kernel_xs[v], kernel_ys[v], kernel_xs.data(), kernel_ys.data(), n_vertices, out);
+                    out[v] = 0.0f;
+                } else if(storage == DistanceStorage::FULL) {
+                    std::copy_n(distances.data() + v * distances.stride(), n_vertices, out);
+                } else {
+                    for(std::size_t w = 0u; w < n_vertices; ++w) {
+                        out[w] = distances(v, w);
+                    }
+                }
+            }
+
+            /** @brief              Writes the instance to a binary file, which the constructor
+             *                      can then read back much faster than the original file.
+             *
+             *  The binary file holds the specification part, the data blocks, the coordinates
+             *  and the distance matrix, as computed when the instance was loaded. When reading
+             *  it back, the distance matrix is not copied: it is used directly from the file,
+             *  mapped in memory, so that processes loading the same file share a copy of it.
+             *  The EDGE_WEIGHT_SECTION data block, which is redundant with the matrix, is not
+             *  written. The file is only meant to be read on machines with the same byte order.
+             *
+             *  @param binary_file  The path of the file to write.
+             */
+            void write_binary(const std::string& binary_file) const {
+                using detail::BinaryInstanceHeader;
+
+                std::ofstream ofs(binary_file, std::ios::binary | std::ios::trunc);
+
+                if(ofs.fail()) {
+                    throw std::runtime_error("Cannot write to file: " + binary_file);
+                }
+
+                const auto input = detail::serialise_input(tsp, "EDGE_WEIGHT_SECTION");
+                auto align = [] (std::uint64_t offset) {
+                    return (offset + DistanceMatrix::alignment - 1u) / DistanceMatrix::alignment * DistanceMatrix::alignment;
+                };
+
+                BinaryInstanceHeader header{};
+                std::memcpy(header.magic, detail::binary_magic, sizeof(header.magic));
+                header.version = detail::binary_version;
+                header.byte_order = detail::binary_byte_order;
+                header.n_vertices = n_vertices;
+                header.storage = static_cast<std::uint32_t>(storage);
+                header.distance_type = static_cast<std::uint32_t>(distance_type);
+                header.row_stride = distances.stride();
+                header.distances_offset = align(sizeof(header));
+                header.distances_count = (storage == DistanceStorage::LAZY) ? 0u : distances.number_of_values();
+                header.coordinates_offset = align(header.distances_offset + header.distances_count * sizeof(float));
+                header.coordinates_count = coordinates.size();
+                header.original_coordinates_offset = align(header.coordinates_offset + header.coordinates_count * 2u * sizeof(float));
+                header.original_coordinates_count = original_coordinates.size();
+                header.input_offset = align(header.original_coordinates_offset + header.original_coordinates_count * 2u * sizeof(float));
+                header.input_size = input.size();
+
+                auto write_at = [&] (std::uint64_t offset, const void* bytes, std::size_t size) {
+                    const std::string padding(offset - static_cast<std::uint64_t>(ofs.tellp()), '\0');
+                    ofs.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+                    ofs.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+                };
+
+                auto write_points = [&] (std::uint64_t offset, const std::vector<geo::TwoDimPoint>& points) {
+                    std::vector<float> xy;
+                    xy.reserve(2u * points.size());
+
+                    for(const auto& point : points) {
+                        xy.push_back(point.x);
+                        xy.push_back(point.y);
+                    }
+
+                    write_at(offset, xy.data(), xy.size() * sizeof(float));
+                };
+
+                write_at(0u, &header, sizeof(header));
+                write_at(header.distances_offset, distances.data(), header.distances_count * sizeof(float));
+                write_points(header.coordinates_offset, coordinates);
+                write_points(header.original_coordinates_offset, original_coordinates);
+                write_at(header.input_offset, input.data(), input.size());
+
+                if(ofs.fail()) {
+                    throw std::runtime_error("Cannot write to file: " + binary_file);
+                }
+            }
+
+            /** @brief  Gives the storage mode of the distances.
+             *
+             *  @return The storage mode.
+             */
+            DistanceStorage get_distance_storage() const {
+                return storage;
+            }
+
+            /** @brief  Gives the distance matrix, e.g. to access its raw data.
+             *          It is empty in lazy storage.
+             *
+             *  @return The distance matrix.
+             */
+            const DistanceMatrix& get_distance_matrix() const {
+                return distances;
             }
 
             /** @brief          Gets the raw specification directly from the
@@ -577,12 +1817,190 @@ namespace as {
              *  @param label    The data label.
              *  @return         The data vector.
              */
-            std::vector<float> get_raw_data(std::string label) const {
+            const std::vector<float>& get_raw_data(std::string label) const {
                 return tsp.get_data(label);
             }
 
         private:
 
+            bool has_planar_distances() const {
+                return tsp.get_specification<std::string>("EDGE_WEIGHT_TYPE") != "EXPLICIT" &&
+                       distance_type != detail::DistanceType::GEO;
+            }
+
+            // Completes the per-quadrant selection, which might have too few (if some quadrants have
+            // few vertices) or too many (if k is not a multiple of 4) vertices, with the nearest ones.
+            template<class Nearest>
+            void complete_selection(std::vector<std::pair<float, std::size_t>>& selected, Nearest&& nearest) const {
+                std::sort(selected.begin(), selected.end());
+
+                if(selected.size() > n_neighbours) {
+                    selected.resize(n_neighbours);
+                } else if(selected.size() < n_neighbours) {
+                    std::vector<std::pair<float, std::size_t>> overall;
+                    nearest(overall);
+
+                    for(const auto& candidate : overall) {
+                        if(selected.size() == n_neighbours) { break; }
+
+                        if(std::none_of(selected.begin(), selected.end(), [&] (const auto& s) { return s.second == candidate.second; })) {
+                            selected.push_back(candidate);
+                        }
+                    }
+
+                    std::sort(selected.begin(), selected.end());
+                }
+
+                assert(selected.size() == n_neighbours);
+            }
+
+            void store_neighbours(std::size_t v, const std::vector<std::pair<float, std::size_t>>& selected) {
+                assert(selected.size() == n_neighbours);
+
+                for(auto i = 0u; i < n_neighbours; ++i) {
+                    neighbours[v * n_neighbours + i] = selected[i].second;
+                }
+            }
+
+            void read_binary(std::shared_ptr<const detail::MappedFile> file, std::size_t cache_slots) {
+                using detail::BinaryInstanceHeader;
+
+                const auto contents = file->contents();
+                BinaryInstanceHeader header;
+
+                if(contents.size() < sizeof(header)) {
+                    throw std::runtime_error("Truncated binary instance file: " + tsplib_file);
+                }
+
+                std::memcpy(&header, contents.data(), sizeof(header));
+
+                if(header.byte_order != detail::binary_byte_order) {
+                    throw std::runtime_error("Binary instance file written with a different byte order: " + tsplib_file);
+                }
+
+                if(header.version != detail::binary_version) {
+                    throw std::runtime_error("Unsupported binary instance file version " + std::to_string(header.version) + ": " + tsplib_file);
+                }
+
+                auto section = [&] (std::uint64_t offset, std::uint64_t size) -> const char* {
+                    if(offset > contents.size() || size > contents.size() - offset) {
+                        throw std::runtime_error("Truncated binary instance file: " + tsplib_file);
+                    }
+
+                    return contents.data() + offset;
+                };
+
+                // Checks count against the file size first, so that count * value_size cannot overflow.
+                auto array_section = [&] (std::uint64_t offset, std::uint64_t count, std::size_t value_size) {
+                    if(count > contents.size() / value_size) {
+                        throw std::runtime_error("Truncated binary instance file: " + tsplib_file);
+                    }
+
+                    return section(offset, count * value_size);
+                };
+
+                auto read_points = [&] (std::uint64_t offset, std::uint64_t count) {
+                    const auto bytes = array_section(offset, count, 2u * sizeof(float));
+                    std::vector<float> xy(2u * count);
+                    std::memcpy(xy.data(), bytes, xy.size() * sizeof(float));
+
+                    std::vector<geo::TwoDimPoint> points(count);
+
+                    for(auto i = 0u; i < count; ++i) {
+                        points[i] = {xy[2u * i], xy[2u * i + 1u]};
+                    }
+
+                    return points;
+                };
+
+                if(header.storage > static_cast<std::uint32_t>(DistanceStorage::LAZY) ||
+                   header.distance_type > static_cast<std::uint32_t>(detail::DistanceType::ATT)) {
+                    throw std::runtime_error("Invalid header in binary instance file: " + tsplib_file);
+                }
+
+                // Validate the sizes before building anything, so that a corrupted header
+                // cannot make accesses go past the mapping or the coordinates.
+                const auto n = header.n_vertices;
+                const auto has_coordinates = [n] (std::uint64_t count) { return count == 0u || count == n; };
+                std::uint64_t expected_distances_count = 0u;
+
+                if(n > contents.size()) {
+                    throw std::runtime_error("Truncated binary instance file: " + tsplib_file);
+                }
+
+                if(header.storage == static_cast<std::uint32_t>(DistanceStorage::FULL)) {
+                    if(header.row_stride < n || (n > 0u && header.row_stride > contents.size() / n)) {
+                        throw std::runtime_error("Invalid row stride in binary instance file: " + tsplib_file);
+                    }
+
+                    expected_distances_count = n * header.row_stride;
+                } else if(header.storage == static_cast<std::uint32_t>(DistanceStorage::UPPER_TRIANGULAR)) {
+                    expected_distances_count = n * (n + 1u) / 2u;
+                }
+
+                if(header.distances_count != expected_distances_count) {
+                    throw std::runtime_error("Inconsistent distance matrix size in binary instance file: " + tsplib_file);
+                }
+
+                if(header.distances_offset % DistanceMatrix::alignment != 0u) {
+                    throw std::runtime_error("Misaligned distance matrix in binary instance file: " + tsplib_file);
+                }
+
+                if(!has_coordinates(header.coordinates_count) || !has_coordinates(header.original_coordinates_count) ||
+                   (header.storage == static_cast<std::uint32_t>(DistanceStorage::LAZY) && header.original_coordinates_count != n)) {
+                    throw std::runtime_error("Inconsistent number of coordinates in binary instance file: " + tsplib_file);
+                }
+
+                n_vertices = header.n_vertices;
+                storage = static_cast<DistanceStorage>(header.storage);
+                distance_type = static_cast<detail::DistanceType>(header.distance_type);
+                coordinates = read_points(header.coordinates_offset, header.coordinates_count);
+                original_coordinates = read_points(header.original_coordinates_offset, header.original_coordinates_count);
+                tsp = detail::deserialise_input(std::string_view{
+                    section(header.input_offset, header.input_size), header.input_size
+                });
+
+                kernel_xs.resize(original_coordinates.size());
+                kernel_ys.resize(original_coordinates.size());
+
+                for(auto i = 0u; i < original_coordinates.size(); ++i) {
+                    kernel_xs[i] = original_coordinates[i].x;
+                    kernel_ys[i] = original_coordinates[i].y;
+                }
+
+                if(storage == DistanceStorage::LAZY) {
+                    if(cache_slots > 0u) {
+                        distance_cache = std::make_shared<detail::DistanceCache>(n_vertices, cache_slots);
+                    }
+                } else {
+                    const auto values = reinterpret_cast<const float*>(
+                        array_section(header.distances_offset, header.distances_count, sizeof(float))
+                    );
+
+                    distances = DistanceMatrix{n_vertices, storage, header.row_stride, std::move(file), values};
+                }
+            }
+
+            float get_lazy_distance(std::size_t v1, std::size_t v2) const {
+                if(v1 == v2) {
+                    return 0.0f;
+                }
+
+                float distance;
+
+                if(distance_cache && distance_cache->find(v1, v2, distance)) {
+                    return distance;
+                }
+
+                distance = detail::compute_distance(distance_type, kernel_xs[v1], kernel_ys[v1], kernel_xs[v2], kernel_ys[v2]);
+
+                if(distance_cache) {
+                    distance_cache->insert(v1, v2, distance);
+                }
+
+                return distance;
+            }
+
             void set_explicit_weights() {
                 const auto format = tsp.get_specification<std::string>("EDGE_WEIGHT_FORMAT");
 
@@ -596,24 +2014,23 @@ namespace as {
             }
 
             void set_explicit_weights_upper_row() {
-                distances.resize(n_vertices, std::vector<float>(n_vertices, 0.0f));
+                distances = DistanceMatrix{n_vertices, storage};
 
-                const auto weights = tsp.get_data("EDGE_WEIGHT_SECTION");
+                const auto& weights = tsp.get_data("EDGE_WEIGHT_SECTION");
                 std::size_t w_index = 0u;
 
                 for(auto i = 0u; i < n_vertices; ++i) {
                     for(auto j = i + 1; j < n_vertices; ++j) {
-                        distances[i][j] = weights[w_index];
-                        distances[j][i] = weights[w_index];
-                        ++w_index;
-
-                        if(w_index > weights.size()) {
+                        if(w_index >= weights.size()) {
                             throw std::out_of_range(
                                 "Index " + std::to_string(w_index) +
                                 " out of range for EDGE_WEIGHT_SECTION, which has " +
                                 std::to_string(weights.size()) + " elements"
                             );
                         }
+
+                        distances.set_symmetric(i, j, weights[w_index]);
+                        ++w_index;
                     }
                 }
 
@@ -627,9 +2044,9 @@ namespace as {
             }
 
             void set_explicit_weights_lower_diag_row() {
-                distances.resize(n_vertices, std::vector<float>(n_vertices, 0.0f));
+                distances = DistanceMatrix{n_vertices, storage};
 
-                const auto weights = tsp.get_data("EDGE_WEIGHT_SECTION");
+                const auto& weights = tsp.get_data("EDGE_WEIGHT_SECTION");
                 auto i = 0u;
                 auto j = 0u;
 
@@ -642,8 +2059,7 @@ namespace as {
                         throw std::out_of_range("Value for j is " + std::to_string(j) + " for a vector of size " + std::to_string(n_vertices));
                     }
 
-                    distances[i][j] = weight;
-                    distances[j][i] = weight;
+                    distances.set_symmetric(i, j, weight);
 
                     ++j;
 
@@ -724,7 +2140,7 @@ namespace as {
             }
 
             void set_coordinates_euclidean() {
-                const auto coords = tsp.get_data("NODE_COORD_SECTION");
+                const auto& coords = tsp.get_data("NODE_COORD_SECTION");
                 coordinates.resize(n_vertices);
 
                 // Coordinates come in triplets:
@@ -748,19 +2164,35 @@ namespace as {
             }
 
             void set_weights_from_coordinates() {
-                const auto dist_f = detail::get_distance_function(tsp.get_specification<std::string>("EDGE_WEIGHT_TYPE"));
-                distances.resize(n_vertices, std::vector<float>(n_vertices, 0.0f));
+                // Distances are computed on the coordinates as they appear in the file
+                // (for GEO instances, coordinates are later projected on the plane).
+                kernel_xs.resize(n_vertices);
+                kernel_ys.resize(n_vertices);
 
                 for(auto i = 0u; i < n_vertices; ++i) {
-                    for(auto j = i + 1; j < n_vertices; ++j) {
-                        const auto dist = dist_f(
-                            coordinates[i].x, coordinates[i].y,
-                            coordinates[j].x, coordinates[j].y
-                        );
-                        distances[i][j] = dist;
-                        distances[j][i] = dist;
-                    }
+                    kernel_xs[i] = coordinates[i].x;
+                    kernel_ys[i] = coordinates[i].y;
+                }
+
+                if(storage == DistanceStorage::LAZY) {
+                    return;
                 }
+
+                distances = DistanceMatrix{n_vertices, storage};
+                std::vector<float> row(n_vertices);
+
+                detail::dispatch_distance_type(distance_type, [&] (auto t) {
+                    using Kernel = detail::DistanceKernel<decltype(t)::value>;
+
+                    for(auto i = 0u; i < n_vertices; ++i) {
+                        const auto n_after = n_vertices - i - 1u;
+                        Kernel::distances_to(kernel_xs[i], kernel_ys[i], kernel_xs.data() + i + 1u, kernel_ys.data() + i + 1u, n_after, row.data());
+
+                        for(auto k = 0u; k < n_after; ++k) {
+                            distances.set_symmetric(i, i + 1u + k, row[k]);
+                        }
+                    }
+                });
             }
 
             void reverse_engineer_coordinates() {
@@ -772,22 +2204,22 @@ namespace as {
                 coordinates[0] = {0.0f, 0.0f};
 
                 // We place the second point on the positive x-semiaxis.
-                coordinates[1] = {distances[0][1], 0.0f};
+                coordinates[1] = {distances(0, 1), 0.0f};
 
                 // We place the third point on the positive x-halfplane.
-                coordinates[2] = detail::get_circle_intersection(distances[0][2], distances[1][2], distances[0][1]).first;
+                coordinates[2] = detail::get_circle_intersection(distances(0, 2), distances(1, 2), distances(0, 1)).first;
 
                 // We place all other points in the position that better matches their distance
                 // with the third point.
                 for(auto i = 3u; i < n_vertices; ++i) {
                     const auto positions = detail::get_circle_intersection(
-                        distances[0][i], distances[1][i], distances[0][1]
+                        distances(0, i), distances(1, i), distances(0, 1)
                     );
 
                     const auto distance_first = detail::euclidean_dist(coordinates[2], positions.first);
                     const auto distance_second = detail::euclidean_dist(coordinates[2], positions.second);
 
-                    if(std::abs(distance_first - distances[2][i]) < std::abs(distance_second - distances[2][i])) {
+                    if(std::abs(distance_first - distances(2, i)) < std::abs(distance_second - distances(2, i))) {
                         coordinates[i] = positions.first;
                     } else {
                         coordinates[i] = positions.second;
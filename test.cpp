@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 
 #include <boost/graph/adjacency_list.hpp>
+#include <list>
 
 #include "src/and_die.h"
 #include "src/console.h"
@@ -14,14 +15,19 @@
 #include "src/numeric.h"
 #include "src/geometry.h"
 #include "src/max_clique.h"
+#include "src/max_clique_bnb.h"
 #include "src/random.h"
 #include "src/string.h"
 #include "src/combinatorial.h"
 #include "src/tsplib.h"
+#include "src/oplib.h"
 #include "src/discorde.h"
 #include "src/mtz.h"
 #include "src/repeat.h"
 #include "src/tsp.h"
+#include "src/tsp_cache.h"
+#include "src/tsp_heuristic.h"
+#include "src/thread_pool.h"
 
 namespace {
     using namespace as;
@@ -278,6 +284,126 @@ namespace {
         ASSERT_EQ(clique_zw.best_clique, zero_weight_expected);
     }
 
+    TEST_F(CliqueTest, MipCliqueIndependentSetFormulation) {
+        using namespace as::max_clique;
+
+        const auto clique_u = solve_with_mip(u, std::nullopt, MipFormulation::INDEPENDENT_SET);
+        const auto clique_w = solve_with_mip(w, std::nullopt, MipFormulation::INDEPENDENT_SET);
+        const std::vector<unsigned long> expected = { 0u, 1u, 2u };
+        const std::vector<unsigned long> weighted_expected = { 0u, 3u };
+
+        ASSERT_EQ(clique_u.ub, expected.size());
+        ASSERT_EQ(clique_u.best_clique, expected);
+        ASSERT_EQ(clique_w.ub, 9.0f);
+        ASSERT_EQ(clique_w.best_clique, weighted_expected);
+    }
+
+    TEST_F(CliqueTest, MipCliqueSolverReuse) {
+        using namespace as::max_clique;
+
+        MipCliqueSolver<decltype(w)> solver{w, MipFormulation::INDEPENDENT_SET};
+        const std::vector<unsigned long> weighted_expected = { 0u, 3u };
+        const std::vector<unsigned long> triangle_expected = { 0u, 1u, 2u };
+
+        ASSERT_EQ(solver.solve().best_clique, weighted_expected);
+        ASSERT_EQ(solver.solve({1.0f, 1.0f, 1.0f, 0.0f}).best_clique, triangle_expected);
+        ASSERT_EQ(solver.solve({1.0f, 1.0f, 1.0f, 0.0f}).ub, 3.0f);
+        ASSERT_EQ(solver.solve().ub, 9.0f);
+    }
+
+    TEST_F(CliqueTest, BnbClique) {
+        using namespace as::max_clique;
+
+        const auto clique_u = solve_with_bnb(u);
+        const auto clique_d = solve_with_bnb(d);
+        const auto clique_w = solve_with_bnb(w);
+        const auto clique_we = solve_with_bnb(without_edges);
+        const auto clique_zw = solve_with_bnb(zero_weight);
+        const std::vector<unsigned long> expected = { 0u, 1u, 2u };
+        const std::vector<unsigned long> weighted_expected = { 0u, 3u };
+        const std::vector<unsigned long> without_edges_expected = { 1u };
+
+        ASSERT_EQ(clique_u.lb, 3.0f);
+        ASSERT_EQ(clique_u.ub, 3.0f);
+        ASSERT_EQ(clique_u.best_clique, expected);
+        ASSERT_EQ(clique_d.best_clique, expected);
+
+        ASSERT_EQ(clique_w.lb, 9.0f);
+        ASSERT_EQ(clique_w.ub, 9.0f);
+        ASSERT_EQ(clique_w.best_clique, weighted_expected);
+
+        ASSERT_EQ(clique_we.lb, 2.0f);
+        ASSERT_EQ(clique_we.best_clique, without_edges_expected);
+
+        ASSERT_EQ(clique_zw.lb, 0.0f);
+        ASSERT_EQ(clique_zw.ub, 0.0f);
+        ASSERT_TRUE(clique_zw.best_clique.empty());
+    }
+
+    TEST_F(CliqueTest, BnbCliqueOnRandomGraphs) {
+        using namespace as::max_clique;
+
+        std::mt19937 mt{42};
+        std::uniform_int_distribution<int> weight_dist{1, 10};
+        std::bernoulli_distribution edge_dist{0.6};
+        as::concurrency::ThreadPool pool{4u};
+
+        for(auto t = 0u; t < 5u; ++t) {
+            const auto n = 16u;
+            boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS, VertexProperty> g;
+
+            for(auto i = 0u; i < n; ++i) {
+                boost::add_vertex({static_cast<float>(weight_dist(mt))}, g);
+            }
+
+            for(auto i = 0u; i < n; ++i) {
+                for(auto j = i + 1u; j < n; ++j) {
+                    if(edge_dist(mt)) { boost::add_edge(i, j, g); }
+                }
+            }
+
+            // Brute force over all subsets.
+            float best = 0.0f;
+
+            for(auto mask = 1u; mask < (1u << n); ++mask) {
+                bool clique = true;
+                float weight = 0.0f;
+
+                for(auto i = 0u; clique && i < n; ++i) {
+                    if(!(mask & (1u << i))) { continue; }
+
+                    weight += g[i].weight;
+
+                    for(auto j = i + 1u; clique && j < n; ++j) {
+                        clique = !(mask & (1u << j)) || boost::edge(i, j, g).second;
+                    }
+                }
+
+                if(clique) { best = std::max(best, weight); }
+            }
+
+            const auto sequential = solve_with_bnb(g);
+            const auto parallel = solve_with_bnb(g, pool);
+
+            ASSERT_EQ(sequential.lb, best);
+            ASSERT_EQ(sequential.ub, best);
+            ASSERT_EQ(parallel.lb, best);
+            ASSERT_EQ(parallel.ub, best);
+
+            float weight = 0.0f;
+
+            for(auto i = 0u; i < parallel.best_clique.size(); ++i) {
+                weight += g[parallel.best_clique[i]].weight;
+
+                for(auto j = i + 1u; j < parallel.best_clique.size(); ++j) {
+                    ASSERT_TRUE(boost::edge(parallel.best_clique[i], parallel.best_clique[j], g).second);
+                }
+            }
+
+            ASSERT_EQ(weight, best);
+        }
+    }
+
     TEST_F(CliqueTest, PmcClique) {
         using namespace as::max_clique;
 
@@ -496,6 +622,90 @@ namespace {
         }
     }
 
+    TEST_F(GraphTest, DenseGraph) {
+        using namespace as::graph;
+
+        const auto dense = DenseGraph::from_boost(u);
+
+        ASSERT_EQ(dense.number_of_vertices(), 4u);
+        ASSERT_EQ(dense.number_of_edges(), 4u);
+        ASSERT_TRUE(dense.are_connected(0u, 1u));
+        ASSERT_TRUE(dense.are_connected(1u, 0u));
+        ASSERT_FALSE(dense.are_connected(0u, 2u));
+        ASSERT_EQ(dense.degree(0u), 2u);
+        ASSERT_EQ(dense.number_of_common_neighbours(0u, 2u), 2u);
+        ASSERT_EQ(DenseGraph::from_boost(d).number_of_edges(), 4u);
+
+        const auto comp = dense.complement();
+
+        ASSERT_EQ(comp.number_of_edges(), 2u);
+        ASSERT_TRUE(comp.are_connected(0u, 2u));
+        ASSERT_TRUE(comp.are_connected(1u, 3u));
+
+        // A path spanning more than one word per row.
+        DenseGraph path{70u};
+
+        for(auto i = 0u; i + 1u < 70u; ++i) {
+            path.add_edge(i, i + 1u);
+        }
+
+        const auto path_comp = path.complement();
+
+        ASSERT_EQ(path_comp.number_of_edges(), 70u * 69u / 2u - 69u);
+        ASSERT_FALSE(path_comp.are_connected(63u, 64u));
+        ASSERT_TRUE(path_comp.are_connected(0u, 69u));
+        ASSERT_EQ(path_comp.degree(69u), 68u);
+
+        std::vector<std::size_t> neighbours;
+        path.for_each_neighbour(64u, [&] (std::size_t v) { neighbours.push_back(v); });
+        ASSERT_EQ(neighbours, (std::vector<std::size_t>{63u, 65u}));
+
+        const auto boost_path = path.to_boost<boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS>>();
+
+        ASSERT_EQ(boost::num_vertices(boost_path), 70u);
+        ASSERT_EQ(boost::num_edges(boost_path), 69u);
+        ASSERT_TRUE(boost::edge(63u, 64u, boost_path).second);
+        ASSERT_EQ(boost::num_edges(complementary(boost_path)), path_comp.number_of_edges());
+    }
+
+    TEST(DenseGraphTest, IndependentSetCover) {
+        using namespace as::graph;
+
+        std::mt19937 mt{7};
+        std::bernoulli_distribution edge_dist{0.3};
+        DenseGraph g{90u};
+
+        for(auto i = 0u; i < 90u; ++i) {
+            for(auto j = i + 1u; j < 90u; ++j) {
+                if(edge_dist(mt)) { g.add_edge(i, j); }
+            }
+        }
+
+        const auto sets = independent_set_cover(g);
+        DenseGraph covered{90u};
+
+        for(const auto& set : sets) {
+            ASSERT_TRUE(std::is_sorted(set.begin(), set.end()));
+
+            for(auto i = 0u; i < set.size(); ++i) {
+                for(auto j = i + 1u; j < set.size(); ++j) {
+                    ASSERT_FALSE(g.are_connected(set[i], set[j]));
+                    covered.add_edge(set[i], set[j]);
+                }
+            }
+
+            // Maximality: any other vertex is adjacent to some vertex of the set.
+            for(auto v = 0u; v < 90u; ++v) {
+                if(std::find(set.begin(), set.end(), v) != set.end()) { continue; }
+
+                ASSERT_TRUE(std::any_of(set.begin(), set.end(), [&] (std::size_t w) { return g.are_connected(v, w); }));
+            }
+        }
+
+        ASSERT_EQ(covered.number_of_edges(), g.complement().number_of_edges());
+        ASSERT_LT(sets.size(), g.complement().number_of_edges());
+    }
+
     class MwisTest : public ::testing::Test {
     public:
         boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS> u;
@@ -518,6 +728,25 @@ namespace {
         ASSERT_EQ(as::mwis::mwis(weights, u), w);
     }
 
+    TEST_F(MwisTest, MaxWeightStableSetIsFoundOnDenseGraph) {
+        const std::vector<std::size_t> w = { 1u, 3u };
+
+        ASSERT_EQ(as::mwis::mwis(weights, as::graph::DenseGraph::from_boost(u)), w);
+    }
+
+    TEST_F(MwisTest, SolverIsReused) {
+        as::mwis::MwisSolver solver{as::graph::DenseGraph::from_boost(u)};
+
+        ASSERT_EQ(solver.solve(weights), (std::vector<std::size_t>{1u, 3u}));
+        ASSERT_EQ(solver.solve({3u, 1u, 3u, 1u}), (std::vector<std::size_t>{0u, 2u}));
+
+        solver.set_edges(as::graph::DenseGraph{4u});
+        ASSERT_EQ(solver.solve(weights), (std::vector<std::size_t>{0u, 1u, 2u, 3u}));
+
+        solver.set_edges(u);
+        ASSERT_EQ(solver.solve(weights), (std::vector<std::size_t>{1u, 3u}));
+    }
+
     TEST(NumericTest, ValueFitting) {
         using namespace as::numeric;
 
@@ -541,6 +770,75 @@ namespace {
         ASSERT_FLOAT_EQ(euclidean_distance(p2, p3), euclidean_distance(p3, p2));
     }
 
+    TEST(RandomTest, Xoshiro) {
+        using namespace as::rnd;
+
+        // Reference outputs from the authors' implementation, with state {1, 2, 3, 4}.
+        Xoshiro256StarStar prng{std::array<std::uint64_t, 4u>{1u, 2u, 3u, 4u}};
+
+        ASSERT_EQ(prng(), 11520u);
+        ASSERT_EQ(prng(), 0u);
+        ASSERT_EQ(prng(), 1509978240u);
+        ASSERT_EQ(prng(), 1215971899390074240u);
+
+        Xoshiro256StarStar a{42u}, b{42u};
+        ASSERT_EQ(a, b);
+
+        const auto child = a.split();
+        ASSERT_EQ(child, b);
+        ASSERT_NE(a, b);
+
+        b.jump();
+        ASSERT_EQ(a, b);
+
+        const auto streams = make_streams(3u, 42u);
+        ASSERT_EQ(streams[0], child);
+        ASSERT_EQ(streams[1], a);
+
+        std::uniform_int_distribution<int> dist{1, 6};
+        auto prng_copy = streams[2];
+        const auto roll = dist(prng_copy);
+        ASSERT_GE(roll, 1);
+        ASSERT_LE(roll, 6);
+    }
+
+    TEST(RandomTest, SampleInPlaceAndIndices) {
+        using namespace as::rnd;
+
+        Xoshiro256StarStar prng{7u};
+        std::vector<int> v(10);
+        std::iota(v.begin(), v.end(), 0);
+
+        ASSERT_EQ(sample_in_place(v, 4u, prng), 4u);
+        ASSERT_EQ(std::set<int>(v.begin(), v.end()).size(), 10u);
+        ASSERT_EQ(sample_in_place(v, 20u, prng), 10u);
+
+        const auto indices = sample_indices(1000000u, 5u, prng);
+        ASSERT_EQ(indices.size(), 5u);
+        ASSERT_EQ(std::set<std::size_t>(indices.begin(), indices.end()).size(), 5u);
+        ASSERT_TRUE(std::all_of(indices.begin(), indices.end(), [] (std::size_t i) { return i < 1000000u; }));
+
+        const auto all = sample_indices(5u, 10u);
+        ASSERT_EQ(std::set<std::size_t>(all.begin(), all.end()), (std::set<std::size_t>{0u, 1u, 2u, 3u, 4u}));
+
+        // Each element should be drawn with probability 3/10.
+        std::vector<std::size_t> counts(10u, 0u);
+
+        for(auto i = 0u; i < 10000u; ++i) {
+            for(const auto j : sample_indices(10u, 3u, prng)) { ++counts[j]; }
+        }
+
+        for(const auto count : counts) {
+            EXPECT_NEAR(count, 3000.0, 200.0);
+        }
+
+        const std::list<int> l = {1, 2, 3, 4, 5, 6};
+        const auto reservoir = reservoir_sample(l.begin(), l.end(), 3u, prng);
+        ASSERT_EQ(reservoir.size(), 3u);
+        ASSERT_EQ(std::set<int>(reservoir.begin(), reservoir.end()).size(), 3u);
+        ASSERT_EQ(reservoir_sample(l.begin(), l.end(), 10u, prng).size(), 6u);
+    }
+
     TEST(RandomTest, SampleEmpty) {
         using namespace as::rnd;
 
@@ -579,6 +877,43 @@ namespace {
         ASSERT_TRUE(std::all_of(r.begin(), r.end(), [](std::size_t n) {return n == 1u;}));
     }
 
+    TEST(RandomTest, RouletteWheelBatch) {
+        using namespace as::rnd;
+
+        const std::vector<double> v = { 0.0, 1.0, 0.0, 3.0, 0.0 };
+        const auto r = roulette_wheel_batch(v, 1000u);
+
+        ASSERT_EQ(r.size(), 1000u);
+        ASSERT_TRUE(std::all_of(r.begin(), r.end(), [](std::size_t n) {return n == 1u || n == 3u;}));
+        ASSERT_GT(std::count(r.begin(), r.end(), 3u), std::count(r.begin(), r.end(), 1u));
+    }
+
+    TEST(RandomTest, WeightedSampler) {
+        using namespace as::rnd;
+
+        auto mt = get_seeded_mt();
+        WeightedSampler<float> sampler{std::vector<float>{ 1.0f, 0.0f, 1.0f }};
+
+        ASSERT_EQ(sampler.size(), 3u);
+        ASSERT_FLOAT_EQ(sampler.total(), 2.0f);
+
+        for(auto i = 0u; i < 100u; ++i) {
+            EXPECT_NE(sampler.sample(mt), 1u);
+        }
+
+        sampler.set_weight(0u, 0.0f);
+        sampler.set_weight(2u, 0.0f);
+        sampler.push_back(0.0f);
+        sampler.set_weight(1u, 5.0f);
+
+        ASSERT_FLOAT_EQ(sampler.total(), 5.0f);
+        ASSERT_FLOAT_EQ(sampler.get_weight(1u), 5.0f);
+
+        for(auto i = 0u; i < 100u; ++i) {
+            EXPECT_EQ(sampler.sample(mt), 1u);
+        }
+    }
+
     TEST(StringTest, LeftTrim) {
         std::string s{"  abc  "};
         as::string::left_trim(s);
@@ -706,6 +1041,375 @@ namespace {
         ASSERT_EQ(numbers, n);
     }
 
+    TEST_F(CombinatorialTest, SubsetEnumGray) {
+        using namespace as::combi;
+
+        std::vector<std::uint64_t> masks;
+        std::vector<std::size_t> flipped;
+        auto gray_visitor = [&] (std::uint64_t mask, std::size_t element) {
+            masks.push_back(mask);
+            flipped.push_back(element);
+        };
+
+        visit_subsets_gray(3u, &gray_visitor);
+
+        ASSERT_EQ(masks, (std::vector<std::uint64_t>{0u, 1u, 3u, 2u, 6u, 7u, 5u, 4u}));
+        ASSERT_EQ(flipped, (std::vector<std::size_t>{no_flipped_element, 0u, 1u, 0u, 2u, 0u, 1u, 0u}));
+
+        // Incremental sum of the elements, with early termination.
+        std::size_t sum = 0u, visited = 0u;
+        std::uint64_t last_mask = 0u;
+        auto sum_visitor = [&] (std::uint64_t mask, std::size_t element) -> bool {
+            if(element != no_flipped_element) {
+                sum = (mask & (std::uint64_t{1u} << element)) ? sum + element : sum - element;
+            }
+
+            ++visited;
+            last_mask = mask;
+            return sum >= 9u;
+        };
+
+        visit_subsets_gray(5u, &sum_visitor);
+
+        std::size_t last_sum = 0u;
+
+        for(auto i = 0u; i < 5u; ++i) {
+            if(last_mask & (std::uint64_t{1u} << i)) { last_sum += i; }
+        }
+
+        ASSERT_GE(sum, 9u);
+        ASSERT_EQ(sum, last_sum);
+        ASSERT_LT(visited, 32u);
+
+        masks.clear();
+        visit_subsets_gray_with_prefix(4u, 1u, 1u, &gray_visitor);
+
+        ASSERT_EQ(masks, (std::vector<std::uint64_t>{8u, 9u, 11u, 10u, 14u, 15u, 13u, 12u}));
+    }
+
+    TEST_F(CombinatorialTest, SubsetEnumGrayParallel) {
+        using namespace as::combi;
+
+        as::concurrency::ThreadPool pool{3u};
+        std::vector<std::uint64_t> counts(64u, 0u), mask_sums(64u, 0u);
+
+        const auto n_ranges = visit_subsets_gray_parallel(16u, pool, [&] (std::size_t range) {
+            return [&, range] (std::uint64_t mask, std::size_t) {
+                ++counts[range];
+                mask_sums[range] += mask;
+            };
+        });
+
+        ASSERT_EQ(n_ranges, 16u);
+        ASSERT_EQ(std::accumulate(counts.begin(), counts.end(), std::uint64_t{0u}), 1u << 16u);
+        ASSERT_EQ(std::accumulate(mask_sums.begin(), mask_sums.end(), std::uint64_t{0u}), (std::uint64_t{1u} << 15u) * ((1u << 16u) - 1u));
+    }
+
+    TEST_F(CombinatorialTest, SubsetsOfSize) {
+        using namespace as::combi;
+
+        std::vector<std::uint64_t> masks;
+        auto size_visitor = [&] (std::uint64_t mask) { masks.push_back(mask); };
+
+        visit_subsets_of_size(4u, 2u, &size_visitor);
+        ASSERT_EQ(masks, (std::vector<std::uint64_t>{3u, 5u, 6u, 9u, 10u, 12u}));
+
+        masks.clear();
+        visit_subsets_of_size(3u, 0u, &size_visitor);
+        ASSERT_EQ(masks, (std::vector<std::uint64_t>{0u}));
+
+        masks.clear();
+        visit_subsets_of_size(64u, 64u, &size_visitor);
+        ASSERT_EQ(masks, (std::vector<std::uint64_t>{~std::uint64_t{0u}}));
+
+        std::size_t count = 0u;
+        auto count_visitor = [&] (std::uint64_t mask) -> bool {
+            EXPECT_EQ(__builtin_popcountll(mask), 3);
+            return ++count == 100u;
+        };
+
+        visit_subsets_of_size(64u, 3u, &count_visitor);
+        ASSERT_EQ(count, 100u);
+
+        count = 0u;
+        visit_subsets_of_size(10u, 3u, &count_visitor);
+        ASSERT_EQ(count, 100u);
+    }
+
+    TEST(TsplibTest, ParseTsplib) {
+        using namespace as::tsplib::detail;
+
+        const auto tsp = parse_tsplib(
+            "NAME : test\r\n"
+            "COMMENT: A comment: with colons\r\n"
+            "DIMENSION :3\r\n"
+            "NODE_COORD_SECTION\r\n"
+            " 1 0.5 +2\r\n"
+            "2 1e1   -3.25\r\n"
+            "3 4 5\r\n"
+            "EOF\r\n"
+        );
+
+        ASSERT_EQ(tsp.get_specification<std::string>("NAME"), "test");
+        ASSERT_EQ(tsp.get_specification<std::string>("COMMENT"), "A comment: with colons");
+        ASSERT_EQ(tsp.get_specification<std::size_t>("DIMENSION"), 3u);
+        ASSERT_EQ(tsp.get_data("NODE_COORD_SECTION"), (std::vector<float>{1.0f, 0.5f, 2.0f, 2.0f, 10.0f, -3.25f, 3.0f, 4.0f, 5.0f}));
+        ASSERT_THROW(parse_tsplib("NAME : test\n1 2 3\n"), std::runtime_error);
+        ASSERT_THROW(read_tsplib_file("../test/tsplib/no_such_file.tsp"), std::runtime_error);
+    }
+
+    TEST(TsplibTest, DistanceMatrixStorage) {
+        using namespace as::tsplib;
+
+        const TSPInstance full("../test/tsplib/pr10.tsp");
+        const TSPInstance triangular("../test/tsplib/pr10.tsp", DistanceStorage::UPPER_TRIANGULAR);
+        const auto& matrix = full.get_distance_matrix();
+
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(matrix.data()) % DistanceMatrix::alignment, 0u);
+        ASSERT_EQ(matrix.stride() * sizeof(float) % DistanceMatrix::alignment, 0u);
+        ASSERT_EQ(triangular.get_distance_matrix().get_storage(), DistanceStorage::UPPER_TRIANGULAR);
+
+        for(auto i = 0u; i < full.number_of_vertices(); ++i) {
+            ASSERT_EQ(full.get_distance(i, i), 0.0f);
+
+            for(auto j = 0u; j < full.number_of_vertices(); ++j) {
+                ASSERT_EQ(full.get_distance(i, j), full.get_distance(j, i));
+                ASSERT_EQ(full.get_distance(i, j), triangular.get_distance(i, j));
+                ASSERT_EQ(full.get_distance(i, j), full.get_distance_unchecked(i, j));
+                ASSERT_EQ(full.get_distance(i, j), matrix.data()[i * matrix.stride() + j]);
+            }
+        }
+
+        ASSERT_THROW(full.get_distance(0u, full.number_of_vertices()), std::out_of_range);
+    }
+
+    TEST(TsplibTest, LazyDistances) {
+        using namespace as::tsplib;
+
+        const TSPInstance full("../test/tsplib/pr10.tsp");
+        const TSPInstance lazy("../test/tsplib/pr10.tsp", DistanceStorage::LAZY);
+        const TSPInstance cached("../test/tsplib/pr10.tsp", DistanceStorage::LAZY, 8u);
+
+        ASSERT_EQ(lazy.get_distance_storage(), DistanceStorage::LAZY);
+        ASSERT_EQ(lazy.get_distance_matrix().size(), 0u);
+
+        // Go through the pairs twice, so that the second time we hit the cache.
+        for(auto k = 0u; k < 2u; ++k) {
+            for(auto i = 0u; i < full.number_of_vertices(); ++i) {
+                for(auto j = 0u; j < full.number_of_vertices(); ++j) {
+                    ASSERT_EQ(full.get_distance(i, j), lazy.get_distance(i, j));
+                    ASSERT_EQ(full.get_distance(i, j), cached.get_distance(i, j));
+                    ASSERT_EQ(full.get_distance(i, j), cached.get_distance(j, i));
+                }
+            }
+        }
+
+        ASSERT_THROW(lazy.get_distance(0u, lazy.number_of_vertices()), std::out_of_range);
+    }
+
+    TEST(TsplibTest, BatchedDistanceKernels) {
+        using namespace as::tsplib::detail;
+
+        // Enough points, on the scale of TSPLIB instances, to hit the rare cases where
+        // rounding differs, e.g. because of fused multiply-adds.
+        std::mt19937 mt{42u};
+        std::vector<float> xs(4099u), ys(4099u), out(4099u);
+
+        for(const auto range : {200.0f, 10'000.0f}) {
+            std::uniform_real_distribution<float> coord{-range, range};
+
+            for(auto i = 0u; i < xs.size(); ++i) {
+                xs[i] = coord(mt);
+                ys[i] = coord(mt);
+            }
+
+            for(const auto type : {DistanceType::EUC_2D, DistanceType::CEIL_2D, DistanceType::GEO, DistanceType::ATT}) {
+                for(auto source = 0u; source < 16u; ++source) {
+                    compute_distances_to(type, xs[source], ys[source], xs.data(), ys.data(), xs.size(), out.data());
+
+                    for(auto i = 0u; i < xs.size(); ++i) {
+                        ASSERT_EQ(out[i], compute_distance(type, xs[source], ys[source], xs[i], ys[i]));
+                    }
+                }
+            }
+        }
+
+        // Exact halves are rounded away from zero, as in std::round.
+        const float half_xs[] = {0.0f, 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f};
+        const float half_ys[] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        float half_out[9];
+
+        compute_distances_to(DistanceType::EUC_2D, 0.0f, 0.0f, half_xs, half_ys, 9u, half_out);
+
+        for(auto i = 1u; i < 9u; ++i) {
+            ASSERT_EQ(half_out[i], static_cast<float>(i));
+        }
+    }
+
+    TEST(TsplibTest, DistancesFrom) {
+        using namespace as::tsplib;
+
+        const TSPInstance full("../test/tsplib/pr10.tsp");
+        const TSPInstance triangular("../test/tsplib/pr10.tsp", DistanceStorage::UPPER_TRIANGULAR);
+        const TSPInstance lazy("../test/tsplib/pr10.tsp", DistanceStorage::LAZY);
+        const auto n = full.number_of_vertices();
+        std::vector<float> from_full(n), from_triangular(n), from_lazy(n);
+
+        for(auto i = 0u; i < n; ++i) {
+            full.get_distances_from(i, from_full.data());
+            triangular.get_distances_from(i, from_triangular.data());
+            lazy.get_distances_from(i, from_lazy.data());
+
+            for(auto j = 0u; j < n; ++j) {
+                ASSERT_EQ(from_full[j], full.get_distance(i, j));
+                ASSERT_EQ(from_triangular[j], full.get_distance(i, j));
+                ASSERT_EQ(from_lazy[j], full.get_distance(i, j));
+            }
+        }
+    }
+
+    TEST(TsplibTest, BinaryInstance) {
+        using namespace as::tsplib;
+
+        for(const auto storage : {DistanceStorage::FULL, DistanceStorage::UPPER_TRIANGULAR, DistanceStorage::LAZY}) {
+            const TSPInstance text("../test/tsplib/pr10.tsp", storage);
+            text.write_binary("pr10.tspbin");
+
+            const TSPInstance binary("pr10.tspbin");
+            const auto copy = binary;
+
+            ASSERT_EQ(binary.get_distance_storage(), storage);
+            ASSERT_EQ(binary.get_distance_matrix().is_mapped(), storage != DistanceStorage::LAZY);
+            ASSERT_EQ(binary.number_of_vertices(), text.number_of_vertices());
+            ASSERT_EQ(binary.get_raw_specification<std::string>("NAME"), text.get_raw_specification<std::string>("NAME"));
+            ASSERT_EQ(binary.get_raw_data("NODE_COORD_SECTION"), text.get_raw_data("NODE_COORD_SECTION"));
+
+            for(auto i = 0u; i < text.number_of_vertices(); ++i) {
+                ASSERT_EQ(binary.get_coordinates(i).x, text.get_coordinates(i).x);
+                ASSERT_EQ(binary.get_original_coordinates(i).y, text.get_original_coordinates(i).y);
+
+                for(auto j = 0u; j < text.number_of_vertices(); ++j) {
+                    ASSERT_EQ(binary.get_distance(i, j), text.get_distance(i, j));
+                    ASSERT_EQ(copy.get_distance(i, j), text.get_distance(i, j));
+                }
+            }
+        }
+
+        std::remove("pr10.tspbin");
+    }
+
+    TEST(TsplibTest, CorruptedBinaryInstance) {
+        using namespace as::tsplib;
+
+        const TSPInstance text("../test/tsplib/pr10.tsp", DistanceStorage::FULL);
+        text.write_binary("pr10.tspbin");
+
+        std::string bytes;
+        {
+            std::ifstream ifs("pr10.tspbin", std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{});
+        }
+
+        auto load = [] (const std::string& contents) {
+            std::ofstream{"corrupted.tspbin", std::ios::binary | std::ios::trunc} << contents;
+            const TSPInstance instance("corrupted.tspbin");
+        };
+
+        detail::BinaryInstanceHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+
+        // Truncated in the middle of the distance matrix.
+        EXPECT_THROW(load(bytes.substr(0u, header.distances_offset + 16u)), std::runtime_error);
+
+        // A stride which would make rows overlap, with a matching count.
+        auto tampered = header;
+        tampered.row_stride = 0u;
+        tampered.distances_count = 0u;
+        auto tampered_bytes = bytes;
+        std::memcpy(tampered_bytes.data(), &tampered, sizeof(tampered));
+        EXPECT_THROW(load(tampered_bytes), std::runtime_error);
+
+        // Fewer coordinates than vertices.
+        tampered = header;
+        tampered.original_coordinates_count = header.n_vertices - 1u;
+        std::memcpy(tampered_bytes.data(), &tampered, sizeof(tampered));
+        EXPECT_THROW(load(tampered_bytes), std::runtime_error);
+
+        // A garbage count of coordinates.
+        tampered = header;
+        tampered.coordinates_count = std::numeric_limits<std::uint64_t>::max() / 2u;
+        std::memcpy(tampered_bytes.data(), &tampered, sizeof(tampered));
+        EXPECT_THROW(load(tampered_bytes), std::runtime_error);
+
+        load(bytes);
+
+        std::remove("pr10.tspbin");
+        std::remove("corrupted.tspbin");
+    }
+
+    TEST(TsplibTest, NeighbourLists) {
+        using namespace as::tsplib;
+
+        {
+            std::mt19937 mt{7u};
+            std::uniform_real_distribution<float> coord{0.0f, 1000.0f};
+            std::ofstream ofs("neighbours.tsp");
+
+            ofs << "NAME : neighbours\nTYPE : TSP\nDIMENSION : 300\nEDGE_WEIGHT_TYPE : EUC_2D\nNODE_COORD_SECTION\n";
+
+            // Half of the vertices are in a dense cluster.
+            for(auto i = 0u; i < 300u; ++i) {
+                const auto scale = (i % 2u == 0u) ? 1.0f : 0.05f;
+                ofs << (i + 1u) << " " << scale * coord(mt) << " " << scale * coord(mt) << "\n";
+            }
+
+            ofs << "EOF\n";
+        }
+
+        TSPInstance instance("neighbours.tsp");
+        instance.build_neighbour_lists(8u);
+
+        ASSERT_EQ(instance.number_of_neighbours(), 8u);
+
+        for(auto v = 0u; v < instance.number_of_vertices(); ++v) {
+            std::vector<float> distances, expected;
+
+            for(auto w : instance.get_neighbours(v)) {
+                ASSERT_NE(w, v);
+                distances.push_back(instance.get_distance(v, w));
+            }
+
+            for(auto w = 0u; w < instance.number_of_vertices(); ++w) {
+                if(w != v) { expected.push_back(instance.get_distance(v, w)); }
+            }
+
+            std::sort(expected.begin(), expected.end());
+            expected.resize(8u);
+
+            ASSERT_EQ(distances, expected);
+        }
+
+        instance.build_neighbour_lists(8u, NeighbourSelection::QUADRANT);
+
+        for(auto v = 0u; v < instance.number_of_vertices(); ++v) {
+            const auto neighbours = instance.get_neighbours(v);
+            const std::set<std::size_t> unique(neighbours.begin(), neighbours.end());
+
+            ASSERT_EQ(unique.size(), 8u);
+            ASSERT_EQ(unique.count(v), 0u);
+            ASSERT_TRUE(std::is_sorted(neighbours.begin(), neighbours.end(), [&] (auto w1, auto w2) {
+                return instance.get_distance(v, w1) < instance.get_distance(v, w2);
+            }));
+        }
+
+        std::remove("neighbours.tsp");
+
+        TSPInstance small("../test/tsplib/pr10.tsp");
+        small.build_neighbour_lists(100u);
+
+        ASSERT_EQ(small.number_of_neighbours(), 9u);
+    }
+
     TEST(TspTest, SolvePr10) {
         using namespace as::tsplib;
         using namespace as::tsp;
@@ -726,6 +1430,162 @@ namespace {
         ASSERT_EQ(discorde_v, mtz_v);
     }
 
+    TEST(TspTest, HeldKarp) {
+        using namespace as::tsplib;
+        using namespace as::tsp;
+
+        const TSPInstance instance("../test/tsplib/pr10.tsp");
+
+        for(const auto& nodes : std::vector<std::vector<std::uint32_t>>{{0u, 2u, 4u, 6u}, {1u, 2u, 3u, 5u, 7u, 8u, 9u}, {0u, 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u}}) {
+            const auto tour = held_karp_solve_tsp(instance, nodes);
+
+            ASSERT_EQ(std::set<std::uint32_t>(tour.begin(), tour.end()), std::set<std::uint32_t>(nodes.begin(), nodes.end()));
+
+            // Brute force over all tours starting with the first node.
+            auto permutation = nodes;
+            auto best_cost = std::numeric_limits<float>::max();
+
+            do {
+                best_cost = std::min(best_cost, tour_cost(instance, permutation));
+            } while(std::next_permutation(permutation.begin() + 1, permutation.end()));
+
+            ASSERT_FLOAT_EQ(tour_cost(instance, tour), best_cost);
+        }
+
+        ASSERT_THROW(held_karp_solve_tsp(instance, std::vector<std::uint32_t>(held_karp_max_nodes + 1u, 0u)), std::invalid_argument);
+    }
+
+    TEST(TspTest, LocalSearch) {
+        using namespace as::tsplib;
+        using namespace as::tsp;
+
+        const TSPInstance instance("../test/tsplib/pr10.tsp");
+        std::vector<std::uint32_t> nodes(instance.number_of_vertices());
+        std::iota(nodes.begin(), nodes.end(), 0u);
+
+        const auto tour = local_search_solve_tsp(instance, nodes, 4u);
+        const auto optimal = held_karp_solve_tsp(instance, nodes);
+
+        ASSERT_EQ(std::set<std::uint32_t>(tour.begin(), tour.end()), std::set<std::uint32_t>(nodes.begin(), nodes.end()));
+        ASSERT_GE(tour_cost(instance, tour), tour_cost(instance, optimal));
+        ASSERT_LE(tour_cost(instance, tour), 1.1f * tour_cost(instance, optimal));
+        ASSERT_EQ(heuristic_solve_tsp(instance, nodes), optimal);
+    }
+
+    TEST(TspTest, SolveCache) {
+        using namespace as::tsp;
+
+        SolveCache cache{2u};
+
+        ASSERT_FALSE(cache.find({1u, 2u, 3u}));
+
+        cache.insert({3u, 1u, 2u}, {1u, 3u, 2u});
+        cache.insert({4u, 5u, 6u}, {4u, 6u, 5u});
+
+        // The key does not depend on the order of the nodes.
+        ASSERT_EQ(*cache.find({2u, 3u, 1u}), (std::vector<std::uint32_t>{1u, 3u, 2u}));
+
+        // {4, 5, 6} is now the least recently used.
+        cache.insert({7u, 8u, 9u}, {7u, 8u, 9u});
+
+        ASSERT_EQ(cache.size(), 2u);
+        ASSERT_FALSE(cache.find({4u, 5u, 6u}));
+        ASSERT_TRUE(cache.find({7u, 8u, 9u}));
+        ASSERT_TRUE(cache.find({1u, 2u, 3u}));
+
+        const auto statistics = cache.get_statistics();
+
+        ASSERT_EQ(statistics.hits, 3u);
+        ASSERT_EQ(statistics.misses, 2u);
+        ASSERT_EQ(statistics.evictions, 1u);
+    }
+
+    TEST(TspTest, SolveAllConcurrently) {
+        using namespace as::tsplib;
+        using namespace as::tsp;
+
+        const TSPInstance instance("../test/tsplib/pr10.tsp");
+        const std::vector<std::vector<std::uint32_t>> subsets = {
+            {0u, 1u, 2u, 3u, 4u, 5u},
+            {2u, 3u, 5u, 7u, 8u, 9u},
+            {0u, 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 9u},
+            {1u, 3u, 4u, 6u, 8u, 9u},
+            {0u, 2u, 4u, 6u, 7u, 8u, 9u}
+        };
+
+        as::concurrency::ThreadPool pool{4u};
+        SolveCache cache;
+        SolveOptions options;
+        options.cache = &cache;
+
+        const auto tours = solve_all(instance, subsets, pool, options);
+
+        ASSERT_EQ(tours.size(), subsets.size());
+
+        for(auto i = 0u; i < subsets.size(); ++i) {
+            const std::set<std::uint32_t> expected(subsets[i].begin(), subsets[i].end());
+            const std::set<std::uint32_t> visited(tours[i].begin(), tours[i].end());
+
+            ASSERT_EQ(visited, expected);
+            ASSERT_FLOAT_EQ(tour_cost(instance, tours[i]), tour_cost(instance, solve(instance, subsets[i])));
+            ASSERT_EQ(solve(instance, subsets[i], options), tours[i]);
+        }
+
+        ASSERT_EQ(cache.get_statistics().hits, subsets.size());
+    }
+
+    TEST(TspTest, CachedToursStartAtTheFirstNode) {
+        using namespace as::tsplib;
+        using namespace as::tsp;
+
+        const TSPInstance instance("../test/tsplib/pr10.tsp");
+        SolveCache cache;
+        SolveOptions options;
+        options.cache = &cache;
+
+        for(const auto& nodes : std::vector<std::vector<std::uint32_t>>{{0u, 2u, 4u, 6u, 8u, 9u}, {1u, 3u, 5u, 7u}}) {
+            auto reversed = nodes;
+            std::reverse(reversed.begin(), reversed.end());
+
+            const auto first = solve(instance, nodes, options);
+            const auto cached = solve(instance, reversed, options);
+
+            ASSERT_EQ(first.front(), nodes.front());
+            ASSERT_EQ(cached.front(), reversed.front());
+            ASSERT_FLOAT_EQ(tour_cost(instance, cached), tour_cost(instance, first));
+            ASSERT_EQ(std::set<std::uint32_t>(cached.begin(), cached.end()), std::set<std::uint32_t>(nodes.begin(), nodes.end()));
+        }
+
+        ASSERT_EQ(cache.get_statistics().hits, 2u);
+    }
+
+    TEST(TspTest, DiscordeFromSeveralThreads) {
+        using namespace as::tsplib;
+        using namespace as::tsp;
+
+        const TSPInstance instance("../test/tsplib/pr10.tsp");
+        const std::vector<std::vector<std::uint32_t>> subsets = {
+            {0u, 1u, 2u, 3u, 4u, 5u},
+            {2u, 3u, 5u, 7u, 8u, 9u},
+            {0u, 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 9u},
+            {1u, 3u, 4u, 6u, 8u, 9u}
+        };
+
+        as::concurrency::ThreadPool pool{4u};
+        std::vector<std::vector<std::uint32_t>> serialised(subsets.size()), concurrent(subsets.size());
+
+        pool.run(subsets.size(), [&] (std::size_t i) { serialised[i] = discorde_solve_tsp(instance, subsets[i]); });
+
+        allow_concurrent_concorde(true);
+        pool.run(subsets.size(), [&] (std::size_t i) { concurrent[i] = discorde_solve_tsp(instance, subsets[i]); });
+        allow_concurrent_concorde(false);
+
+        for(auto i = 0u; i < subsets.size(); ++i) {
+            ASSERT_FLOAT_EQ(tour_cost(instance, serialised[i]), tour_cost(instance, discorde_solve_tsp(instance, subsets[i])));
+            ASSERT_FLOAT_EQ(tour_cost(instance, concurrent[i]), tour_cost(instance, serialised[i]));
+        }
+    }
+
     TEST(TspTest, SolvePr10Subset) {
         using namespace as::tsplib;
         using namespace as::tsp;
@@ -746,6 +1606,62 @@ namespace {
         ASSERT_TRUE(is_rotation(mask_solution, discorde_solution));
     }
 
+    TEST(TspTest, MtzSolverOnSubsets) {
+        using namespace as::tsplib;
+        using namespace as::tsp;
+
+        const TSPInstance instance("../test/tsplib/pr10.tsp");
+        const std::vector<std::vector<std::uint32_t>> subsets = {
+            {0u, 1u, 5u, 6u, 8u},
+            {2u, 3u, 5u, 7u, 8u, 9u},
+            {0u, 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 9u},
+            {9u, 1u, 5u, 6u}
+        };
+
+        for(const auto formulation : {MtzFormulation::MTZ, MtzFormulation::LAZY_SUBTOUR_ELIMINATION}) {
+            MtzSolver solver{instance, formulation};
+
+            // Solve twice, so that nodes both leave and re-enter the subset.
+            for(auto round = 0u; round < 2u; ++round) {
+                for(const auto& nodes : subsets) {
+                    const auto optimal = held_karp_solve_tsp(instance, nodes);
+                    const auto tour = solver.solve(nodes);
+                    const auto started = solver.solve(nodes, local_search_solve_tsp(instance, nodes));
+
+                    ASSERT_TRUE(std::is_permutation(tour.begin(), tour.end(), nodes.begin()));
+                    ASSERT_EQ(tour[0u], nodes[0u]);
+                    ASSERT_FLOAT_EQ(tour_cost(instance, tour), tour_cost(instance, optimal));
+                    ASSERT_FLOAT_EQ(tour_cost(instance, started), tour_cost(instance, optimal));
+                }
+            }
+
+            ASSERT_THROW(solver.solve({0u, 1u, 2u}, std::vector<std::uint32_t>{0u, 1u, 3u}), std::invalid_argument);
+        }
+    }
+
+    TEST(TspTest, MtzSolverChangesRoot) {
+        using namespace as::tsplib;
+        using namespace as::tsp;
+
+        const TSPInstance instance("../test/tsplib/pr10.tsp");
+        const std::vector<std::uint32_t> subset = {0u, 2u, 4u, 6u, 8u};
+        std::vector<std::uint32_t> all(instance.number_of_vertices());
+        std::iota(all.begin(), all.end(), 0u);
+
+        // The root moves from 0 to 5, a higher index: the arcs between the two roots
+        // must not stay constrained, or the tour on all nodes could not use them.
+        std::rotate(all.begin(), all.begin() + 5, all.end());
+
+        MtzSolver solver{instance};
+        const auto subset_tour = solver.solve(subset);
+        const auto tour = solver.solve(all);
+
+        ASSERT_FLOAT_EQ(tour_cost(instance, subset_tour), tour_cost(instance, held_karp_solve_tsp(instance, subset)));
+        ASSERT_EQ(tour[0u], 5u);
+        ASSERT_FLOAT_EQ(tour_cost(instance, tour), tour_cost(instance, held_karp_solve_tsp(instance, all)));
+        ASSERT_FLOAT_EQ(tour_cost(instance, tour), tour_cost(instance, discorde_solve_tsp(instance)));
+    }
+
     TEST(TspTest, DiscordeCrashesOn4Vertices) {
         using namespace as::tsplib;
         using namespace as::tsp;
@@ -756,6 +1672,121 @@ namespace {
         ASSERT_THROW(discorde_solve_tsp(instance, vertices), std::runtime_error);
     }
 
+    TEST(OplibTest, PrizesAndReachability) {
+        using namespace as::oplib;
+
+        const OPInstance instance("../test/oplib/op10.oplib");
+
+        ASSERT_EQ(instance.get_depot(), 0u);
+        ASSERT_FLOAT_EQ(instance.get_max_travel_time(), 10000.0f);
+        ASSERT_FLOAT_EQ(instance.get_prize(1u), 10.0f);
+        ASSERT_FLOAT_EQ(instance.get_prize(2u), 30.0f);
+        ASSERT_FLOAT_EQ(instance.get_prize(3u), 0.0f);
+        ASSERT_FLOAT_EQ(instance.get_prize(9u), 50.0f);
+
+        std::vector<std::uint32_t> reachable;
+
+        for(auto v = 1u; v < instance.number_of_vertices(); ++v) {
+            const auto round_trip = instance.get_distance(0u, v) + instance.get_distance(v, 0u);
+
+            ASSERT_FLOAT_EQ(instance.get_round_trip_distance(v), round_trip);
+            ASSERT_EQ(instance.is_reachable(v), round_trip <= instance.get_max_travel_time());
+
+            if(instance.is_reachable(v)) { reachable.push_back(v); }
+        }
+
+        const auto& ranking = instance.get_vertices_by_prize_ratio();
+
+        ASSERT_TRUE(std::is_permutation(ranking.begin(), ranking.end(), reachable.begin(), reachable.end()));
+        ASSERT_LT(reachable.size(), instance.number_of_vertices() - 1u);
+
+        for(auto i = 1u; i < ranking.size(); ++i) {
+            ASSERT_GE(instance.get_prize(ranking[i - 1u]) / instance.get_round_trip_distance(ranking[i - 1u]),
+                      instance.get_prize(ranking[i]) / instance.get_round_trip_distance(ranking[i]));
+        }
+
+        const auto from_2 = instance.rank_by_prize_ratio(2u, {1u, 3u, 5u, 6u});
+
+        for(auto i = 1u; i < from_2.size(); ++i) {
+            ASSERT_GE(instance.get_prize(from_2[i - 1u]) / instance.get_distance(2u, from_2[i - 1u]),
+                      instance.get_prize(from_2[i]) / instance.get_distance(2u, from_2[i]));
+        }
+    }
+
+    TEST(OplibTest, OddPrizeSection) {
+        using namespace as::oplib;
+
+        std::ifstream ifs("../test/oplib/op10.oplib");
+        std::string contents{std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{}};
+        const std::string last_prize = "9 60\n";
+
+        // A vertex id without its prize.
+        contents.replace(contents.find(last_prize), last_prize.size(), last_prize + "4\n");
+        std::ofstream{"op10_odd.oplib"} << contents;
+
+        EXPECT_THROW(OPInstance{"op10_odd.oplib"}, std::logic_error);
+        std::remove("op10_odd.oplib");
+    }
+
+    TEST(OplibTest, IncrementalTour) {
+        using namespace as::oplib;
+
+        const OPInstance instance("../test/oplib/op10.oplib");
+
+        auto check = [&] (const OPTour& tour) {
+            float length = 0.0f, prize = 0.0f;
+            const auto& v = tour.vertices();
+
+            for(auto i = 0u; i < v.size(); ++i) {
+                length += instance.get_distance(v[i], v[(i + 1u) % v.size()]);
+                prize += instance.get_prize(v[i]);
+                ASSERT_EQ(*tour.position_of(v[i]), i);
+            }
+
+            ASSERT_NEAR(tour.length(), length, 1e-2f);
+            ASSERT_FLOAT_EQ(tour.prize(), prize);
+            ASSERT_EQ(tour.is_feasible(), length <= instance.get_max_travel_time());
+        };
+
+        // Greedy insertion, by prize ratio, while the tour stays feasible.
+        OPTour tour{instance};
+
+        for(const auto v : instance.get_vertices_by_prize_ratio()) {
+            const auto [index, delta] = tour.best_insertion(v);
+
+            ASSERT_EQ(tour.can_insert(v, index), tour.length() + delta <= instance.get_max_travel_time());
+
+            if(tour.can_insert(v, index)) {
+                tour.insert(v, index);
+                check(tour);
+            }
+        }
+
+        ASSERT_GT(tour.size(), 2u);
+        ASSERT_TRUE(tour.is_feasible());
+        ASSERT_THROW(tour.insert(tour.vertices()[1u], 1u), std::invalid_argument);
+
+        const auto removed = tour.vertices()[1u];
+        const auto before = tour.length();
+        const auto delta = tour.removal_delta(1u);
+
+        tour.remove(1u);
+        check(tour);
+        ASSERT_FALSE(tour.contains(removed));
+        ASSERT_NEAR(tour.length(), before - delta, 1e-2f);
+        ASSERT_THROW(tour.remove(0u), std::out_of_range);
+        ASSERT_THROW(tour.insert(removed, 0u), std::out_of_range);
+        ASSERT_THROW(tour.insert(removed, tour.size() + 1u), std::out_of_range);
+        ASSERT_THROW(tour.insert(instance.number_of_vertices(), 1u), std::out_of_range);
+
+        // Tours given explicitly are rotated to start at the depot.
+        const OPTour explicit_tour{instance, {2u, 6u, 0u, 1u}};
+
+        ASSERT_EQ(explicit_tour.vertices(), (std::vector<std::uint32_t>{0u, 1u, 2u, 6u}));
+        check(explicit_tour);
+        ASSERT_THROW((OPTour{instance, {1u, 2u}}), std::invalid_argument);
+    }
+
     TEST(RepeatTest, Repeats5Times) {
         using namespace as;
 
@@ -766,6 +1797,38 @@ namespace {
 
         ASSERT_EQ(v, expected);
     }
+
+    TEST(ThreadPoolTest, RunsEachTaskOnce) {
+        using namespace as::concurrency;
+
+        ThreadPool pool{4u};
+        std::vector<int> runs(100u, 0);
+
+        ASSERT_EQ(pool.size(), 4u);
+
+        for(auto batch = 0; batch < 3; ++batch) {
+            pool.run(runs.size(), [&] (std::size_t i) { ++runs[i]; });
+        }
+
+        ASSERT_TRUE(std::all_of(runs.begin(), runs.end(), [] (int r) { return r == 3; }));
+    }
+
+    TEST(ThreadPoolTest, RethrowsTaskException) {
+        using namespace as::concurrency;
+
+        ThreadPool pool{2u};
+        std::atomic<int> runs{0};
+
+        ASSERT_THROW(pool.run(10u, [&] (std::size_t i) {
+            ++runs;
+            if(i == 5u) { throw std::runtime_error{"Task failed"}; }
+        }), std::runtime_error);
+
+        ASSERT_EQ(runs, 10);
+
+        pool.run(1u, [&] (std::size_t) { ++runs; });
+        ASSERT_EQ(runs, 11);
+    }
 }
 
 int main(int argc, char** argv) {
@@ -4,10 +4,16 @@
 
 #include "src/alns.h"
 #include "src/alns_acceptance.h"
+#include "src/alns_parallel.h"
 #include "src/random.h"
 
 #include <iostream>
 #include <random>
+#include <limits>
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <thread>
 
 struct Solution {
     float price;
@@ -38,6 +44,98 @@ struct RepairSolution : public as::alns::RepairMethod<Solution> {
     }
 };
 
+// Methods which only draw from the generator they receive, and can
+// thus be called concurrently in batched mode.
+struct ThreadSafeDestroySolution : public as::alns::DestroyMethod<Solution> {
+    void operator()(Solution& sol) override {
+        auto mt = as::rnd::get_seeded_mt();
+        (*this)(sol, mt);
+    }
+
+    void operator()(Solution& sol, std::mt19937& mt) override {
+        sol.price += std::uniform_real_distribution<float>{0.0f, 1.0f}(mt);
+    }
+
+    bool is_thread_safe() const override { return true; }
+};
+
+struct ThreadSafeRepairSolution : public as::alns::RepairMethod<Solution> {
+    void operator()(Solution& sol) override {
+        auto mt = as::rnd::get_seeded_mt();
+        (*this)(sol, mt);
+    }
+
+    void operator()(Solution& sol, std::mt19937& mt) override {
+        sol.price -= std::uniform_real_distribution<float>{0.0f, 1.0f}(mt);
+    }
+
+    bool is_thread_safe() const override { return true; }
+};
+
+// A repair method which gives up as soon as the solution is bound to be rejected.
+struct EarlyRejectRepairSolution : public as::alns::RepairMethod<Solution> {
+    std::uint64_t abandoned = 0u;
+
+    void operator()(Solution& sol) override {
+        auto mt = as::rnd::get_seeded_mt();
+        (*this)(sol, mt);
+    }
+
+    void operator()(Solution& sol, std::mt19937& mt) override {
+        (*this)(sol, mt, std::numeric_limits<float>::infinity());
+    }
+
+    bool operator()(Solution& sol, std::mt19937& mt, float cost_bound) override {
+        // Repair in two steps, each of which can only decrease the price by 0.5.
+        std::uniform_real_distribution<float> dist{0.0f, 0.5f};
+
+        sol.price -= dist(mt);
+        if(sol.price - 0.5f > cost_bound) { ++abandoned; return false; }
+
+        sol.price -= dist(mt);
+        return true;
+    }
+};
+
+// A solution which records the changes applied to it, to avoid
+// full copies at each iteration.
+struct ReversibleSolution {
+    float price;
+    std::vector<float> changes;
+    ReversibleSolution() = default;
+    ReversibleSolution(float price) : price{price} {}
+    float cost() const { return price; }
+    void change_price(float delta) { price += delta; changes.push_back(delta); }
+    void undo() { for(auto delta : changes) { price -= delta; } changes.clear(); }
+    void replay_on(ReversibleSolution& other) const { for(auto delta : changes) { other.change_price(delta); } }
+    void commit() { changes.clear(); }
+};
+
+static_assert(as::alns::is_reversible_solution<ReversibleSolution>::value, "ReversibleSolution should be reversible");
+static_assert(!as::alns::is_reversible_solution<Solution>::value, "Solution should not be reversible");
+
+struct DestroyReversibleSolution : public as::alns::DestroyMethod<ReversibleSolution> {
+    std::mt19937 mt;
+    std::uniform_real_distribution<float> dist;
+
+    DestroyReversibleSolution() : mt{as::rnd::get_seeded_mt()}, dist{0.0f, 1.0f} {}
+
+    void operator()(ReversibleSolution& sol) override {
+        sol.change_price(dist(mt));
+    }
+};
+
+struct RepairReversibleSolution : public as::alns::RepairMethod<ReversibleSolution> {
+    std::mt19937 mt;
+    std::uniform_real_distribution<float> dist;
+
+    RepairReversibleSolution() : mt{as::rnd::get_seeded_mt()}, dist{0.0f, 1.0f} {}
+
+    void operator()(ReversibleSolution& sol) override {
+        sol.change_price(-dist(mt));
+    }
+};
+
 struct SampleVisitor {
     bool on_iteration_end(as::alns::AlgorithmStatus<Solution>& status) {
         if(status.get_iteration_number() % 100 == 0) {
@@ -52,6 +150,20 @@ struct SampleVisitor {
     }
 };
 
+struct QuietVisitor {
+    bool on_iteration_end(as::alns::AlgorithmStatus<Solution>& status) {
+        return status.get_iteration_number() < 10000;
+    }
+};
+
+// A destroy method which takes its time, to make an island slower than the others.
+struct SlowDestroySolution : public DestroySolution {
+    void operator()(Solution& sol) override {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        DestroySolution::operator()(sol);
+    }
+};
+
 int main() {
     const Solution initial{100.0f};
     SampleVisitor visitor;
@@ -72,5 +184,235 @@ int main() {
 
     solver.solve();
 
+    as::alns::ParallelAlgorithmParams parallel_params;
+    parallel_params.n_islands = 4u;
+    parallel_params.migration_interval = 500u;
+    parallel_params.share_scores = true;
+
+    as::alns::ParallelALNSSolver<Solution, as::alns::LinearRecordToRecordTravel<Solution>, QuietVisitor> parallel_solver{params, parallel_params, initial};
+    parallel_solver.set_acceptance_criterion(acceptance);
+    parallel_solver.add_destroy_method([] () { return std::make_unique<DestroySolution>(); });
+    parallel_solver.add_repair_method([] () { return std::make_unique<RepairSolution>(); });
+
+    parallel_solver.solve();
+
+    std::cout << "Parallel (" << parallel_solver.number_of_islands() << " islands)\t";
+    std::cout << parallel_solver.get_best_solution().cost() << "\n";
+
+    // Islands only drawing from their own seeded generators give reproducible runs.
+    auto seeded_parallel_cost = [&] () {
+        as::alns::ParallelALNSSolver<Solution, as::alns::LinearRecordToRecordTravel<Solution>, QuietVisitor> seeded_solver{params, parallel_params, initial};
+        seeded_solver.set_acceptance_criterion(acceptance);
+        seeded_solver.add_destroy_method([] () { return std::make_unique<ThreadSafeDestroySolution>(); });
+        seeded_solver.add_repair_method([] () { return std::make_unique<ThreadSafeRepairSolution>(); });
+        seeded_solver.set_seed(42u);
+        seeded_solver.solve();
+        return seeded_solver.get_best_solution().cost();
+    };
+
+    if(seeded_parallel_cost() != seeded_parallel_cost()) {
+        std::cerr << "Parallel runs with the same seed gave different results\n";
+        return 1;
+    }
+
+    // The time limit is wall-clock time, even for the islands waiting for a slower one.
+    as::alns::AlgorithmParams timed_params;
+    timed_params.time_limit_sec = 0.2f;
+    as::alns::ParallelAlgorithmParams timed_parallel_params;
+    timed_parallel_params.n_islands = 2u;
+    timed_parallel_params.migration_interval = 50u;
+
+    as::alns::ParallelALNSSolver<Solution> timed_solver{timed_params, timed_parallel_params, initial};
+    std::size_t n_destroy_methods = 0u;
+    timed_solver.add_destroy_method([&] () -> std::unique_ptr<as::alns::DestroyMethod<Solution>> {
+        if(n_destroy_methods++ == 0u) { return std::make_unique<SlowDestroySolution>(); }
+        return std::make_unique<DestroySolution>();
+    });
+    timed_solver.add_repair_method([] () { return std::make_unique<RepairSolution>(); });
+
+    const auto timed_start = std::chrono::steady_clock::now();
+    timed_solver.solve();
+    const auto timed_wall_sec = std::chrono::duration<float>(std::chrono::steady_clock::now() - timed_start).count();
+
+    for(auto i = 0u; i < timed_solver.number_of_islands(); ++i) {
+        const auto island_sec = timed_solver.get_island_status(i).get_elapsed_time_sec();
+
+        if(island_sec < timed_params.time_limit_sec || island_sec > timed_wall_sec) {
+            std::cerr << "Island " << i << " measured " << island_sec << " sec, in a run of " << timed_wall_sec << " sec\n";
+            return 1;
+        }
+    }
+
+    as::alns::AlgorithmParams batch_params;
+    batch_params.batch_size = 4u;
+    batch_params.batch_threads = 4u;
+    batch_params.collect_statistics = true;
+    batch_params.statistics_timing_interval = 10u;
+
+    as::alns::ALNSSolver<Solution, as::alns::LinearRecordToRecordTravel<Solution>, QuietVisitor> batch_solver{batch_params, initial};
+    batch_solver.set_acceptance_criterion(acceptance);
+    batch_solver.add_destroy_method(std::make_unique<ThreadSafeDestroySolution>());
+    batch_solver.add_destroy_method(std::make_unique<DestroySolution>());
+    batch_solver.add_repair_method(std::make_unique<ThreadSafeRepairSolution>());
+
+    batch_solver.solve();
+
+    std::cout << "Batched (" << batch_params.batch_size << " candidates)\t";
+    std::cout << batch_solver.get_status().get_best_solution().cost() << "\n";
+    boost::property_tree::write_json(std::cout, batch_solver.get_status().get_statistics().to_ptree());
+
+    static_assert(as::alns::has_rejection_bound<as::alns::LinearRecordToRecordTravel<Solution>, Solution>::value,
+        "LinearRecordToRecordTravel should provide a rejection bound");
+    static_assert(!as::alns::has_rejection_bound<as::alns::DefaultAcceptanceCriterion<Solution>, Solution>::value,
+        "DefaultAcceptanceCriterion should not provide a rejection bound");
+
+    auto early_reject_repair = std::make_unique<EarlyRejectRepairSolution>();
+    const auto& early_reject_repair_ref = *early_reject_repair;
+
+    as::alns::ALNSSolver<Solution, as::alns::LinearRecordToRecordTravel<Solution>> early_reject_solver{params, initial};
+    early_reject_solver.set_acceptance_criterion(acceptance);
+    early_reject_solver.add_destroy_method(std::make_unique<DestroySolution>());
+    early_reject_solver.add_repair_method(std::move(early_reject_repair));
+    early_reject_solver.solve_iterations(10000u);
+
+    std::cout << "Early reject\t" << early_reject_solver.get_status().get_best_solution().cost();
+    std::cout << "\t(" << early_reject_repair_ref.abandoned << " repairs abandoned)\n";
+
+    as::alns::SimulatedAnnealing<Solution> annealing;
+    annealing.iterations_limit = 10000u;
+    as::alns::ALNSSolver<Solution, as::alns::SimulatedAnnealing<Solution>> annealing_solver{params, initial};
+    annealing_solver.set_acceptance_criterion(annealing);
+    annealing_solver.add_destroy_method(std::make_unique<DestroySolution>());
+    annealing_solver.add_repair_method(std::make_unique<RepairSolution>());
+    annealing_solver.solve_iterations(10000u);
+
+    std::cout << "Simulated annealing\t" << annealing_solver.get_status().get_best_solution().cost() << "\n";
+
+    // The annealing thresholds are drawn from a generator seeded by the solver.
+    auto seeded_annealing_cost = [&] () {
+        as::alns::ALNSSolver<Solution, as::alns::SimulatedAnnealing<Solution>> seeded_solver{params, initial};
+        seeded_solver.set_acceptance_criterion(annealing);
+        seeded_solver.add_destroy_method(std::make_unique<ThreadSafeDestroySolution>());
+        seeded_solver.add_repair_method(std::make_unique<ThreadSafeRepairSolution>());
+        seeded_solver.set_seed(42u);
+        seeded_solver.solve_iterations(10000u);
+        return seeded_solver.get_status().get_best_solution().cost();
+    };
+
+    if(seeded_annealing_cost() != seeded_annealing_cost()) {
+        std::cerr << "Simulated annealing runs with the same seed gave different results\n";
+        return 1;
+    }
+
+    as::alns::ThresholdAccepting<Solution> threshold_accepting;
+    threshold_accepting.iterations_limit = 10000u;
+    as::alns::ALNSSolver<Solution, as::alns::ThresholdAccepting<Solution>> threshold_solver{params, initial};
+    threshold_solver.set_acceptance_criterion(threshold_accepting);
+    threshold_solver.add_destroy_method(std::make_unique<DestroySolution>());
+    threshold_solver.add_repair_method(std::make_unique<RepairSolution>());
+    threshold_solver.solve_iterations(10000u);
+
+    std::cout << "Threshold accepting\t" << threshold_solver.get_status().get_best_solution().cost() << "\n";
+
+    as::alns::LateAcceptanceHillClimbing<Solution> late_acceptance;
+    late_acceptance.history_length = 50u;
+    as::alns::ALNSSolver<Solution, as::alns::LateAcceptanceHillClimbing<Solution>> late_acceptance_solver{params, initial};
+    late_acceptance_solver.set_acceptance_criterion(late_acceptance);
+    late_acceptance_solver.add_destroy_method(std::make_unique<DestroySolution>());
+    late_acceptance_solver.add_repair_method(std::make_unique<RepairSolution>());
+    late_acceptance_solver.solve_iterations(10000u);
+
+    std::cout << "Late acceptance\t" << late_acceptance_solver.get_status().get_best_solution().cost() << "\n";
+
+    as::alns::AlgorithmParams limited_params;
+    limited_params.max_iterations = 5000u;
+    limited_params.stagnation_iterations = 1000u;
+    limited_params.clock_interval = 64u;
+
+    as::alns::ALNSSolver<Solution> limited_solver{limited_params, initial};
+    limited_solver.add_destroy_method(std::make_unique<DestroySolution>());
+    limited_solver.add_repair_method(std::make_unique<RepairSolution>());
+    limited_solver.solve();
+
+    const auto reason = limited_solver.get_status().get_termination_reason();
+    std::cout << "Limited\t" << limited_solver.get_status().get_iteration_number() << " iterations\t";
+    std::cout << (reason == as::alns::TerminationReason::ITERATIONS ? "iterations limit" :
+                  reason == as::alns::TerminationReason::STAGNATION ? "stagnation" : "other") << "\n";
+
+    // The acceptance schedule ends when the run does.
+    boost::property_tree::ptree termination_pt;
+    termination_pt.put("termination.max_iterations", 5000u);
+    const as::alns::SimulatedAnnealing<Solution> scheduled_annealing{termination_pt};
+
+    as::alns::ThresholdAccepting<Solution> limited_threshold;
+    limited_threshold.set_limits(limited_params);
+
+    if(scheduled_annealing.iterations_limit != 5000u || limited_threshold.iterations_limit != limited_params.max_iterations) {
+        std::cerr << "The acceptance schedule does not follow the termination limits\n";
+        return 1;
+    }
+
+    const auto write_solution = [] (const Solution& sol) {
+        boost::property_tree::ptree pt;
+        pt.put("price", sol.price);
+        return pt;
+    };
+    const auto read_solution = [] (const boost::property_tree::ptree& pt) {
+        return Solution{pt.get<float>("price")};
+    };
+
+    limited_solver.save_checkpoint("alns_checkpoint.json", write_solution);
+
+    as::alns::ALNSSolver<Solution> resumed_solver{limited_params, initial};
+    resumed_solver.add_destroy_method(std::make_unique<DestroySolution>());
+    resumed_solver.add_repair_method(std::make_unique<RepairSolution>());
+    resumed_solver.load_checkpoint("alns_checkpoint.json", read_solution);
+    std::remove("alns_checkpoint.json");
+
+    if(resumed_solver.get_status().get_iteration_number() != limited_solver.get_status().get_iteration_number() ||
+       resumed_solver.get_status().get_destroy_scores() != limited_solver.get_status().get_destroy_scores()) {
+        std::cerr << "The resumed solver does not match the checkpointed one\n";
+        return 1;
+    }
+    std::cout << "Resumed\t" << resumed_solver.get_status().get_best_cost() << "\n";
+
+    limited_solver.reset_status(initial, true);
+    limited_solver.solve();
+    std::cout << "Warm-started\t" << limited_solver.get_status().get_iteration_number() << " iterations\t";
+    std::cout << limited_solver.get_status().get_best_cost() << "\n";
+
+    as::alns::LinearRecordToRecordTravel<ReversibleSolution> reversible_acceptance;
+    reversible_acceptance.main_termination_criterion = as::alns::MainTerminationCriterion::ITERATIONS;
+    reversible_acceptance.iterations_limit = 10000;
+    reversible_acceptance.start_threshold = 0.05;
+    reversible_acceptance.end_threshold = 0.0;
+
+    as::alns::ALNSSolver<ReversibleSolution, as::alns::LinearRecordToRecordTravel<ReversibleSolution>> reversible_solver{params, ReversibleSolution{100.0f}};
+    reversible_solver.set_acceptance_criterion(reversible_acceptance);
+    reversible_solver.add_destroy_method(std::make_unique<DestroyReversibleSolution>());
+    reversible_solver.add_repair_method(std::make_unique<RepairReversibleSolution>());
+
+    reversible_solver.solve_iterations(10000u);
+
+    std::cout << "Reversible\t" << reversible_solver.get_status().get_best_solution().cost() << "\n";
+    std::cout << "Reversible current\t" << reversible_solver.get_status().get_current_solution().cost() << "\n";
+
+    // Batched candidates are re-synchronised with the current solution by undoing their changes.
+    as::alns::ALNSSolver<ReversibleSolution, as::alns::LinearRecordToRecordTravel<ReversibleSolution>> reversible_batch_solver{batch_params, ReversibleSolution{100.0f}};
+    reversible_batch_solver.set_acceptance_criterion(reversible_acceptance);
+    reversible_batch_solver.add_destroy_method(std::make_unique<DestroyReversibleSolution>());
+    reversible_batch_solver.add_repair_method(std::make_unique<RepairReversibleSolution>());
+
+    reversible_batch_solver.solve_iterations(10000u);
+
+    auto& reversible_batch_status = reversible_batch_solver.get_status();
+    std::cout << "Reversible batched\t" << reversible_batch_status.get_best_solution().cost() << "\n";
+
+    if(std::abs(reversible_batch_status.get_current_solution().cost() - reversible_batch_status.get_current_cost()) > 1e-3f ||
+       reversible_batch_status.get_best_cost() >= 100.0f) {
+        std::cerr << "The batched reversible solver lost track of the current solution\n";
+        return 1;
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -8,6 +8,10 @@
 #include "src/tsplib.h"
 #include "src/geometry.h"
 
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
 namespace {
     class GraphPlotTest : public ::testing::Test {
     public:
@@ -63,6 +67,60 @@ namespace {
 
         // Manual test! Open the graph files and check them! :-D
     }
+
+    TEST_F(GraphPlotTest, AnimatesTours) {
+        using namespace as::graph::plot;
+        using Image = cimg_library::CImg<unsigned char>;
+        using Animator = TourAnimator<Graph>;
+
+        const std::vector<Animator::Tour> tours = {
+            { 0u, 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 9u },
+            { 0u, 2u, 1u, 3u, 4u, 5u, 6u, 7u, 8u, 9u },
+            { 0u, 2u, 1u, 3u, 4u, 9u, 8u, 7u, 6u, 5u },
+            { 5u, 1u, 7u }
+        };
+
+        const auto base = PlottedGraph{graph}.set_width(500).set_height(500).hide_edges();
+        std::vector<Image> frames;
+        std::vector<std::size_t> frame_numbers;
+
+        // The sink runs on the rendering thread: only record what it gets, and check it after finish().
+        Animator animator{base, [&] (const Image& img, std::size_t frame_n) {
+            frame_numbers.push_back(frame_n);
+            frames.push_back(img);
+        }, tours.size()};
+
+        for(const auto& tour : tours) {
+            animator.add_frame(tour);
+        }
+
+        animator.finish();
+
+        ASSERT_EQ(animator.number_of_frames(), tours.size());
+        ASSERT_EQ(animator.number_of_dropped_frames(), 0u);
+        ASSERT_EQ(frame_numbers, (std::vector<std::size_t>{0u, 1u, 2u, 3u}));
+
+        // Frames redrawn incrementally are the same as frames drawn from scratch.
+        for(auto i = 0u; i < tours.size(); ++i) {
+            Image reference;
+            Animator single{base, [&] (const Image& img, std::size_t) { reference = img; }};
+
+            single.add_frame(tours[i]);
+            single.finish();
+
+            ASSERT_TRUE(frames[i] == reference);
+        }
+
+        {
+            Animator png_animator{base, Animator::png_files("tour")};
+
+            png_animator.add_frame(tours[0u]);
+            png_animator.finish();
+        }
+
+        ASSERT_TRUE(std::ifstream{"tour-000000.png"}.good());
+        ASSERT_EQ(std::remove("tour-000000.png"), 0);
+    }
 }
 
 int main(int argc, char** argv) {